@@ -48,12 +48,13 @@ typedef unsigned long long AccType;
 typedef std::vector<patid_t> PidList;    // pattern ID list
 typedef std::vector<vidType> VertexList; // vertex ID list
 typedef std::vector<std::vector<vidType>> VertexLists;
-typedef std::unordered_map<vlabel_t, int> nlf_map;
 
 #define ADJ_SIZE_THREASHOLD 1024
 #define FULL_MASK 0xffffffff
 #define MAX_PATTERN_SIZE 8
 #define MAX_FSM_PATTERN_SIZE 5
+#define NLF_SIMD_WIDTH 8         // NLF histogram width is padded to a multiple of this
+#define NLF_DENSE_MAX_LABELS 32  // use a dense NLF histogram when the label alphabet fits in this
 #define NUM_BUCKETS 128
 #define BUCKET_SIZE 1024
 #define DIVIDE_INTO(x,y) ((x + y - 1)/y)
@@ -82,10 +83,15 @@ const float epsilon2 = 0.001;
 #define kDistInf UINT_MAX/2
 
 // CF parameters
-const int K = 20;        // dimension of the latent vector (number of features)
+const int K = 20;        // dimension of the latent vector (number of features) of the GPU solvers
+extern int latent_dim;   // dimension of the latent vector, K by default
 extern float cf_epsilon; // convergence condition
 extern score_t lambda;   // regularization_factor
 extern score_t step;     // learning rate in the algorithm
+// defaults of lambda and step, defined by the sgd solver linked in: blocked SGD on CPU, or
+// batch gradient descent on GPU, which needs a much smaller step
+extern const score_t default_lambda;
+extern const score_t default_step;
 extern int max_iters;    // maximum number of iterations
 
 // Compression
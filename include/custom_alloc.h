@@ -55,3 +55,30 @@ static void map_file(std::string fname, T *& pointer, size_t length) {
   close(inf);
 }
 
+
+// create (or truncate) the file with room for 'length' elements and map it for writing
+template<typename T>
+static void create_mapped_file(std::string fname, T *& pointer, size_t length) {
+  int outf = open(fname.c_str(), O_RDWR | O_CREAT | O_TRUNC, (mode_t)0644);
+  if (-1 == outf) {
+    std::cerr << "Failed to create file: " << fname << "\n";
+    exit(1);
+  }
+  pointer = NULL;
+  if (length > 0) {
+    if (ftruncate(outf, sizeof(T) * length) == -1) {
+      std::cerr << "Failed to resize file: " << fname << "\n";
+      exit(1);
+    }
+    pointer = (T*)mmap(nullptr, sizeof(T) * length, PROT_READ | PROT_WRITE, MAP_SHARED, outf, 0);
+    assert(pointer != MAP_FAILED);
+  }
+  close(outf);
+}
+
+// unmap a file mapped by map_file() or create_mapped_file(); the changes of a file
+// mapped for writing are flushed by the kernel
+template<typename T>
+static void unmap_file(T *pointer, size_t length) {
+  if (pointer && length > 0) munmap((void*)pointer, sizeof(T) * length);
+}
@@ -0,0 +1,80 @@
+// Mutable graph with batched edge insertion and deletion
+#pragma once
+#include "VertexSet.h"
+
+typedef std::vector<std::pair<vidType,vidType>> EdgeBatch;
+
+// sort a batch by (src, dst) in parallel and remove duplicates; optionally add the reverse edges first
+void sort_edge_batch(EdgeBatch &batch, bool symmetrize);
+
+// Size-class allocator for adjacency blocks: a block of size class c holds 2^c vertices.
+// Small blocks are carved from slabs and recycled through per-class free lists;
+// large blocks go directly to the heap. Each thread uses its own allocator.
+class BlockAllocator {
+public:
+  static const int MIN_CLASS = 2;    // smallest block: 4 vertices
+  static const int MAX_SLAB_CLASS = 16; // larger blocks are not carved from slabs
+  static int size_class(vidType n) { // smallest class with capacity >= n
+    int c = MIN_CLASS;
+    while ((size_t(1) << c) < n) c++;
+    return c;
+  }
+  BlockAllocator() : free_lists_(MAX_SLAB_CLASS+1), slab_ptr_(NULL), slab_left_(0), slab_bytes_(0) {}
+  ~BlockAllocator();
+  vidType* allocate(int c);
+  void deallocate(vidType *p, int c);
+  size_t get_memory() const { return slab_bytes_; } // bytes held in slabs
+private:
+  std::vector<std::vector<vidType*>> free_lists_;
+  std::vector<vidType*> slabs_;
+  vidType *slab_ptr_;
+  size_t slab_left_, slab_bytes_;
+};
+
+// Per-vertex blocked adjacency: the neighbor list of each vertex is kept sorted and
+// contiguous in a block of its size class, so N(v) is a VertexSet over the block
+// and the kernels written for GraphT run on it unchanged. Updates are applied in
+// batches, in parallel over the distinct source vertices of the batch.
+class DynamicGraph {
+public:
+  DynamicGraph(vidType nv, bool directed = false);
+  ~DynamicGraph();
+  DynamicGraph(const DynamicGraph &)=delete;
+  DynamicGraph& operator=(const DynamicGraph &)=delete;
+
+  // insert/delete a batch of edges; for an undirected graph each edge is applied in both directions;
+  // self-loops, redundant and (for deletion) missing edges are ignored; returns the number of edges changed
+  eidType insert_edges(const EdgeBatch &batch);
+  eidType delete_edges(const EdgeBatch &batch);
+
+  // same interface as GraphT
+  vidType V() const { return n_vertices; }
+  eidType E() const { return n_edges; }
+  bool is_directed() const { return is_directed_; }
+  bool has_reverse_graph() const { return !is_directed_; }
+  vidType get_degree(vidType v) const { return degrees[v]; }
+  vidType N(vidType v, vidType n) const { return adj_lists[v][n]; } // get the n-th neighbor of v
+  VertexSet N(vidType v) const { return VertexSet(adj_lists[v], degrees[v], v); }
+  VertexSet out_neigh(vidType v, vidType off = 0) const { return VertexSet(adj_lists[v] + off, degrees[v], v); }
+  VertexSet in_neigh(vidType v) const { assert(!is_directed_); return N(v); }
+  bool is_connected(vidType v, vidType u) const;
+  vidType get_max_degree() const;
+  size_t get_memory() const; // bytes used by the adjacency blocks and the vertex arrays
+
+private:
+  bool is_directed_;
+  vidType n_vertices;
+  eidType n_edges;
+  std::vector<vidType*> adj_lists;  // adjacency block of each vertex
+  std::vector<vidType> degrees;     // number of neighbors of each vertex
+  std::vector<int8_t> size_classes; // size class of the block of each vertex, -1 if none
+  std::vector<BlockAllocator> allocators; // one per thread
+  EdgeBatch sorted;                 // the batch being applied, sorted (reused across batches)
+  std::vector<size_t> group_begins; // the range of each source vertex in sorted
+
+  BlockAllocator& local_allocator() { return allocators[omp_get_thread_num()]; }
+  void resize_block(vidType v, vidType capacity);
+  // sort and deduplicate the batch into sorted, and find the range of each source vertex
+  void prepare_batch(const EdgeBatch &batch);
+};
+
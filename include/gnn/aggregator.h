@@ -2,6 +2,8 @@
 #include "lgraph.h"
 #include "optimizer.h"
 #include "math_functions.hh"
+#include "fused_spmm.h"
+#include "model_file.h"
 //typedef LearningGraph Graph;
 
 //template<bool learnable=false>
@@ -11,6 +13,8 @@ public:
   //void aggregate(Graph& g, const float* in, float* out);
   //void d_aggregate(Graph& g, const float* in, float* out);
   void set_vlen(int vlen) { length = vlen; }
+  // the learnable parameters (alpha_l, alpha_r), empty if none
+  void save_weights(std::ostream &out) { write_tensor(out, vec_t()); write_tensor(out, vec_t()); }
 
 protected:
   int n;
@@ -20,13 +24,18 @@ protected:
 
 class GCN_Aggregator : public aggregator {
 public:
-  GCN_Aggregator() : aggregator() {}
+  GCN_Aggregator() : aggregator(), partial_sums(NULL), arena_size(0) {}
+  ~GCN_Aggregator() { free(partial_sums); }
   void init(int length, int nv, int ne = 0, float lr = 0.01, float drop_rate = 0.);
   void aggregate(int len, Graph& g, const float* in, float* out);
   void d_aggregate(int len, Graph& g, const float* feat_in, const float* grad_in, float* grad_out);
 protected:
-  std::vector<std::vector<vec_t>> partial_sums;
-  vec_t& get_partial_feats(int bid, index_t vid);
+  // CSR segmenting: one aligned arena holding, for each subgraph, a feature tile of partial
+  // sums per destination; it is reused by all the calls and all the feature tiles
+  float* partial_sums;
+  size_t arena_size;                // in floats
+  std::vector<size_t> arena_offsets; // first float of each subgraph
+  void alloc_partial_sums(Graph& g);
   void update_all(int len, Graph& g, const float* in, float* out);
   void update_all_blocked(int len, Graph& g, const float* in, float* out);
 };
@@ -46,6 +55,7 @@ public:
   void aggregate(int len, Graph& g, const float* in, float* out);
   void d_aggregate(int len, Graph& g, const float* feat_in, const float* grad_in, float* grad_out);
   void update_weights(optimizer *opt); // update alpha
+  void save_weights(std::ostream &out) { write_tensor(out, alpha_l); write_tensor(out, alpha_r); }
 
 private:
   // GAT parameters
@@ -56,14 +66,10 @@ private:
   vec_t alpha_r;           // parameters to learn (H x 1), only used for GAT
   vec_t alpha_lgrad;       // gradients for updating alpha (GAT only)
   vec_t alpha_rgrad;       // gradients for updating alpha (GAT only)
-  vec_t scores;            // un-normalized scores
-  vec_t temp_scores;       // un-normalized scores
-  vec_t scores_grad;       // gradients of un-normalized scores
-  vec_t norm_scores;       // normalized scores
-  vec_t norm_scores_grad;  // gradients of normalized scores
-  vec_t trans_norm_scores; // transposed normalized scores
+  vec_t el;                // alpha_l * in[v] of each vertex v
+  vec_t er;                // alpha_r * in[v] of each vertex v
+  vec_t lse;               // log-sum-exp of the scores of the edges of each vertex
   optimizer *alpha_opt;    // optimizer for alpha
-  std::vector<mask_t> attn_masks;  // masks for attention dropout.
 
   // GPU related
   float* d_alpha_l;           // parameters to learn (H x 1), only used for GAT
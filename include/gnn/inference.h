@@ -0,0 +1,94 @@
+// Inference-only GNN serving: the trained parameters of a model (see model_file.h) are applied
+// layer by layer, and all the hidden features live in two ping-pong buffers, instead of the
+// per-layer buffers of the training Model. The input features, which dominate the memory, may
+// be stored in reduced precision and are decoded one tile of rows at a time.
+// The logits of a set of target vertices are computed over their k-hop receptive field only
+// (k = number of graph_conv layers), with layer l computing only the vertices within k-1-l hops.
+#pragma once
+#include "lgraph.h"
+#include "model_file.h"
+
+#define INFER_TILE_ROWS 2048 // rows of the input features decoded at once
+
+enum class feat_precision { FP32, BF16, INT8 };
+
+// The input features, in float, bfloat16 (round to nearest even), or int8 with a scale per row.
+class FeatureStore {
+public:
+  FeatureStore() : num_rows(0), length(0), precision(feat_precision::FP32) {}
+  void init(vec_t &&feats, int len, feat_precision p); // takes over the features
+  int get_length() const { return length; }
+  size_t bytes() const;
+  // the rows ids[begin:begin+n) (or [begin:begin+n) if ids is NULL), decoded into out
+  void decode_rows(size_t begin, size_t n, const index_t *ids, float *out) const;
+
+private:
+  size_t num_rows;
+  int length;
+  feat_precision precision;
+  vec_t fp32;
+  std::vector<uint16_t> bf16;
+  std::vector<int8_t> int8;
+  vec_t scales; // of the int8 rows
+};
+
+class InferenceEngine {
+public:
+  InferenceEngine(std::string model_file); // loads the parameters
+  gnn_arch get_arch() { return arch; }
+  int get_num_layers() { return num_layers; }
+  int get_num_classes() { return num_cls; }
+  int get_input_length() { return dim_init; }
+  bool get_is_sigmoid() { return is_sigmoid; }
+  // the graph, with the self-loops the model was trained with (all but SAGE)
+  void set_graph(Graph *g);
+  void set_features(vec_t &&feats, feat_precision p) { features.init(std::move(feats), dim_init, p); }
+  // out[v*num_cls : (v+1)*num_cls) = the logits of each vertex v, over the full graph
+  void infer_all(float *out);
+  // out[i*num_cls : (i+1)*num_cls) = the logits of targets[i], over their receptive field;
+  // the memory used is that of the receptive field, so the caller bounds it by the batch size
+  void infer(const std::vector<index_t> &targets, float *out);
+  size_t get_feature_bytes() const { return features.bytes(); }
+  size_t get_buffer_bytes() const;
+  size_t get_field_size() const { return field.size(); } // of the last infer()
+
+private:
+  gnn_arch arch;
+  int num_layers;
+  int dim_init;
+  int dim_hid;
+  int num_cls;
+  bool use_l2norm;
+  bool use_dense;
+  bool is_sigmoid;
+  std::vector<int> dims;            // dims[l] x dims[l+1] is the shape of layer l
+  std::vector<vec_t> W_neigh;       // of each layer
+  std::vector<vec_t> W_self;        // of each layer; SAGE only
+  std::vector<vec_t> bias;          // of each layer; empty if none
+  std::vector<vec_t> alpha_l;       // of each layer; GAT only
+  std::vector<vec_t> alpha_r;       // of each layer; GAT only
+  vec_t dense_weight, dense_bias;
+  Graph *graph;
+  FeatureStore features;
+  vec_t norms;                      // of each vertex of the graph, 1/sqrt(degree) for GCN
+
+  // the receptive field of the last infer(): the vertices by hop (the targets first), with
+  // hop_ends[h] the number of vertices within h hops, and the CSR of the vertices within
+  // k-1 hops over the local ids
+  std::vector<index_t> field;       // global id of each local id
+  std::vector<index_t> hop_ends;
+  std::vector<index_t> rowptr, colidx;
+  std::vector<index_t> local_id;    // of each vertex of the graph; invalid if not in the field
+  vec_t field_norms;
+
+  vec_t buffers[2];                 // the ping-pong feature buffers
+  vec_t tile;                       // decoded input features, or aggregated rows (SAGE)
+  vec_t el, er;                     // attention scores (GAT)
+
+  void build_field(const std::vector<index_t> &targets);
+  float *propagate(const std::vector<index_t> &ends, const index_t *ids, const index_t *rows,
+                   const index_t *cols, const float *vnorms);
+  void transform(int l, size_t n, const float *in, const index_t *ids, const float *W, float *out, bool accum);
+  void aggregate(int l, int len, size_t n, size_t n_in, const index_t *rows, const index_t *cols,
+                 const float *vnorms, const float *in, float *out);
+};
@@ -9,13 +9,13 @@
 #define CUDA_HOSTDEV
 #endif
 
-#ifdef ENABLE_GPU
-#define SUBGRAPH_SIZE (1024*128)
-#define RANGE_WIDTH (512)
-#else
-#define SUBGRAPH_SIZE (1024*128)
-#define RANGE_WIDTH (512)
-#endif
+// CSR segmenting on CPU: the subgraph size and the range width are chosen from the cache
+// sizes, so that the feature tiles of the source vertices of a subgraph stay in the LLC and
+// the output tiles of a range stay in L2 during the merge
+#define MAX_FEAT_TILE (64)   // max number of features aggregated per pass
+#define MIN_SUBGRAPH_SIZE (1024*16)
+#define MIN_RANGE_WIDTH (64)
+#define LLC_SLICE (2*1024*1024) // bytes of LLC per thread at most
 
 class LearningGraph {
 protected:
@@ -33,6 +33,7 @@ protected:
   index_t *colidx_;
   vdata_t *vertex_data_;
   edata_t *edge_data_;
+  LearningGraph *transposed_;    // the transpose if not symmetric (e.g., a sampled block), or NULL
 
   // for GPU
   index_t* d_rowptr_;
@@ -45,14 +46,15 @@ protected:
   // for CSR segmenting
   int num_subgraphs;
   int num_ranges;
-  index_t* nvs_of_subgraphs;     // nv of each subgraph
-  index_t* nes_of_subgraphs;     // ne of each subgraph
-  index_t** rowptr_blocked;
-  index_t** colidx_blocked;
-  index_t** idx_map;
-  index_t** range_indices;
-  float*** partial_sums;
-  edata_t** edge_data_blocked;
+  index_t subgraph_size;         // number of source vertices in each subgraph
+  index_t range_width;           // number of destination vertices in each range
+  int feat_tile;                 // number of features aggregated per pass
+  std::vector<index_t> nvs_of_subgraphs;  // nv of each subgraph
+  std::vector<index_t> nes_of_subgraphs;  // ne of each subgraph
+  std::vector<std::vector<index_t>> rowptr_blocked;
+  std::vector<std::vector<index_t>> colidx_blocked;
+  std::vector<std::vector<index_t>> idx_map;        // local to global id of the destinations
+  std::vector<std::vector<index_t>> range_indices;  // first local id of each range
 
 public:
   typedef size_t iterator;
@@ -62,9 +64,10 @@ public:
         vdata_size(0), edata_size(0),
         gpu_vsize(0), gpu_esize(0),
         rowptr_(NULL), colidx_(NULL),
-        vertex_data_(NULL), edge_data_(NULL),
+        vertex_data_(NULL), edge_data_(NULL), transposed_(NULL),
         d_rowptr_(NULL), d_colidx_(NULL),
-        d_vertex_data_(NULL), d_edge_data_(NULL), d_trans_edge_data_(NULL) {}
+        d_vertex_data_(NULL), d_edge_data_(NULL), d_trans_edge_data_(NULL),
+        num_subgraphs(0), num_ranges(0), subgraph_size(0), range_width(0), feat_tile(0) {}
   LearningGraph() : LearningGraph(false) {}
   //~LearningGraph() { dealloc(); }
   void alloc_on_device();
@@ -77,6 +80,9 @@ public:
   index_t get_max_degree() { return max_degree; }
   //void init(index_t nv, index_t ne) { num_vertices_ = nv; num_edges_ = ne; }
   index_t get_degree(index_t v) { return rowptr_[v + 1] - rowptr_[v]; }
+  // the graph the backward passes aggregate over: the graph itself if it is symmetric
+  LearningGraph& transposed() { return transposed_ ? *transposed_ : *this; }
+  void set_transposed(LearningGraph* g) { transposed_ = g; }
   iterator begin() const { return iterator(0); }
   iterator end() const { return iterator(num_vertices_); }
   //LearningGraph* generate_masked_graph(mask_t* masks);
@@ -125,15 +131,16 @@ public:
 
   // CSR segmenting
   void segmenting(size_t len);
-  void update_feat_len(size_t len);
+  int get_feat_tile() { return feat_tile; }
+  index_t get_range_width() { return range_width; }
   index_t get_subgraph_size(int bid) { return nvs_of_subgraphs[bid]; }
   index_t get_subgraph_nedges(int bid) { return nes_of_subgraphs[bid]; }
   int get_num_subgraphs() { return num_subgraphs; }
   int get_num_ranges() { return num_ranges; }
   index_t edge_dst_blocked(int bid, index_t eid) { return colidx_blocked[bid][eid]; }
+  const index_t* edge_dst_blocked_ptr(int bid) { return colidx_blocked[bid].data(); }
   index_t edge_begin_blocked(int bid, index_t vid) { return rowptr_blocked[bid][vid]; }
   index_t edge_end_blocked(int bid, index_t vid) { return rowptr_blocked[bid][vid+1]; }
-  float* get_partial_feats(int bid, index_t vid) { return partial_sums[bid][vid]; }
   index_t get_global_vid(int bid, index_t vid) { return idx_map[bid][vid]; }
   index_t get_range_index(int bid, index_t vid) { return range_indices[bid][vid]; }
 
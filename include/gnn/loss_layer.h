@@ -12,6 +12,7 @@ class loss_layer {
     virtual void forward(size_t begin, size_t end, mask_t* masks) {}
     virtual void backward(size_t begin, size_t end, mask_t* masks, float* grad_out) {}
     void set_labels_ptr(label_t* ptr) { labels = ptr; }
+    label_t* get_labels_ptr() { return labels; }
     virtual acc_t get_prediction_loss(size_t begin, size_t end, size_t count, mask_t* masks) { return 0; }
     void set_netphase(net_phase phase) { phase_ = phase; }
     void update_dim_size(int sz);
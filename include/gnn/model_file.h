@@ -0,0 +1,34 @@
+// The file of the trained parameters of a model, written by Model::save_model and read by the
+// InferenceEngine. It is a header followed by, for each graph_conv layer, the tensors W_neigh,
+// W_self, bias, alpha_l and alpha_r, then by the weight and the bias of the dense layer.
+// A tensor is its number of floats (8 bytes) followed by the floats; a tensor a layer does not
+// have (e.g., W_self of GCN) is empty.
+#pragma once
+#include "global.h"
+
+#define MODEL_FILE_MAGIC 0x314c444f4d4e4e47ULL // "GNNMODL1"
+
+struct ModelHeader {
+  uint64_t magic;
+  int32_t arch;        // gnn_arch
+  int32_t num_layers;  // graph_conv layers
+  int32_t dim_init;    // input feature vector length
+  int32_t dim_hid;     // hidden feature vector length
+  int32_t num_cls;     // number of classes
+  int32_t use_l2norm;
+  int32_t use_dense;
+  int32_t is_sigmoid;
+};
+
+inline void write_tensor(std::ostream &out, const vec_t &t) {
+  uint64_t n = t.size();
+  out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+  if (n > 0) out.write(reinterpret_cast<const char*>(&t[0]), n * sizeof(float));
+}
+
+inline void read_tensor(std::istream &in, vec_t &t) {
+  uint64_t n = 0;
+  in.read(reinterpret_cast<char*>(&n), sizeof(n));
+  t.resize(n);
+  if (n > 0) in.read(reinterpret_cast<char*>(&t[0]), n * sizeof(float));
+}
@@ -0,0 +1,84 @@
+// GraphSAGE-style layer-wise neighbor sampling for mini-batch training
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include "lgraph.h"
+#include "philox.h"
+
+#define NUM_SAMPLE_WORKERS 2 // producer threads
+#define PREFETCH_BATCHES 4   // mini-batches prepared ahead of the one being trained
+
+// a CSR over the local ids of a batch, with sorted rows
+struct BlockCSR {
+  std::vector<index_t> rowptr;
+  std::vector<index_t> colidx;
+};
+
+struct MiniBatch {
+  int64_t id;                       // epoch * batches_per_epoch + batch
+  index_t num_seeds;                // the seeds are the first vertices
+  std::vector<index_t> vertices;    // global id of each local id
+  std::vector<BlockCSR> blocks;     // of each layer: its dst vertices to their sampled neighbors
+  std::vector<BlockCSR> trans_blocks; // the transpose of each block, for the backward pass
+  vec_t feats;                      // input features by local id
+  std::vector<label_t> labels;      // labels by local id
+};
+
+// The seeds of a batch are the dst vertices of the last layer; layer l samples up to
+// fanouts[l] neighbors (without replacement; all of them if fanouts[l] <= 0) of each of its
+// dst vertices, and these become the dst vertices of layer l-1. The training vertices are
+// shuffled at each epoch.
+// Layer l aggregates over its own block: the edges sampled for it (plus a self-loop on each
+// of its dst vertices if requested), over all the vertices of the batch, so that the rows of
+// the other vertices are empty. The blocks are not symmetric, so each one comes with its
+// transpose, which the backward pass of the layer aggregates over.
+// A pool of producer threads samples the batches, builds the graph and gathers the features
+// and labels of up to PREFETCH_BATCHES batches ahead, while the current batch is trained.
+// The random choices depend only on (seed, batch, layer, vertex, draw): the batches are the
+// same for any number of workers or threads.
+class NeighborSampler {
+public:
+  NeighborSampler(Graph* g, std::vector<index_t> train_nodes, std::vector<int> fanouts,
+                  index_t batch_size, int num_epochs, const float* feats, int feat_len,
+                  const label_t* labels, int label_len, bool selfloop,
+                  int num_workers = NUM_SAMPLE_WORKERS, int depth = PREFETCH_BATCHES, uint64_t seed = 1);
+  ~NeighborSampler();
+  int64_t batches_per_epoch() const { return num_batches; }
+  void start();                  // launch the producers
+  MiniBatch* next();             // wait for the next batch, in order
+  void release(MiniBatch* batch); // the batch is trained; its buffers can be reused
+
+private:
+  Graph* graph;
+  std::vector<index_t> nodes;    // training vertices
+  std::vector<int> fanouts;
+  index_t batch_size;
+  int64_t num_batches;           // per epoch
+  int64_t total_batches;
+  const float* feats;
+  int feat_len;
+  const label_t* labels;
+  int label_len;
+  bool selfloop;
+  int num_workers;
+  int depth;
+  Philox rng;
+
+  std::vector<MiniBatch> slots;  // batch b is prepared in slot b % depth
+  std::vector<int64_t> slot_next; // the batch each slot may hold next
+  std::vector<bool> slot_ready;
+  int64_t next_consumed;
+  std::atomic<int64_t> next_produced;
+  bool stopping;
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::vector<std::thread> workers;
+
+  void produce();
+  void sample(int64_t id, std::vector<index_t>& local_ids, std::vector<std::vector<index_t>>& edges,
+              MiniBatch& batch);
+  void build_block(index_t nv, index_t num_dst, const std::vector<index_t>& edges, BlockCSR& block,
+                   BlockCSR& trans_block);
+};
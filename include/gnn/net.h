@@ -4,6 +4,7 @@
 #include "dense_layer.h"
 #include "loss_layer.h"
 #include "sampler.h"
+#include "neighbor_sampler.h"
 
 template <typename gconv_layer>
 class Model {
@@ -22,10 +23,15 @@ class Model {
     void set_netphases(net_phase phase);
     void print_layers_info();
     void transfer_data_to_device();
+    void save_model(); // the trained parameters, into model_file (see model_file.h)
+    std::string get_model_file() { return model_file; }
     // for subgraph sampling
     void subgraph_sampling(int curEpoch, int &num_subg_remain);
     void construct_subg_feats(size_t m, const mask_t* masks);
     void construct_subg_labels(size_t m, const mask_t* masks);
+    // for mini-batch training with neighbor sampling
+    acc_t train_minibatches(optimizer* opt, acc_t& loss, double& fw_time, double& bw_time);
+    void use_minibatch(MiniBatch* batch);
     Graph* get_subg_ptr(int id) { return subgs[id]; }
   private:
     int num_epochs;   // number of epochs
@@ -37,6 +43,9 @@ class Model {
     int dim_hid;      // hidden feature vector length
     int subg_size;    // maximum subgraph size when enabling subgraph sampling
     int subg_nv;      // actual subgraph size when enabling subgraph sampling
+    int subg_nseeds;  // number of vertices of the subgraph (the first ones) in the loss
+    int batch_size;   // mini-batch size when enabling neighbor sampling
+    std::vector<int> fanouts; // number of neighbors sampled in each layer
     int val_interval; // validation performed every interval
     float feat_drop;  // dropout rate for features
     float score_drop; // dropout rate for scores
@@ -48,6 +57,7 @@ class Model {
     Graph* training_graph;     // training graph: masked by training vertex set
     std::string dataset_name;  // dataset name: citeseer, cora, pubmed, reddit, etc
     bool is_sigmoid;           // single-class (softmax) or multi-class (sigmoid)
+    std::string model_file;    // where to save the trained parameters; empty if not saved
     bool use_dense;            // add a Dense layer or not
     bool use_l2norm;           // add a L2norm layer or not
     bool use_gpu;              // use GPU or CPU-only
@@ -80,5 +90,10 @@ class Model {
     std::vector<Graph*> subgs; // subgraphs when enabling subgraph sampling
     label_t* d_labels_subg;    // labels for subgraph on device
     float* d_feats_subg;       // input features for subgraph on device
+
+    // for neighbor sampling
+    NeighborSampler* loader;
+    std::vector<Graph*> blocks;       // block of each layer of the current mini-batch
+    std::vector<Graph*> trans_blocks; // and its transpose
 };
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "lgraph.h"
+#include "philox.h"
 #define ETA 1.5          // length factor of DB in sampling
 #define SAMPLE_CLIP 3000 // clip degree in sampling
 
@@ -14,16 +15,9 @@ protected:
   Graph* full_graph;  // the original full graph
   Graph* masked_graph; // sampling set masked original graph; typically to the training set
   std::vector<index_t> trainingNodes; //! List of training nodes; 
+  Philox rng;         // the draws for a given seed form the stream 'seed'
 
-  //! Reindex a graph to only contain those in the vertex set
-  void reindexSubgraph(VertexSet& keptVertices, Graph& g, Graph& reindexed);
-  //! Given a graph, return a graph with edges to unmasked vertices removed in mg
-  template <typename GraphTy, typename SubgraphTy = Graph>
-  void getMaskedGraph(index_t n, mask_t* masks, GraphTy* g, SubgraphTy* sub);
-  //! determine degree of each vertex in a masked graph (given by masks and g)
-  template <typename GraphTy = Graph>
-  void getMaskedDegrees(size_t n, mask_t* masks, GraphTy* g, std::vector<uint32_t>& degrees);
-  void createMasks(size_t n, VertexSet vertices, mask_t* masks) {
+  void createMasks(size_t n, const VertexSet &vertices, mask_t* masks) {
     std::fill(masks, masks + n, 0);
     for (auto v : vertices) masks[v] = 1;
   }
@@ -31,14 +25,6 @@ protected:
   inline unsigned getDegree(Graph* g, index_t v) {
     return g->edge_end_host(v) - g->edge_begin_host(v);
   }
-  inline VertexList reindexVertices(size_t n, VertexSet vertex_set) {
-    VertexList new_ids(n, 0);
-    int vid = 0;
-    for (auto v : vertex_set) {
-      new_ids[v] = vid++; // reindex
-    }
-    return new_ids;
-  }
 
 public:
   Sampler(Graph* g, Graph* tg, mask_t* masks, size_t count) : 
@@ -51,7 +37,7 @@ public:
   }
   ~Sampler() {}
   void generateSubgraph(VertexSet& vertex_set, mask_t* masks, Graph* sg);
-  size_t selectVertices(index_t nv, index_t n, Graph* g, VertexList vertices, VertexSet& vertex_set);
-  size_t select_vertices(index_t n, VertexSet& vertex_set, unsigned seed);
+  size_t selectVertices(index_t nv, index_t n, Graph* g, VertexList vertices, VertexSet& vertex_set, uint64_t seed);
+  size_t select_vertices(index_t n, VertexSet& vertex_set, uint64_t seed);
 };
 
@@ -27,6 +27,7 @@ protected:
   int core_length_;
   int vid_size, eid_size, vlabel_size, elabel_size; // number of bytes for vid, eid, vlabel, elabel
   vidType degree_threshold;
+  int nlf_width_;               // NLF histogram width in dense mode; '0' means sparse (CSR) mode
 
   vidType *edges;               // column indices of CSR format
   eidType *vertices;            // row pointers of CSR format
@@ -41,7 +42,9 @@ protected:
   VertexList sizes;             // neighbor count of each source vertex in the edgelist
   VertexList reverse_index_;    // indices to vertices grouped by vertex label
   eidType *vertices_compressed; // row pointers of the compressed format
-  std::vector<nlf_map> nlf_;    // neighborhood label frequency
+  std::vector<vidType> nlf_counts_;   // NLF counts: nv*nlf_width_ histogram (dense) or one count per (vertex, label) pair (sparse)
+  std::vector<vlabel_t> nlf_labels_;  // NLF labels of each (vertex, label) pair, sorted per vertex (sparse mode only)
+  std::vector<eidType> nlf_offsets_;  // NLF row pointers into nlf_labels_/nlf_counts_ (sparse mode only)
   std::vector<eidType> reverse_index_offsets_; // pointers to each vertex group
   std::vector<uint32_t> edges_compressed;      // compressed edgelist
   std::vector<vidType> degrees; 
@@ -71,6 +74,7 @@ public:
             vid_size(4), eid_size(8),
             vlabel_size(0), elabel_size(0),
             degree_threshold(32),
+            nlf_width_(0),
             edges(NULL), vertices(NULL),
             reverse_edges(NULL), reverse_vertices(NULL),
             vlabels(NULL), elabels(NULL),
@@ -88,7 +92,8 @@ public:
                   bool partitioned = false);
   void load_graph_data(std::string prefix, 
                        bool use_dag = false, bool use_vlabel = false, 
-                       bool use_elabel = false, bool need_reverse = false);
+                       bool use_elabel = false, bool need_reverse = false,
+                       bool global_ids = false); // global_ids: the part of a 1D partition
   void deallocate();
 
   // graph compression
@@ -149,7 +154,8 @@ public:
   bool is_connected(std::vector<vidType> sg) const;  // is the subgraph sg a connected one
   VertexSet out_neigh(vidType v, vidType off = 0) const; // get the outgoing neighbor list of vertex v
   VertexSet in_neigh(vidType v) const;               // get the ingoing neighbor list of vertex v
-  void build_reverse_graph();
+  void build_reverse_graph(bool sorted = true); // in-lists are sorted unless sorted=false
+  void write_reverse_graph(std::string prefix) const; // persist the in-edges next to .edge.bin
   const eidType* rowptr_compressed() const { return vertices_compressed; } // get row pointers array
   const uint32_t* colidx_compressed() const { return &edges_compressed[0]; }    // get column indices array
  
@@ -200,9 +206,15 @@ public:
   void sort_and_clean_neighbors(std::string outfile = ""); // sort the neighbor lists and remove selfloops and redundant edges
   void symmetrize(); // symmetrize a directed graph
   void write_to_file(std::string outfilename, bool v=1, bool e=1, bool vl=0, bool el=0);
+  void write_meta_info(std::string prefix) const; // write the .meta.txt file
   bool is_freq_vertex(vidType v, int minsup);
   vidType get_max_label_frequency() const { return max_label_frequency_; }
-  const nlf_map* getVertexNLF(const vidType id) const { return &nlf_[id]; }
+  bool is_nlf_dense() const { return nlf_width_ > 0; }
+  int get_nlf_width() const { return nlf_width_; }
+  const vidType* getVertexNLF(const vidType v) const { return &nlf_counts_[size_t(v)*nlf_width_]; } // dense mode only
+  vidType get_nlf(vidType v, vlabel_t label) const; // number of neighbors of v with the given label
+  bool nlf_dominates(vidType v, const vidType* query_nlf, int len) const; // N(v) covers a query histogram of length len
+  size_t get_nlf_memory() const;                    // NLF footprint in bytes
   vidType *get_label_freq_ptr() { return labels_frequency_.data(); }
   vidType getLabelsFrequency(vlabel_t label) const { return labels_frequency_.at(label); }
   const vidType* getVerticesByLabel(vlabel_t vl, vidType& count) const {
@@ -0,0 +1,103 @@
+// Copyright 2020 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#pragma once
+#include "graph.h"
+#include "sliding_queue.h"
+#include "platform_atomics.h"
+
+// The kernels of the OpenMP baselines of triangle/, traversal/, link_analysis/ and components/,
+// written over the graph type (V(), E(), N(v), in_neigh(v), get_degree(v)), so that they run
+// on GraphT and on the graphs of dynamic/ (DynamicGraph, GraphSnapshot) alike.
+
+// the triangles of an oriented graph (DAG); if !oriented, of an undirected graph with sorted
+// neighbor lists, each counted once from its largest vertex (a template parameter, so that the
+// edge loop is not branching on it)
+template <bool oriented = true, typename GraphTy>
+uint64_t tc_count(GraphTy &g) {
+  uint64_t counter = 0;
+  #pragma omp parallel for reduction(+ : counter) schedule(dynamic, 1)
+  for (vidType u = 0; u < g.V(); u ++) {
+    auto adj_u = g.N(u);
+    for (auto v : adj_u) {
+      if constexpr (oriented) {
+        counter += (uint64_t)intersection_num(adj_u, g.N(v));
+      } else {
+        if (v >= u) break;
+        counter += (uint64_t)intersection_num(adj_u, g.N(v), v);
+      }
+    }
+  }
+  return counter;
+}
+
+// one level of top-down BFS: expands the frontier in queue into its next window
+template <typename GraphTy>
+void bfs_step(GraphTy &g, vidType *depth, SlidingQueue<vidType> &queue) {
+  #pragma omp parallel
+  {
+    QueueBuffer<vidType> lqueue(queue);
+    #pragma omp for
+    for (auto q_iter = queue.begin(); q_iter < queue.end(); q_iter++) {
+      auto src = *q_iter;
+      for (auto dst : g.N(src)) {
+        //int curr_val = parent[dst];
+        auto curr_val = depth[dst];
+        if (curr_val == MYINFINITY) { // not visited
+          //if (compare_and_swap(parent[dst], curr_val, src)) {
+          if (compare_and_swap(depth[dst], curr_val, depth[src] + 1)) {
+            lqueue.push_back(dst);
+          }
+        }
+      }
+    }
+    lqueue.flush();
+  }
+}
+
+// one pull iteration of PageRank; returns the sum of the score changes
+template <typename GraphTy>
+double pr_step(GraphTy &g, score_t *scores, score_t *outgoing_contrib, score_t base_score) {
+  auto nv = g.V();
+  double error = 0;
+  #pragma omp parallel for
+  for (vidType n = 0; n < nv; n ++)
+    outgoing_contrib[n] = scores[n] / g.get_degree(n);
+  #pragma omp parallel for reduction(+ : error) schedule(dynamic, 64)
+  for (vidType dst = 0; dst < nv; dst ++) {
+    score_t incoming_total = 0;
+    for (auto src : g.in_neigh(dst))
+      incoming_total += outgoing_contrib[src];
+    score_t old_score = scores[dst];
+    scores[dst] = base_score + kDamp * incoming_total;
+    error += fabs(scores[dst] - old_score);
+  }
+  return error;
+}
+
+// one round of hooking and shortcutting of Shiloach-Vishkin; returns whether a component changed
+template <typename GraphTy>
+bool cc_step(GraphTy &g, comp_t *comp) {
+  bool change = false;
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (vidType src = 0; src < g.V(); src ++) {
+    auto comp_src = comp[src];
+    for (auto dst : g.N(src)) {
+      auto comp_dst = comp[dst];
+      if (comp_src == comp_dst) continue;
+      // Hooking condition so lower component ID wins independent of direction
+      int high_comp = comp_src > comp_dst ? comp_src : comp_dst;
+      int low_comp = comp_src + (comp_dst - high_comp);
+      if (high_comp == comp[high_comp]) {
+        change = true;
+        comp[high_comp] = low_comp;
+      }
+    }
+  }
+  #pragma omp parallel for
+  for (vidType n = 0; n < g.V(); n++) {
+    while (comp[n] != comp[comp[n]]) {
+      comp[n] = comp[comp[n]];
+    }
+  }
+  return change;
+}
@@ -10,6 +10,7 @@ typedef std::vector<Edge> EdgeList;
 class PartitionedGraph {
 private:
   Graph *g;
+  OutOfCoreGraph *og;          // graph read through mmap, for the streaming partitioners
   int num_vertex_chunks;       // number of clusters, i.e., vertex subsets or segments
   int num_subgraphs;           // number of subgraphs, i.e., number of partitions
   int num_2D_partitions;       // number of partitions, i.e., square of 'num_vertex_chunks'
@@ -23,25 +24,64 @@ private:
 
   // generate the vertex-induced subgraph from a vertex subset 
   void generate_induced_subgraph(std::vector<int8_t> v_masks, Graph *g, Graph *subg, int i);
+  // read the vertex ranges owned by the subgraphs
+  void read_vertex_ranges(std::string infile);
+  // write the i-th subgraph and its local to global vertex id mapping, if any
+  void write_subgraph(std::string outfile, int i);
 
 public:
   // constructors
-  PartitionedGraph() : num_vertex_chunks(0), num_2D_partitions(0) {}
-  PartitionedGraph(Graph *graph, int nc) : g(graph), num_vertex_chunks(nc) { assert(nc>1); }
+  PartitionedGraph() : g(NULL), og(NULL), num_vertex_chunks(0), num_2D_partitions(0) {}
+  PartitionedGraph(Graph *graph, int nc) : g(graph), og(NULL), num_vertex_chunks(nc) { assert(nc>1); }
+  PartitionedGraph(OutOfCoreGraph *graph, int nc) : g(NULL), og(graph), num_vertex_chunks(nc) { assert(nc>1); }
   PartitionedGraph(Graph *graph, int nc, std::vector<int> cluster_ids);
-  PartitionedGraph(int nc) : num_vertex_chunks(nc) {}
+  PartitionedGraph(int nc) : g(NULL), og(NULL), num_vertex_chunks(nc), num_subgraphs(nc), subgraphs(nc, NULL) {}
 
   Graph* get_subgraph(int i) { return subgraphs[i]; }
   int get_num_subgraphs() { return num_subgraphs; }
   vidType get_local_begin(int i) { return local_begin[i]; } // get local id of the first master vertex for the i-th subgraph
   vidType get_local_end(int i) { return local_end[i]; } // get local id of the last master vertex for the i-th subgraph
+  vidType get_begin_vid(int i) { return begin_vids[i]; } // get global id of the first vertex owned by the i-th subgraph
+  vidType get_end_vid(int i) { return end_vids[i]; } // get global id after the last vertex owned by the i-th subgraph
 
   // naive 1D partitioning, i.e., edge-cut
   void edgecut_partition1D();
 
+  // edge-cut 1D partitioning with vertex ranges balanced by the estimated triangle counting work;
+  // each subgraph keeps only the rows of its own vertices (local row pointers, global column indices)
+  void edgecut_balanced_partition1D();
+
   // edge-cut 1D partitioning; generate a vertex-induced subgraph for each partition
   void edgecut_induced_partition1D();
 
+  // edge-cut 1D partitioning by cluster ids; the subgraph of cluster i is induced by its vertices
+  // and their neighbors, and its master vertices (the vertices of cluster i) come first
+  void edgecut_induced_partition1D(std::vector<int> cluster_ids);
+
+  // multilevel k-way partitioning into 'num_vertex_chunks' clusters (METIS-style): heavy-edge
+  // matching coarsening, greedy graph growing of the coarsest graph, and parallel label
+  // propagation refinement during uncoarsening; returns the cluster id of each vertex
+  std::vector<int> multilevel_partition(double imbalance = 1.03, int seed = 0);
+
+  // print the edge cut, communication volume and balance of a partition
+  void print_partition_quality(const std::vector<int> &cluster_ids);
+
+  // one-pass streaming edge-cut partitioning of the mapped graph into 'num_vertex_chunks' parts,
+  // the vertices placed in id order by the LDG ("ldg") or Fennel ("fennel") heuristic, each part
+  // holding at most imbalance*|V|/k vertices; returns the part id of each vertex
+  std::vector<int> streaming_edgecut_partition(std::string method = "ldg", double imbalance = 1.05);
+
+  // one-pass streaming vertex-cut partitioning of the mapped (symmetric, sorted) graph: the edges
+  // (u,v), u < v, are placed in CSR order by the HDRF ("hdrf") or PowerGraph greedy ("greedy")
+  // heuristic, tracking the replicas of each vertex, each part holding at most imbalance*|E|/k
+  // edges; returns the part id of each such edge
+  std::vector<uint8_t> streaming_vertexcut_partition(std::string method = "hdrf", double lambda = 1.0, double imbalance = 1.05);
+
+  // write the subgraph of each part of a streaming partition, one at a time, and the part id
+  // of each vertex (for a vertex-cut, the part of its master replica)
+  void write_edgecut_partitions(std::string outfile, const std::vector<int> &vertex_parts);
+  void write_vertexcut_partitions(std::string outfile, const std::vector<uint8_t> &edge_parts);
+
   // CSR segmenting
   // Yunming Zhang et. al., Making caches work for graph analytics,
   // 2017 IEEE International Conference on Big Data (Big Data),
@@ -49,14 +89,18 @@ public:
   void csr_segmenting();
 
   // naive 2D partitioning
-  // partition the graph g according to the cluster id of each vertex
-  void partition2D(std::vector<int> cluster_ids);
+  // partition the graph g according to the cluster id of each vertex (given to the constructor too),
+  // and write the partitions to <outfile>-pgraph.{meta.txt,vertex.bin,edge.bin,voffsets.bin,eoffsets.bin}
+  void partition2D(std::string outfile, std::vector<int> cluster_ids);
 
-  // given the ids of clusters, fetch the edges between vertices in these clusters, and form a subgraph in CSR format
-  void fetch_partitions(std::string path, std::vector<int> clusters, Graph *& subg);
+  // given the ids of (distinct) clusters, fetch the edges between vertices in these clusters, and form a subgraph in CSR format;
+  // the partitions are read from the files written by partition2D(infile, ...);
+  // the vertices are numbered cluster by cluster, in the order of 'clusters'
+  void fetch_partitions(std::string infile, std::vector<int> clusters, Graph *& subg);
 
   void print_subgraphs();
   void write_to_file(std::string outfile);
+  void write_partition_ids(std::string outfile, const std::vector<int> &ids); // one int per vertex, in <outfile>-vparts.bin
   void read_from_file(std::string infile);
   void read_from_file(std::string infile, int sg_id);
 };
@@ -0,0 +1,103 @@
+// Subgraph samplers for mini-batch GNN training:
+// GraphSAINT node, edge and random-walk samplers
+// [Hanqing Zeng et. al., GraphSAINT: Graph Sampling Based Inductive Learning Method, ICLR 2020],
+// ClusterGCN over the clusters of a partition
+// [Wei-Lin Chiang et. al., Cluster-GCN: An Efficient Algorithm for Training Deep and Large
+// Graph Convolutional Networks, KDD 2019],
+// and multi-hop neighbor sampling (GraphSAGE).
+
+#pragma once
+
+#include "graph.h"
+#include "utils/philox.h"
+
+// Generate in 'subg' the subgraph of g induced by the vertices v with masks[v] set, by a
+// parallel mask-count-scan-scatter: the local ids are the ranks of the vertices in id order
+// (vertices[i] is the global id of local vertex i), and the neighbor lists keep the order of g.
+// local_ids is scratch space of g.V()+1 elements, reused across calls.
+void induced_subgraph(Graph &g, const std::vector<uint8_t> &masks, VertexList &local_ids,
+                      Graph &subg, VertexList &vertices);
+
+class SubgraphSampler {
+public:
+  SubgraphSampler(Graph *graph, uint64_t seed) : g(graph), rng(seed), masks(graph->V(), 0) {}
+  virtual ~SubgraphSampler() {}
+  virtual std::string name() const = 0;
+  // sample the subgraph 'id' into subg: its random draws form the stream 'id', so the
+  // subgraph is the same for any number of threads
+  void sample(int64_t id, Graph &subg, VertexList &vertices);
+
+protected:
+  Graph *g;
+  Philox rng;
+  std::vector<uint8_t> masks; // the sampled vertices; all clear between samples
+  VertexList local_ids;
+  // set the masks of the vertices of the subgraph 'id'
+  virtual void select(int64_t id) = 0;
+};
+
+// num_roots roots drawn uniformly; hop h draws fanouts[h] neighbors (with replacement) of each
+// vertex first reached at hop h-1
+class KHopSampler : public SubgraphSampler {
+public:
+  KHopSampler(Graph *graph, vidType num_roots, std::vector<int> fanouts, uint64_t seed = 1) :
+    SubgraphSampler(graph, seed), num_roots(num_roots), fanouts(fanouts) {}
+  std::string name() const { return "khop"; }
+protected:
+  vidType num_roots;
+  std::vector<int> fanouts;
+  void select(int64_t id);
+};
+
+// GraphSAINT node sampler: 'budget' vertices drawn with replacement, with probability
+// proportional to their degrees
+class NodeSampler : public SubgraphSampler {
+public:
+  NodeSampler(Graph *graph, vidType budget, uint64_t seed = 1) :
+    SubgraphSampler(graph, seed), budget(budget) {}
+  std::string name() const { return "node"; }
+protected:
+  vidType budget;
+  void select(int64_t id);
+};
+
+// GraphSAINT edge sampler: 'budget' edges (u,v) drawn with replacement, with probability
+// proportional to 1/deg(u) + 1/deg(v), the term of v omitted if v has no out-edge (in a
+// directed graph); the subgraph is induced by their endpoints
+class EdgeSampler : public SubgraphSampler {
+public:
+  EdgeSampler(Graph *graph, eidType budget, uint64_t seed = 1);
+  std::string name() const { return "edge"; }
+protected:
+  eidType budget;
+  std::vector<double> vertex_cdf; // cumulative total probability of the edges of each row
+  std::vector<float> edge_cdf;    // cumulative probability of each edge within its row
+  void select(int64_t id);
+};
+
+// GraphSAINT random-walk sampler: num_roots uniform roots, each followed by a uniform random
+// walk of walk_length steps
+class RandomWalkSampler : public SubgraphSampler {
+public:
+  RandomWalkSampler(Graph *graph, vidType num_roots, int walk_length, uint64_t seed = 1) :
+    SubgraphSampler(graph, seed), num_roots(num_roots), walk_length(walk_length) {}
+  std::string name() const { return "rw"; }
+protected:
+  vidType num_roots;
+  int walk_length;
+  void select(int64_t id);
+};
+
+// ClusterGCN: the subgraph induced by clusters_per_subgraph distinct clusters drawn uniformly,
+// the cluster ids given by a partition (e.g. PartitionedGraph::multilevel_partition())
+class ClusterSampler : public SubgraphSampler {
+public:
+  ClusterSampler(Graph *graph, const std::vector<int> &cluster_ids, int clusters_per_subgraph, uint64_t seed = 1);
+  std::string name() const { return "cluster"; }
+protected:
+  int num_clusters;
+  int clusters_per_subgraph;
+  std::vector<eidType> cluster_offsets; // the vertices of cluster c are
+  VertexList cluster_vertices;          // cluster_vertices[cluster_offsets[c] : cluster_offsets[c+1])
+  void select(int64_t id);
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "optimizer.h"
+#include "model_file.h"
 
 class dense_layer {
  private:
@@ -25,4 +26,5 @@ class dense_layer {
   float* get_feat_in() { return feat_in; }
   float* get_grad_in() { return grad_in; } 
   void update_dim_size(int sz);
+  void save_weights(std::ostream &out); // weight and bias, in the format of model_file.h
 };
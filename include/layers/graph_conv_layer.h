@@ -18,6 +18,7 @@ class graph_conv_layer {
                 << " samples, dims: [" << dim_in << " x " << dim_out << "]\n";
     }
     void update_dim_size(size_t sz); // update number of vertices; useful for subgraph sampling
+    void save_weights(std::ostream &out); // in the format of model_file.h
 
   protected:
     int level_;
@@ -0,0 +1,154 @@
+// Random walks for shallow graph embedding:
+// uniform walks (DeepWalk) [Bryan Perozzi et. al., DeepWalk: Online Learning of Social
+// Representations, KDD 2014], walks weighted by the edge labels, and second-order walks
+// (node2vec) [Aditya Grover et. al., node2vec: Scalable Feature Learning for Networks, KDD 2016]
+// drawn by rejection sampling [Ke Yang et. al., KnightKing: A Fast Distributed Graph Random
+// Walk Engine, SOSP 2019], so that no per-edge-pair transition table is needed.
+
+#pragma once
+
+#include "graph.h"
+#include "utils/philox.h"
+
+// Vose's alias method: turn the n weights into the tables prob/alias, so that the draw
+// k = uniform in [0, n); k if uniform < prob[k], alias[k] otherwise
+// takes O(1) time. small/large are scratch space, reused across calls.
+// If no weight is positive, the draw is uniform.
+template <typename W>
+void build_alias(const W *weights, uint32_t n, float *prob, uint32_t *alias,
+                 std::vector<uint32_t> &small, std::vector<uint32_t> &large) {
+  double sum = 0.;
+  for (uint32_t i = 0; i < n; i++) sum += weights[i] > 0 ? double(weights[i]) : 0.;
+  small.clear();
+  large.clear();
+  for (uint32_t i = 0; i < n; i++) {
+    prob[i] = sum > 0. ? float((weights[i] > 0 ? double(weights[i]) : 0.) * n / sum) : 1.f;
+    alias[i] = i;
+    if (prob[i] < 1.f) small.push_back(i);
+    else large.push_back(i);
+  }
+  while (!small.empty() && !large.empty()) {
+    auto s = small.back(); small.pop_back();
+    auto l = large.back();
+    alias[s] = l;
+    prob[l] -= 1.f - prob[s];
+    if (prob[l] < 1.f) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // the leftovers are 1 up to rounding
+  for (auto i : small) prob[i] = 1.f;
+  for (auto i : large) prob[i] = 1.f;
+}
+
+// a draw from the tables of n entries, given two random words
+inline uint32_t alias_draw(const float *prob, const uint32_t *alias, uint32_t n, uint32_t r0, uint32_t r1) {
+  auto k = philox::to_below(r0, n);
+  return philox::to_float(r1) < prob[k] ? k : alias[k];
+}
+
+// one distribution over [0, n)
+class AliasTable {
+public:
+  AliasTable() {}
+  template <typename W>
+  AliasTable(const W *weights, size_t n) : prob(n), alias(n) {
+    std::vector<uint32_t> small, large;
+    build_alias(weights, n, prob.data(), alias.data(), small, large);
+  }
+  size_t size() const { return prob.size(); }
+  uint32_t draw(uint32_t r0, uint32_t r1) const { return alias_draw(prob.data(), alias.data(), size(), r0, r1); }
+private:
+  std::vector<float> prob;
+  std::vector<uint32_t> alias;
+};
+
+// One table per vertex over its neighbors, weighted by the edge labels of g: the tables of
+// vertex v take the edge range of v in prob/alias (alias holds neighbor positions), so the
+// memory is 8 bytes per edge.
+class EdgeAliasTables {
+public:
+  EdgeAliasTables(Graph &g);
+  // the position in the neighbor list of v of a weighted draw
+  vidType draw(vidType v, uint32_t r0, uint32_t r1) const {
+    auto begin = g.edge_begin(v);
+    return alias_draw(&prob[begin], &alias[begin], g.get_degree(v), r0, r1);
+  }
+private:
+  Graph &g;
+  std::vector<float> prob;
+  std::vector<uint32_t> alias;
+};
+
+// The walk corpus file: a header (8-byte magic, sizeof(vidType) and the maximum walk length
+// as uint32, then the number of walks and of vertices in all walks as uint64), followed by the
+// walks, each a uint32 length and then its vertices. The counts are filled in by close().
+class CorpusWriter {
+public:
+  CorpusWriter(std::string filename, int walk_length);
+  ~CorpusWriter() { close(); }
+  // append n walks: walk i is walks[i*stride : i*stride+lengths[i])
+  void write(const vidType *walks, const uint32_t *lengths, size_t n, size_t stride);
+  void close();
+  uint64_t bytes() const { return num_bytes; }
+  static const uint64_t MAGIC = 0x314b4c4157494147; // "GAIWALK1"
+private:
+  FILE *f;
+  uint32_t max_length;
+  uint64_t num_walks, num_vertices, num_bytes;
+};
+
+// Sequential reader of a corpus file, a batch of walks at a time. The corpus is rejected if
+// a vertex is not below num_vertices, i.e. it was not generated from the graph being used.
+class CorpusReader {
+public:
+  CorpusReader(std::string filename, vidType num_vertices);
+  ~CorpusReader() { fclose(f); }
+  // read up to max_walks walks: walk i is tokens[offsets[i] : offsets[i+1]); returns the
+  // number of walks read, 0 at the end of the corpus
+  size_t read(size_t max_walks, std::vector<vidType> &tokens, std::vector<uint64_t> &offsets);
+  void rewind();
+  int walk_length() const { return max_length; }
+  uint64_t walks() const { return num_walks; }
+  uint64_t vertices() const { return num_vertices; }
+private:
+  FILE *f;
+  std::string name;
+  uint32_t max_length;
+  vidType graph_vertices;
+  uint64_t num_walks, num_vertices;
+};
+
+// Walks of walk_length vertices (fewer if a vertex without neighbors is reached). With p = q = 1
+// a step moves to a uniform neighbor, or a neighbor drawn by its edge label if 'weighted';
+// otherwise the step from v, having come from t, is the first-order proposal x accepted with
+// probability f(x)/max(f): f(x) = 1/p if x == t, 1 if x is a neighbor of t, 1/q otherwise.
+// Walk w draws from the Philox stream w, so the walks do not depend on the number of threads.
+class RandomWalker {
+public:
+  RandomWalker(Graph &g, int walk_length, bool weighted = false, double p = 1., double q = 1., uint64_t seed = 1);
+  ~RandomWalker();
+  bool second_order() const { return p != 1. || q != 1.; }
+  // walk 'id' from 'start' into walk[0 : walk_length); returns the length, and adds the number
+  // of proposals drawn to 'proposals'
+  int walk(uint64_t id, vidType start, vidType *walk, uint64_t &proposals) const;
+  // walks_per_vertex rounds of walks, one from each vertex in a random order per round: walk
+  // r*|V|+i is the walk of round r from the vertex at position i of the order of the round.
+  // The walks are streamed to 'writer' (if not NULL) while the next ones are generated.
+  void run(int walks_per_vertex, CorpusWriter *writer = NULL);
+  uint64_t steps() const { return num_steps; }
+  uint64_t proposals() const { return num_proposals; }
+
+private:
+  Graph &g;
+  int walk_length;
+  double p, q;
+  float max_bias, bias_return, bias_out; // max(f), 1/p and 1/q
+  bool sorted;                           // neighbor lists sorted: test an edge by binary search
+  Philox rng;
+  EdgeAliasTables *tables;
+  uint64_t num_steps, num_proposals;
+  vidType first_order(vidType v, PhiloxStream &stream) const;
+  bool is_neighbor(vidType t, vidType x) const;
+};
@@ -34,6 +34,40 @@ inline void parallel_prefix_sum(const std::vector<InTy>& in, OutTy *prefix) {
   prefix[in.size()] = bulk_prefix[num_blocks];
 }
 
+// in-place exclusive scan: a[0..n) holds counts on entry, a[0..n] holds offsets on exit
+template <typename T = unsigned>
+inline void parallel_prefix_sum_inplace(T *a, size_t n) {
+  const size_t block_size = 1 << 20;
+  const size_t num_blocks = (n + block_size - 1) / block_size;
+  std::vector<T> local_sums(num_blocks);
+  #pragma omp parallel for
+  for (size_t block = 0; block < num_blocks; block ++) {
+    T lsum           = 0;
+    size_t block_end = std::min((block + 1) * block_size, n);
+    for (size_t i = block * block_size; i < block_end; i++)
+      lsum += a[i];
+    local_sums[block] = lsum;
+  }
+  std::vector<T> bulk_prefix(num_blocks + 1);
+  T total = 0;
+  for (size_t block = 0; block < num_blocks; block++) {
+    bulk_prefix[block] = total;
+    total += local_sums[block];
+  }
+  bulk_prefix[num_blocks] = total;
+  #pragma omp parallel for
+  for (size_t block = 0; block < num_blocks; block ++) {
+    T local_total    = bulk_prefix[block];
+    size_t block_end = std::min((block + 1) * block_size, n);
+    for (size_t i = block * block_size; i < block_end; i++) {
+      T count = a[i];
+      a[i] = local_total;
+      local_total += count;
+    }
+  }
+  a[n] = bulk_prefix[num_blocks];
+}
+
 template <typename InTy = unsigned, typename OutTy = unsigned>
 inline void prefix_sum(const std::vector<InTy>& in, OutTy *prefix) {
   OutTy total = 0;
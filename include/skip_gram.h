@@ -0,0 +1,39 @@
+// Skip-gram with negative sampling (SGNS) over a random-walk corpus, the training stage of
+// DeepWalk and node2vec [Tomas Mikolov et. al., Distributed Representations of Words and
+// Phrases and their Compositionality, NIPS 2013], by lock-free parallel SGD
+// [Feng Niu et. al., Hogwild!: A Lock-Free Approach to Parallelizing Stochastic Gradient
+// Descent, NIPS 2011]: the threads update the shared embeddings without synchronization.
+
+#pragma once
+
+#include "random_walk.h"
+
+class SkipGram {
+public:
+  // the negatives are drawn with probability proportional to degree^0.75
+  SkipGram(Graph &g, int dim, int window, int negatives, float lr, uint64_t seed = 1);
+  // epoch 'epoch' (of num_epochs, for the linear decay of the learning rate) over the corpus;
+  // the next batch of walks is read while a batch is trained
+  void train(CorpusReader &corpus, int epoch, int num_epochs);
+  // the embeddings in the word2vec text format: "|V| dim", then one "v x_1 ... x_dim" per line
+  void save(std::string filename) const;
+  const latent_t *embeddings() const { return emb.data(); }
+  uint64_t samples() const { return num_samples; } // (vertex, context) pairs trained
+  double loss() const { return total_loss; }       // of the last epoch, per pair
+
+private:
+  vidType nv;
+  int dim, window, negatives;
+  float lr;
+  Philox rng;
+  AliasTable noise;                // the negative distribution
+  std::vector<latent_t> emb;       // the vertex embeddings (input vectors)
+  std::vector<latent_t> ctx;       // the context embeddings (output vectors)
+  std::vector<float> sigmoid_table, log_sigmoid_table;
+  uint64_t num_samples;
+  double total_loss;
+  // the pairs of walk 'id' in tokens[0 : len), at learning rate alpha; grad is dim floats of
+  // scratch space; returns the loss
+  double train_walk(uint64_t id, const vidType *tokens, int len, float alpha, latent_t *grad, uint64_t &samples);
+  latent_t *row(std::vector<latent_t> &m, vidType v) { return &m[size_t(v) * dim]; }
+};
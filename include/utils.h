@@ -58,9 +58,10 @@ inline std::vector<OutTy> prefix_sum(const std::vector<InTy>& in) {
   return prefix;
 }
 
-// Utility function to randomly select k items from [begin, end)
-template <typename T = int>
-inline T* select_k_items(T k, T begin, T end) {
+// Utility function to randomly select k items from [begin, end),
+// drawing from rng (e.g. a PhiloxStream), which has below(n) in [0, n)
+template <typename T, typename Rng>
+inline T* select_k_items(T k, T begin, T end, Rng &rng) {
   auto i = begin;
 
   // reservoir[] is the output array. Initialize
@@ -69,14 +70,10 @@ inline T* select_k_items(T k, T begin, T end) {
   for (; i < k; i++)
     reservoir[i] = i;
 
-  // Use a different seed value so that we don't get
-  // same result each time we run this program
-  srand(time(NULL));
-
   // Iterate from the (k+1)th element to nth element
   for (; i < end; i++) {
     // Pick a random index from 0 to i.
-    auto j = rand() % (i + 1);
+    auto j = T(rng.below(i + 1));
 
     // If the randomly picked index is smaller than k,
     // then replace the element present at the index
@@ -101,8 +98,8 @@ inline T find_ceil(T* arr, T r, T l, T h) {
 // Utility function to select one element from n elements given a frequency
 // (probability) distribution
 // https://www.geeksforgeeks.org/random-number-generator-in-arbitrary-probability-distribution-fashion/
-template <typename T = int>
-T select_one_item(T n, T* dist) {
+template <typename T, typename Rng>
+T select_one_item(T n, T* dist, Rng &rng) {
   T* offsets = new T[n];
   offsets[0] = dist[0];
   // compute the prefix sum of the distribution
@@ -110,9 +107,11 @@ T select_one_item(T n, T* dist) {
     offsets[i] = offsets[i - 1] + dist[i];
   // offsets[n-1] is sum of all frequencies
   T sum = offsets[n - 1];
-  T r   = (rand() % sum) + 1;
+  T r   = T(rng.below(sum)) + 1;
   // find which range r falls into, and return the index of the range
-  return find_ceil(offsets, r, 0, n - 1);
+  T pos = find_ceil(offsets, r, 0, n - 1);
+  delete[] offsets;
+  return pos;
 }
 
 }
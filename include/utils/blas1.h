@@ -0,0 +1,37 @@
+// Level-1 BLAS kernels on short dense vectors (e.g. embedding rows of 16 to 512 floats),
+// inlined so that the calls in an inner loop cost no more than the arithmetic: the BLAS
+// library calls have a dispatch overhead comparable to the work at these lengths.
+#pragma once
+#include <cstddef>
+#include "simd_vec.h"
+
+namespace blas1 {
+
+using namespace simd;
+
+// sum of x[i] * y[i]
+inline float dot(size_t n, const float *x, const float *y) {
+  size_t i = 0;
+  // two accumulators, to overlap the latency of the FMAs
+  vreg acc0 = vzero(), acc1 = vzero();
+  for (; i + 2 * VLEN <= n; i += 2 * VLEN) {
+    acc0 = vfma(vload(x + i), vload(y + i), acc0);
+    acc1 = vfma(vload(x + i + VLEN), vload(y + i + VLEN), acc1);
+  }
+  for (; i + VLEN <= n; i += VLEN)
+    acc0 = vfma(vload(x + i), vload(y + i), acc0);
+  float sum = vsum(vadd(acc0, acc1));
+  for (; i < n; i++) sum += x[i] * y[i];
+  return sum;
+}
+
+// y[i] += a * x[i]
+inline void axpy(size_t n, float a, const float *x, float *y) {
+  size_t i = 0;
+  vreg va = vset1(a);
+  for (; i + VLEN <= n; i += VLEN)
+    vstore(y + i, vfma(va, vload(x + i), vload(y + i)));
+  for (; i < n; i++) y[i] += a * x[i];
+}
+
+} // namespace blas1
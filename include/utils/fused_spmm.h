@@ -0,0 +1,130 @@
+// Fused sparse-dense matrix multiply (SpMM) for neighbor aggregation on CPU:
+//   out[v] = row_scale(v) * sum over the edges e=(v,u) of weight(e,u) * in[u]
+// The feature vector of a row is computed one tile at a time, with the tile accumulated in
+// registers over all the edges of the row: the scaled neighbor is never stored, and each
+// (edge, feature) costs one load and one FMA. The rows of the next neighbors are prefetched,
+// and the rows of very high degree are split into segments processed in parallel.
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+#include "simd_vec.h"
+
+namespace fused_spmm {
+
+using namespace simd;
+const int TILE_REGS = VLEN > 1 ? 4 : 8; // accumulators (vector registers) per tile
+
+const int PREFETCH_DISTANCE = 4;     // prefetch the row of the neighbor this many edges ahead
+const size_t SPLIT_DEGREE = 1024;    // rows with more edges are split into segments of this size
+
+// out[0:NREGS*VLEN) = scale * sum of weight(e,u) * in[u*len+f : ...], e in [begin, end)
+template <int NREGS, typename IndexT, typename Weight>
+inline void gather_tile(int len, int f, const float *in, const IndexT *colidx,
+                        size_t begin, size_t end, Weight weight, float scale, float *out) {
+  vreg acc[NREGS];
+  for (int i = 0; i < NREGS; i++) acc[i] = vzero();
+  for (size_t e = begin; e < end; e++) {
+    if (e + PREFETCH_DISTANCE < end) {
+      auto next = in + size_t(colidx[e+PREFETCH_DISTANCE]) * len + f;
+      for (int i = 0; i < NREGS * VLEN; i += 16) __builtin_prefetch(next + i);
+    }
+    auto u = colidx[e];
+    auto w = vset1(weight(e, u));
+    auto row = in + size_t(u) * len + f;
+    for (int i = 0; i < NREGS; i++) acc[i] = vfma(w, vload(row + i * VLEN), acc[i]);
+  }
+  auto s = vset1(scale);
+  for (int i = 0; i < NREGS; i++) vstore(out + i * VLEN, vmul(acc[i], s));
+}
+
+// the tail [f, f_end) of the features shorter than a vector register (or than a tile without SIMD)
+template <typename IndexT, typename Weight>
+inline void gather_tail(int len, int f, int f_end, const float *in, const IndexT *colidx,
+                        size_t begin, size_t end, Weight weight, float scale, float *out) {
+  float acc[16] = {0};
+  int width = f_end - f;
+  for (size_t e = begin; e < end; e++) {
+    auto u = colidx[e];
+    auto w = weight(e, u);
+    auto row = in + size_t(u) * len + f;
+    for (int i = 0; i < width; i++) acc[i] += w * row[i];
+  }
+  for (int i = 0; i < width; i++) out[i] = acc[i] * scale;
+}
+
+// the features [f_begin, f_end) of the rows of 'len' features:
+// out[0:f_end-f_begin) = scale * sum of weight(e,u) * in[u][f_begin:f_end), e in [begin, end)
+template <typename IndexT, typename Weight>
+inline void gather_cols(int len, int f_begin, int f_end, const float *in, const IndexT *colidx,
+                        size_t begin, size_t end, Weight weight, float scale, float *out) {
+  if (begin == end) {
+    std::fill(out, out + (f_end - f_begin), 0.f);
+    return;
+  }
+  const int tile = TILE_REGS * VLEN;
+  int f = f_begin;
+  for (; f + tile <= f_end; f += tile)
+    gather_tile<TILE_REGS>(len, f, in, colidx, begin, end, weight, scale, out + (f - f_begin));
+  if (VLEN > 1) switch ((f_end - f) / VLEN) {
+    case 3: gather_tile<3>(len, f, in, colidx, begin, end, weight, scale, out + (f - f_begin)); f += 3 * VLEN; break;
+    case 2: gather_tile<2>(len, f, in, colidx, begin, end, weight, scale, out + (f - f_begin)); f += 2 * VLEN; break;
+    case 1: gather_tile<1>(len, f, in, colidx, begin, end, weight, scale, out + (f - f_begin)); f += VLEN; break;
+    default: break;
+  }
+  if (f < f_end) gather_tail(len, f, f_end, in, colidx, begin, end, weight, scale, out + (f - f_begin));
+}
+
+// out[0:len) = scale * sum of weight(e,u) * in[u], e in [begin, end); zero for an empty range
+template <typename IndexT, typename Weight>
+inline void gather_row(int len, const float *in, const IndexT *colidx,
+                       size_t begin, size_t end, Weight weight, float scale, float *out) {
+  gather_cols(len, 0, len, in, colidx, begin, end, weight, scale, out);
+}
+
+} // namespace fused_spmm
+
+// out = diag(row_scale) * A * in, where A is the n-row CSR matrix (rowptr, colidx) whose
+// entry of edge e=(v,u) is weight(e,u), and in/out are row-major with 'len' columns
+template <typename IndexT, typename Weight, typename RowScale>
+void fused_spmm_cpu(size_t n, int len, const IndexT *rowptr, const IndexT *colidx,
+                    Weight weight, RowScale row_scale, const float *in, float *out) {
+  using namespace fused_spmm;
+  // segments of the high-degree rows, computed into partial sums and merged afterwards
+  std::vector<size_t> heavy_rows, seg_begins, seg_ends, seg_offsets(1, 0);
+  for (size_t v = 0; v < n; v++) {
+    size_t begin = rowptr[v], end = rowptr[v+1];
+    if (end - begin <= SPLIT_DEGREE) continue;
+    heavy_rows.push_back(v);
+    for (auto e = begin; e < end; e += SPLIT_DEGREE) {
+      seg_begins.push_back(e);
+      seg_ends.push_back(std::min(end, e + SPLIT_DEGREE));
+    }
+    seg_offsets.push_back(seg_begins.size());
+  }
+  std::vector<float> partials(seg_begins.size() * len);
+
+  #pragma omp parallel
+  {
+    #pragma omp for schedule(dynamic, 64) nowait
+    for (size_t v = 0; v < n; v++) {
+      size_t begin = rowptr[v], end = rowptr[v+1];
+      if (end - begin > SPLIT_DEGREE) continue;
+      gather_row(len, in, colidx, begin, end, weight, row_scale(v), out + v * len);
+    }
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t s = 0; s < seg_begins.size(); s++)
+      gather_row(len, in, colidx, seg_begins[s], seg_ends[s], weight, 1.f, &partials[s * len]);
+  }
+  // merge the segments of each high-degree row
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t r = 0; r < heavy_rows.size(); r++) {
+    auto v = heavy_rows[r];
+    auto scale = row_scale(v);
+    for (int i = 0; i < len; i++) {
+      float sum = 0.f;
+      for (auto s = seg_offsets[r]; s < seg_offsets[r+1]; s++) sum += partials[s * len + i];
+      out[v * len + i] = sum * scale;
+    }
+  }
+}
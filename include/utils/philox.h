@@ -0,0 +1,171 @@
+// Philox4x32-10 counter-based random number generator [Salmon et al., SC'11].
+// A draw is a pure function of (seed, stream, index): there is no state shared between
+// threads, and the random choices do not depend on the number of threads or on the order
+// in which the draws are made, as long as each draw is given its own (stream, index),
+// e.g. stream = step (or batch), index = the vertex, edge or output position it is drawn for.
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+namespace philox {
+
+const uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57; // round multipliers
+const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85; // Weyl sequence of the key
+const int ROUNDS = 10;
+const int BATCH = 32; // counters generated together in bulk, in SIMD lanes
+
+inline uint32_t mulhilo(uint32_t a, uint32_t b, uint32_t &hi) {
+  uint64_t p = uint64_t(a) * b;
+  hi = uint32_t(p >> 32);
+  return uint32_t(p);
+}
+
+// the 4 words of the counter c are replaced by the 4 random words
+inline void philox4x32(uint32_t c[4], uint32_t k0, uint32_t k1) {
+  for (int r = 0; r < ROUNDS; r++) {
+    uint32_t hi0, hi1;
+    uint32_t lo0 = mulhilo(M0, c[0], hi0);
+    uint32_t lo1 = mulhilo(M1, c[2], hi1);
+    c[0] = hi1 ^ c[1] ^ k0;
+    c[1] = lo1;
+    c[2] = hi0 ^ c[3] ^ k1;
+    c[3] = lo0;
+    k0 += W0;
+    k1 += W1;
+  }
+}
+
+// the same for BATCH counters stored by word (structure of arrays), so that the rounds
+// of the BATCH counters are computed in parallel by the SIMD units
+inline void philox4x32_batch(uint32_t c0[BATCH], uint32_t c1[BATCH], uint32_t c2[BATCH],
+                             uint32_t c3[BATCH], uint32_t k0, uint32_t k1) {
+  for (int r = 0; r < ROUNDS; r++) {
+    for (int i = 0; i < BATCH; i++) {
+      uint64_t p0 = uint64_t(M0) * c0[i];
+      uint64_t p1 = uint64_t(M1) * c2[i];
+      c0[i] = uint32_t(p1 >> 32) ^ c1[i] ^ k0;
+      c1[i] = uint32_t(p1);
+      c2[i] = uint32_t(p0 >> 32) ^ c3[i] ^ k1;
+      c3[i] = uint32_t(p0);
+    }
+    k0 += W0;
+    k1 += W1;
+  }
+}
+
+// a uniform float in [0, 1) from the 24 high bits
+inline float to_float(uint32_t x) { return (x >> 8) * (1.f / 16777216.f); }
+
+// a uniform integer in [0, n), by multiplication (bias below n / 2^32)
+inline uint32_t to_below(uint32_t x, uint32_t n) { return uint32_t((uint64_t(x) * n) >> 32); }
+
+} // namespace philox
+
+// The 2^64 streams of a seed each hold 2^64 32-bit values; the counter of the value at
+// 'index' of 'stream' is (index / 4, stream) and the value is word index % 4 of its block.
+class Philox {
+public:
+  explicit Philox(uint64_t seed = 0) : k0(uint32_t(seed)), k1(uint32_t(seed >> 32)) {}
+  // the 4 values at [4*block, 4*block+4) of the stream
+  void block(uint64_t stream, uint64_t block, uint32_t out[4]) const {
+    out[0] = uint32_t(block);
+    out[1] = uint32_t(block >> 32);
+    out[2] = uint32_t(stream);
+    out[3] = uint32_t(stream >> 32);
+    philox::philox4x32(out, k0, k1);
+  }
+  uint32_t u32(uint64_t stream, uint64_t index) const {
+    uint32_t r[4];
+    block(stream, index >> 2, r);
+    return r[index & 3];
+  }
+  float uniform(uint64_t stream, uint64_t index) const { return philox::to_float(u32(stream, index)); }
+  uint32_t below(uint32_t n, uint64_t stream, uint64_t index) const {
+    return philox::to_below(u32(stream, index), n);
+  }
+  // Position 'pos' of a random permutation of [0, n), evaluated one position at a time: a
+  // 4-round Feistel network over the smallest even power of two >= n whose round function is
+  // drawn from 'stream', with cycle walking.
+  uint64_t permute(uint64_t stream, uint64_t pos, uint64_t n) const {
+    int half = 1;
+    while ((uint64_t(1) << (2 * half)) < n) half++;
+    uint64_t mask = (uint64_t(1) << half) - 1;
+    do {
+      uint64_t l = pos >> half, r = pos & mask;
+      for (uint64_t round = 0; round < 4; round++) {
+        uint64_t t = l ^ (u32(stream, (round << 32) | r) & mask);
+        l = r;
+        r = t;
+      }
+      pos = (l << half) | r;
+    } while (pos >= n);
+    return pos;
+  }
+
+  // Bulk generation: out[i] = f(value at index offset+i of the stream), i in [0, n).
+  // The values are the ones drawn one at a time above, so a range can be split among threads.
+  template <typename Func>
+  void generate(uint64_t stream, uint64_t offset, size_t n, Func f) const {
+    using namespace philox;
+    size_t i = 0;
+    // the values before the first block boundary
+    for (; i < n && (offset + i) % 4 != 0; i++) f(i, u32(stream, offset + i));
+    uint32_t c0[BATCH], c1[BATCH], c2[BATCH], c3[BATCH];
+    for (; i + 4 * BATCH <= n; i += 4 * BATCH) {
+      uint64_t first = (offset + i) >> 2;
+      for (int j = 0; j < BATCH; j++) {
+        c0[j] = uint32_t(first + j);
+        c1[j] = uint32_t((first + j) >> 32);
+        c2[j] = uint32_t(stream);
+        c3[j] = uint32_t(stream >> 32);
+      }
+      philox4x32_batch(c0, c1, c2, c3, k0, k1);
+      for (int j = 0; j < BATCH; j++) {
+        f(i + 4*j + 0, c0[j]);
+        f(i + 4*j + 1, c1[j]);
+        f(i + 4*j + 2, c2[j]);
+        f(i + 4*j + 3, c3[j]);
+      }
+    }
+    for (; i < n; i++) f(i, u32(stream, offset + i));
+  }
+  // out[i] = uniform in [0, 1)
+  void uniforms(uint64_t stream, uint64_t offset, size_t n, float *out) const {
+    generate(stream, offset, n, [out](size_t i, uint32_t x) { out[i] = philox::to_float(x); });
+  }
+  // out[i] = 1 with probability p, 0 otherwise
+  template <typename T>
+  void bernoulli(uint64_t stream, uint64_t offset, size_t n, float p, T *out) const {
+    // compare on the 24 bits of to_float: x < p  <=>  (x >> 8) < ceil(p * 2^24)
+    uint32_t threshold = p >= 1.f ? (1u << 24) : p <= 0.f ? 0 : uint32_t(std::ceil(double(p) * 16777216.0));
+    generate(stream, offset, n, [out, threshold](size_t i, uint32_t x) { out[i] = T((x >> 8) < threshold); });
+  }
+
+private:
+  uint32_t k0, k1;
+};
+
+// Sequential draws from one stream, for a single thread whose number of draws is not known
+// in advance (e.g. rejection loops); give each thread, vertex or task its own stream.
+class PhiloxStream {
+public:
+  PhiloxStream(const Philox &g, uint64_t s) : gen(g), stream(s), pos(0), cached(~uint64_t(0)) {}
+  uint32_t next() {
+    uint64_t b = pos >> 2;
+    if (b != cached) {
+      gen.block(stream, b, buf);
+      cached = b;
+    }
+    return buf[pos++ & 3];
+  }
+  float uniform() { return philox::to_float(next()); }
+  uint32_t below(uint32_t n) { return philox::to_below(next(), n); }
+
+private:
+  Philox gen;
+  uint64_t stream;
+  uint64_t pos;
+  uint64_t cached;
+  uint32_t buf[4];
+};
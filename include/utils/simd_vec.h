@@ -0,0 +1,58 @@
+// A vector register of floats and the few operations the inlined dense kernels (blas1.h,
+// fused_spmm.h) are written with: AVX-512, AVX2 with FMA, or a scalar float without SIMD.
+#pragma once
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace simd {
+
+#if defined(__AVX512F__)
+const int VLEN = 16;
+typedef __m512 vreg;
+inline vreg vzero() { return _mm512_setzero_ps(); }
+inline vreg vset1(float a) { return _mm512_set1_ps(a); }
+inline vreg vload(const float *p) { return _mm512_loadu_ps(p); }
+inline void vstore(float *p, vreg a) { _mm512_storeu_ps(p, a); }
+inline vreg vfma(vreg a, vreg b, vreg c) { return _mm512_fmadd_ps(a, b, c); }
+inline vreg vadd(vreg a, vreg b) { return _mm512_add_ps(a, b); }
+inline vreg vmul(vreg a, vreg b) { return _mm512_mul_ps(a, b); }
+// folded with the zero-masked forms (all lanes kept): the unmasked shuffles and extracts, and
+// _mm512_reduce_add_ps built on them, merge into undefined registers, which GCC reports as
+// uninitialized
+inline float vsum(vreg a) {
+  a = _mm512_add_ps(a, _mm512_maskz_shuffle_f32x4(0xFFFF, a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+  a = _mm512_add_ps(a, _mm512_maskz_shuffle_f32x4(0xFFFF, a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+  __m128 r4 = _mm512_maskz_extractf32x4_ps(0xF, a, 0);
+  __m128 r2 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+  return _mm_cvtss_f32(_mm_add_ss(r2, _mm_movehdup_ps(r2)));
+}
+#elif defined(__AVX2__) && defined(__FMA__)
+const int VLEN = 8;
+typedef __m256 vreg;
+inline vreg vzero() { return _mm256_setzero_ps(); }
+inline vreg vset1(float a) { return _mm256_set1_ps(a); }
+inline vreg vload(const float *p) { return _mm256_loadu_ps(p); }
+inline void vstore(float *p, vreg a) { _mm256_storeu_ps(p, a); }
+inline vreg vfma(vreg a, vreg b, vreg c) { return _mm256_fmadd_ps(a, b, c); }
+inline vreg vadd(vreg a, vreg b) { return _mm256_add_ps(a, b); }
+inline vreg vmul(vreg a, vreg b) { return _mm256_mul_ps(a, b); }
+inline float vsum(vreg a) {
+  __m128 r4 = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+  __m128 r2 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+  return _mm_cvtss_f32(_mm_add_ss(r2, _mm_movehdup_ps(r2)));
+}
+#else
+const int VLEN = 1; // left to the auto-vectorizer
+typedef float vreg;
+inline vreg vzero() { return 0.f; }
+inline vreg vset1(float a) { return a; }
+inline vreg vload(const float *p) { return *p; }
+inline void vstore(float *p, vreg a) { *p = a; }
+inline vreg vfma(vreg a, vreg b, vreg c) { return a * b + c; }
+inline vreg vadd(vreg a, vreg b) { return a + b; }
+inline vreg vmul(vreg a, vreg b) { return a * b; }
+inline float vsum(vreg a) { return a; }
+#endif
+
+} // namespace simd
@@ -0,0 +1,100 @@
+// Multi-versioned graph: immutable snapshots for readers while writers keep updating
+#pragma once
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include "graph.h"
+#include "dynamic_graph.h"
+
+// Flat CSR shared by the pages that view it
+struct BaseCSR {
+  std::vector<eidType> rowptr;
+  std::vector<vidType> colidx;
+};
+
+// Adjacency lists of PAGE_SIZE consecutive vertices. A list either points into a base CSR,
+// or is owned by the page after it was modified by an update; pages are never modified
+// once published, so an update copies the page and only the lists it changes.
+struct VertexPage {
+  static const int PAGE_BITS = 6;
+  static const vidType PAGE_SIZE = vidType(1) << PAGE_BITS;
+  std::shared_ptr<const BaseCSR> base; // keeps the base of the non-owned lists alive
+  const vidType *lists[PAGE_SIZE];
+  vidType degrees[PAGE_SIZE];
+  std::shared_ptr<const VertexList> owned[PAGE_SIZE]; // NULL if the list is in the base
+  vidType num_owned;
+  VertexPage() : num_owned(0) {}
+  size_t get_memory() const {
+    size_t bytes = sizeof(VertexPage);
+    for (vidType i = 0; i < PAGE_SIZE; i++)
+      if (owned[i]) bytes += owned[i]->capacity() * sizeof(vidType);
+    return bytes;
+  }
+};
+
+// Immutable, GraphT-compatible view of one version of the graph
+class GraphSnapshot {
+public:
+  GraphSnapshot(uint64_t ver, vidType nv, eidType ne, std::vector<std::shared_ptr<const VertexPage>> p) :
+    version_(ver), n_vertices(nv), n_edges(ne), pages(std::move(p)) {}
+  uint64_t version() const { return version_; }
+  vidType V() const { return n_vertices; }
+  eidType E() const { return n_edges; }
+  bool has_reverse_graph() const { return true; } // undirected
+  vidType get_degree(vidType v) const { return page(v).degrees[v & (VertexPage::PAGE_SIZE-1)]; }
+  VertexSet N(vidType v) const {
+    auto &p = page(v);
+    auto i = v & (VertexPage::PAGE_SIZE-1);
+    return VertexSet(const_cast<vidType*>(p.lists[i]), p.degrees[i], v);
+  }
+  vidType N(vidType v, vidType n) const { return page(v).lists[v & (VertexPage::PAGE_SIZE-1)][n]; }
+  VertexSet in_neigh(vidType v) const { return N(v); }
+  bool is_connected(vidType v, vidType u) const { auto adj = N(v); return std::binary_search(adj.begin(), adj.end(), u); }
+  size_t get_memory() const; // bytes of the page table, the pages and the lists owned by them
+private:
+  friend class VersionedGraph;
+  uint64_t version_;
+  vidType n_vertices;
+  eidType n_edges;
+  std::vector<std::shared_ptr<const VertexPage>> pages;
+  const VertexPage& page(vidType v) const { return *pages[v >> VertexPage::PAGE_BITS]; }
+};
+
+typedef std::shared_ptr<const GraphSnapshot> SnapshotPtr;
+
+// Undirected graph with copy-on-write pages. A batch copies the page table, the pages it
+// touches and the lists it changes, and publishes a new snapshot; readers holding older
+// snapshots are never blocked. A background thread compacts the owned lists into a new
+// base CSR and swaps it in, so the update path never rebuilds the whole graph.
+class VersionedGraph {
+public:
+  VersionedGraph(Graph &g);
+  ~VersionedGraph() { stop_compaction(); }
+  SnapshotPtr snapshot() const; // the latest version
+  // apply a batch of deletions and insertions (in this order) and publish a new version;
+  // self-loops, redundant insertions and missing deletions are ignored
+  uint64_t apply_batch(EdgeBatch inserts, EdgeBatch deletes);
+  // compact in the background whenever more than 'threshold' lists are owned
+  void start_compaction(size_t threshold);
+  void stop_compaction();
+  int num_compactions() const { return n_compactions; }
+
+private:
+  mutable std::mutex snapshot_mutex; // protects current
+  std::mutex update_mutex;           // serializes writers and the installation of compacted pages
+  SnapshotPtr current;
+  std::atomic<size_t> num_owned_lists; // owned lists in the current version
+  std::atomic<int> n_compactions;
+
+  std::thread compactor;
+  std::condition_variable compactor_cv;
+  std::mutex compactor_mutex;
+  bool stopping;
+  size_t compaction_threshold;
+  uint64_t compacted_version;        // the latest version when the last compaction pass ended
+
+  void publish(SnapshotPtr s);
+  void compact();
+};
+
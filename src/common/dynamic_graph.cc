@@ -0,0 +1,196 @@
+#include "dynamic_graph.h"
+
+static const size_t SLAB_SIZE = size_t(1) << 18; // vertices per slab
+
+BlockAllocator::~BlockAllocator() {
+  for (auto slab : slabs_) delete [] slab;
+}
+
+vidType* BlockAllocator::allocate(int c) {
+  size_t n = size_t(1) << c;
+  if (c > MAX_SLAB_CLASS) return new vidType[n];
+  if (!free_lists_[c].empty()) {
+    auto p = free_lists_[c].back();
+    free_lists_[c].pop_back();
+    return p;
+  }
+  if (slab_left_ < n) {
+    // hand the rest of the current slab out as smaller blocks
+    for (int k = MAX_SLAB_CLASS; k >= MIN_CLASS; k--) {
+      while (slab_left_ >= (size_t(1) << k)) {
+        free_lists_[k].push_back(slab_ptr_);
+        slab_ptr_ += size_t(1) << k;
+        slab_left_ -= size_t(1) << k;
+      }
+    }
+    slab_ptr_ = new vidType[SLAB_SIZE];
+    slabs_.push_back(slab_ptr_);
+    slab_left_ = SLAB_SIZE;
+    slab_bytes_ += SLAB_SIZE * sizeof(vidType);
+  }
+  auto p = slab_ptr_;
+  slab_ptr_ += n;
+  slab_left_ -= n;
+  return p;
+}
+
+void BlockAllocator::deallocate(vidType *p, int c) {
+  if (c > MAX_SLAB_CLASS) delete [] p;
+  else free_lists_[c].push_back(p);
+}
+
+DynamicGraph::DynamicGraph(vidType nv, bool directed) :
+    is_directed_(directed), n_vertices(nv), n_edges(0),
+    adj_lists(nv, NULL), degrees(nv, 0), size_classes(nv, -1),
+    allocators(omp_get_max_threads()) {
+}
+
+DynamicGraph::~DynamicGraph() {
+  for (vidType v = 0; v < n_vertices; v++)
+    if (size_classes[v] > BlockAllocator::MAX_SLAB_CLASS) delete [] adj_lists[v];
+}
+
+bool DynamicGraph::is_connected(vidType v, vidType u) const {
+  auto first = adj_lists[v], last = adj_lists[v] + degrees[v];
+  return std::binary_search(first, last, u);
+}
+
+vidType DynamicGraph::get_max_degree() const {
+  vidType max_degree = 0;
+  #pragma omp parallel for reduction(max:max_degree)
+  for (vidType v = 0; v < n_vertices; v++)
+    if (degrees[v] > max_degree) max_degree = degrees[v];
+  return max_degree;
+}
+
+size_t DynamicGraph::get_memory() const {
+  size_t bytes = size_t(n_vertices) * (sizeof(vidType*) + sizeof(vidType) + sizeof(int8_t));
+  for (auto &a : allocators) bytes += a.get_memory();
+  for (vidType v = 0; v < n_vertices; v++)
+    if (size_classes[v] > BlockAllocator::MAX_SLAB_CLASS)
+      bytes += (size_t(1) << size_classes[v]) * sizeof(vidType);
+  return bytes;
+}
+
+// move the neighbors of v into a block of the size class fitting 'capacity'
+void DynamicGraph::resize_block(vidType v, vidType capacity) {
+  auto &allocator = local_allocator();
+  int c = BlockAllocator::size_class(capacity);
+  if (c == size_classes[v]) return;
+  auto block = allocator.allocate(c);
+  if (adj_lists[v] != NULL) {
+    std::copy(adj_lists[v], adj_lists[v] + degrees[v], block);
+    allocator.deallocate(adj_lists[v], size_classes[v]);
+  }
+  adj_lists[v] = block;
+  size_classes[v] = c;
+}
+
+void sort_edge_batch(EdgeBatch &batch, bool symmetrize) {
+  if (symmetrize) {
+    auto n = batch.size();
+    batch.resize(2 * n);
+    #pragma omp parallel for
+    for (size_t i = 0; i < n; i++)
+      batch[n+i] = std::make_pair(batch[i].second, batch[i].first);
+  }
+  // sort by (src, dst): sort pieces in parallel and merge them pairwise
+  int num_threads = omp_get_max_threads();
+  size_t piece = (batch.size() + num_threads - 1) / num_threads;
+  #pragma omp parallel for
+  for (int i = 0; i < num_threads; i++) {
+    auto first = std::min(batch.size(), i * piece);
+    auto last = std::min(batch.size(), (i+1) * piece);
+    std::sort(batch.begin() + first, batch.begin() + last);
+  }
+  for (size_t width = piece; width < batch.size(); width *= 2) {
+    #pragma omp parallel for
+    for (size_t first = 0; first < batch.size(); first += 2 * width) {
+      auto mid = std::min(batch.size(), first + width);
+      auto last = std::min(batch.size(), first + 2 * width);
+      std::inplace_merge(batch.begin() + first, batch.begin() + mid, batch.begin() + last);
+    }
+  }
+  batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+}
+
+void DynamicGraph::prepare_batch(const EdgeBatch &batch) {
+  sorted.reserve(is_directed_ ? batch.size() : 2 * batch.size());
+  sorted.assign(batch.begin(), batch.end());
+  sort_edge_batch(sorted, !is_directed_);
+  group_begins.clear();
+  for (size_t i = 0; i < sorted.size(); i++) {
+    assert(sorted[i].first < n_vertices && sorted[i].second < n_vertices);
+    if (i == 0 || sorted[i].first != sorted[i-1].first) group_begins.push_back(i);
+  }
+  group_begins.push_back(sorted.size());
+}
+
+eidType DynamicGraph::insert_edges(const EdgeBatch &batch) {
+  prepare_batch(batch);
+  eidType num_inserted = 0;
+  #pragma omp parallel for reduction(+:num_inserted) schedule(dynamic, 64)
+  for (size_t g = 0; g < group_begins.size() - 1; g++) {
+    auto first = sorted.begin() + group_begins[g];
+    auto last = sorted.begin() + group_begins[g+1];
+    auto v = first->first;
+    auto adj = adj_lists[v];
+    auto deg = degrees[v];
+    // count the new neighbors (skipping self-loops and existing edges)
+    vidType num_new = 0;
+    vidType i = 0;
+    for (auto it = first; it != last; ++it) {
+      auto u = it->second;
+      if (u == v) continue;
+      while (i < deg && adj[i] < u) i++;
+      if (i == deg || adj[i] != u) num_new++;
+    }
+    if (num_new == 0) continue;
+    if (size_classes[v] < 0 || deg + num_new > (vidType(1) << size_classes[v]))
+      resize_block(v, deg + num_new);
+    adj = adj_lists[v];
+    // merge backwards in place
+    int64_t k = deg + num_new - 1, j = int64_t(deg) - 1;
+    for (auto it = last; it != first; ) {
+      --it;
+      auto u = it->second;
+      if (u == v) continue;
+      while (j >= 0 && adj[j] > u) adj[k--] = adj[j--];
+      if (j >= 0 && adj[j] == u) continue;
+      adj[k--] = u;
+    }
+    assert(k == j);
+    degrees[v] = deg + num_new;
+    num_inserted += num_new;
+  }
+  n_edges += num_inserted;
+  return is_directed_ ? num_inserted : num_inserted / 2;
+}
+
+eidType DynamicGraph::delete_edges(const EdgeBatch &batch) {
+  prepare_batch(batch);
+  eidType num_deleted = 0;
+  #pragma omp parallel for reduction(+:num_deleted) schedule(dynamic, 64)
+  for (size_t g = 0; g < group_begins.size() - 1; g++) {
+    auto first = sorted.begin() + group_begins[g];
+    auto last = sorted.begin() + group_begins[g+1];
+    auto v = first->first;
+    auto adj = adj_lists[v];
+    auto deg = degrees[v];
+    vidType k = 0;
+    auto it = first;
+    for (vidType i = 0; i < deg; i++) {
+      while (it != last && it->second < adj[i]) ++it;
+      if (it != last && it->second == adj[i]) continue;
+      adj[k++] = adj[i];
+    }
+    num_deleted += deg - k;
+    degrees[v] = k;
+    // shrink blocks that are less than a quarter full
+    if (size_classes[v] > BlockAllocator::MIN_CLASS && k < (vidType(1) << size_classes[v]) / 4)
+      resize_block(v, k);
+  }
+  n_edges -= num_deleted;
+  return is_directed_ ? num_deleted : num_deleted / 2;
+}
+
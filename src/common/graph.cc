@@ -42,7 +42,7 @@ void GraphT<map_vertices, map_edges>::load_graph(std::string prefix,
 
 template<bool map_vertices, bool map_edges>
 void GraphT<map_vertices, map_edges>::load_graph_data(std::string prefix, 
-    bool use_dag, bool use_vlabel, bool use_elabel, bool need_reverse) {
+    bool use_dag, bool use_vlabel, bool use_elabel, bool need_reverse, bool global_ids) {
   // read row pointers
   load_row_pointers(prefix);
 
@@ -59,7 +59,15 @@ void GraphT<map_vertices, map_edges>::load_graph_data(std::string prefix,
   if (is_directed_) {
     std::cout << "This is a directed graph\n";
     if (need_reverse) {
-      build_reverse_graph();
+      // use the reverse graph persisted by write_reverse_graph() if any
+      std::ifstream f_reverse((prefix + ".reverse.edge.bin").c_str());
+      if (f_reverse.good()) {
+        std::cout << "Loading the reverse graph\n";
+        if constexpr (map_vertices) map_file(prefix + ".reverse.vertex.bin", reverse_vertices, n_vertices+1);
+        else read_file(prefix + ".reverse.vertex.bin", reverse_vertices, n_vertices+1);
+        if constexpr (map_edges) map_file(prefix + ".reverse.edge.bin", reverse_edges, n_edges);
+        else read_file(prefix + ".reverse.edge.bin", reverse_edges, n_edges);
+      } else build_reverse_graph();
       std::cout << "This graph maintains both incomming and outgoing edge-list\n";
       has_reverse = true;
     }
@@ -72,7 +80,8 @@ void GraphT<map_vertices, map_edges>::load_graph_data(std::string prefix,
   // compute maximum degree
   if (max_degree == 0) compute_max_degree();
   //else std::cout << "max_degree: " << max_degree << "\n";
-  assert(max_degree > 0 && max_degree < n_vertices);
+  // a 1D partition keeps global column indices, so its max_degree may exceed its |V|
+  assert(max_degree > 0 && (global_ids || max_degree < n_vertices));
 
   // read vertex labels
   if (use_vlabel) {
@@ -208,6 +217,21 @@ void GraphT<map_vertices, map_edges>::read_meta_info(std::string prefix) {
   std::cout << "Reading graph: |V| " << nv << " |E| " << n_edges << "\n";
 }
 
+template<bool map_vertices, bool map_edges>
+void GraphT<map_vertices, map_edges>::write_meta_info(std::string prefix) const {
+  std::ofstream f_meta((prefix + ".meta.txt").c_str());
+  if (!f_meta) {
+    std::cout << "File not available\n";
+    throw 1;
+  }
+  if (is_bipartite_) f_meta << n_vert0 << " " << n_vert1 << "\n";
+  else f_meta << n_vertices << "\n";
+  f_meta << n_edges << "\n";
+  f_meta << sizeof(vidType) << " " << sizeof(eidType) << " " << sizeof(vlabel_t) << " " << sizeof(elabel_t) << "\n";
+  f_meta << max_degree << "\n" << feat_len << "\n" << num_vertex_classes << "\n" << num_edge_classes << "\n";
+  f_meta.close();
+}
+
 template<bool map_vertices, bool map_edges>
 void GraphT<map_vertices, map_edges>::load_row_pointers(std::string prefix) {
   if constexpr (map_vertices) {
@@ -507,29 +531,54 @@ void GraphT<map_vertices,map_edges>::write_to_file(std::string outfilename, bool
   }
 }
  
+// Transpose the CSR by counting sort: in-degree histogram, in-place prefix sum, then
+// an atomic scatter that uses reverse_vertices[u+1] as the insertion cursor of u;
+// nothing is allocated besides the two output arrays
 template<bool map_vertices, bool map_edges>
-void GraphT<map_vertices, map_edges>::build_reverse_graph() {
-  std::vector<VertexList> reverse_adj_lists(n_vertices);
+void GraphT<map_vertices, map_edges>::build_reverse_graph(bool sorted) {
+  Timer t;
+  t.Start();
+  reverse_vertices = custom_alloc_global<eidType>(n_vertices+1);
+  reverse_edges = custom_alloc_global<vidType>(n_edges);
+  #pragma omp parallel for
+  for (vidType v = 0; v < n_vertices+1; v++)
+    reverse_vertices[v] = 0;
+  #pragma omp parallel for schedule(dynamic, 1024)
   for (vidType v = 0; v < n_vertices; v++) {
-    for (auto u : N(v)) {
-      reverse_adj_lists[u].push_back(v);
-    }
+    for (auto u : N(v))
+      fetch_and_add(reverse_vertices[u+1], 1);
   }
-  reverse_vertices = custom_alloc_global<eidType>(n_vertices+1);
-  reverse_vertices[0] = 0;
-  for (vidType i = 1; i < n_vertices+1; i++) {
-    auto degree = reverse_adj_lists[i-1].size();
-    reverse_vertices[i] = reverse_vertices[i-1] + degree;
+  // shifted exclusive scan: reverse_vertices[u+1] becomes the beginning of u's in-list
+  // (the in-degree of the last vertex is not needed and gets overwritten)
+  parallel_prefix_sum_inplace<eidType>(reverse_vertices, n_vertices);
+  #pragma omp parallel for schedule(dynamic, 1024)
+  for (vidType v = 0; v < n_vertices; v++) {
+    for (auto u : N(v))
+      reverse_edges[fetch_and_add(reverse_vertices[u+1], 1)] = v;
   }
-  reverse_edges = custom_alloc_global<vidType>(n_edges);
-  //#pragma omp parallel for
-  for (vidType i = 0; i < n_vertices; i++) {
-    auto begin = reverse_vertices[i];
-    std::copy(reverse_adj_lists[i].begin(), 
-        reverse_adj_lists[i].end(), &reverse_edges[begin]);
-  }
-  for (auto adjlist : reverse_adj_lists) adjlist.clear();
-  reverse_adj_lists.clear();
+  // after the scatter, reverse_vertices[u+1] points to the end of u's in-list
+  if (sorted) {
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (vidType v = 0; v < n_vertices; v++)
+      std::sort(reverse_edges + reverse_vertices[v], reverse_edges + reverse_vertices[v+1]);
+  }
+  t.Stop();
+  std::cout << "Time building the reverse graph: " << t.Seconds() << " sec\n";
+}
+
+template<bool map_vertices, bool map_edges>
+void GraphT<map_vertices, map_edges>::write_reverse_graph(std::string prefix) const {
+  assert(reverse_vertices != NULL && reverse_edges != NULL);
+  std::ofstream outfile((prefix+".reverse.vertex.bin").c_str(), std::ios::binary);
+  std::ofstream outfile1((prefix+".reverse.edge.bin").c_str(), std::ios::binary);
+  if (!outfile || !outfile1) {
+    std::cout << "File not available\n";
+    throw 1;
+  }
+  outfile.write(reinterpret_cast<const char*>(reverse_vertices), (n_vertices+1)*sizeof(eidType));
+  outfile1.write(reinterpret_cast<const char*>(reverse_edges), n_edges*sizeof(vidType));
+  outfile.close();
+  outfile1.close();
 }
 
 template<> VertexSet GraphT<>::out_neigh(vidType vid, vidType offset) const {
@@ -1086,18 +1135,108 @@ template<> bool GraphT<>::is_freq_vertex(vidType v, int threshold) {
 }
 
 // NLF: neighborhood label frequency
+// Labels are stored flat: a fixed-width histogram per vertex when the label
+// alphabet is small (dense mode), otherwise CSR-like sorted (label, count) pairs.
 template<> void GraphT<>::BuildNLF() {
-  //std::cout << "Building NLF map for the data graph\n";
-  nlf_.resize(size());
-  #pragma omp parallel for
-  for (vidType v = 0; v < size(); ++v) {
-    for (auto u : N(v)) {
-      auto vl = this->get_vlabel(u);
-      if (nlf_[v].find(vl) == nlf_[v].end())
-        nlf_[v][vl] = 0;
-      nlf_[v][vl] += 1;
+  assert(vlabels != NULL);
+  Timer t;
+  t.Start();
+  int max_vlabel = 0;
+  #pragma omp parallel for reduction(max:max_vlabel)
+  for (vidType v = 0; v < size(); ++v)
+    max_vlabel = std::max(max_vlabel, int(vlabels[v]));
+  int width = (max_vlabel + NLF_SIMD_WIDTH) / NLF_SIMD_WIDTH * NLF_SIMD_WIDTH;
+  nlf_labels_.clear();
+  nlf_offsets_.clear();
+  if (width <= NLF_DENSE_MAX_LABELS) {
+    nlf_width_ = width;
+    nlf_counts_.assign(size_t(size()) * width, 0);
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (vidType v = 0; v < size(); ++v) {
+      auto hist = &nlf_counts_[size_t(v) * width];
+      for (auto u : N(v)) hist[vlabels[u]] ++;
+    }
+  } else {
+    nlf_width_ = 0;
+    std::vector<vidType> num_labels(size(), 0);
+    #pragma omp parallel
+    {
+      std::vector<vidType> hist(max_vlabel+1, 0);
+      #pragma omp for schedule(dynamic, 64)
+      for (vidType v = 0; v < size(); ++v) {
+        vidType n = 0;
+        for (auto u : N(v))
+          if (hist[vlabels[u]]++ == 0) n ++;
+        for (auto u : N(v)) hist[vlabels[u]] = 0;
+        num_labels[v] = n;
+      }
+    }
+    nlf_offsets_.resize(size()+1);
+    parallel_prefix_sum<vidType,eidType>(num_labels, nlf_offsets_.data());
+    auto num_pairs = nlf_offsets_[size()];
+    nlf_labels_.resize(num_pairs);
+    nlf_counts_.resize(num_pairs);
+    #pragma omp parallel
+    {
+      std::vector<vidType> hist(max_vlabel+1, 0);
+      #pragma omp for schedule(dynamic, 64)
+      for (vidType v = 0; v < size(); ++v) {
+        auto begin = nlf_offsets_[v];
+        auto end = nlf_offsets_[v+1];
+        auto i = begin;
+        for (auto u : N(v))
+          if (hist[vlabels[u]]++ == 0) nlf_labels_[i++] = vlabels[u];
+        std::sort(&nlf_labels_[begin], &nlf_labels_[begin] + (end - begin));
+        for (auto j = begin; j < end; j++) {
+          nlf_counts_[j] = hist[nlf_labels_[j]];
+          hist[nlf_labels_[j]] = 0;
+        }
+      }
     }
   }
+  t.Stop();
+  std::cout << "NLF layout: " << (is_nlf_dense() ? "dense histogram, width " + std::to_string(nlf_width_) : "sparse label/count pairs")
+            << ", memory: " << BYTESTOMB(get_nlf_memory()) << " MB\n";
+  std::cout << "Time building NLF: " << t.Seconds() << " sec\n";
+}
+
+template<> vidType GraphT<>::get_nlf(vidType v, vlabel_t label) const {
+  if (is_nlf_dense()) return int(label) < nlf_width_ ? nlf_counts_[size_t(v)*nlf_width_+label] : 0;
+  auto begin = nlf_labels_.begin() + nlf_offsets_[v];
+  auto end = nlf_labels_.begin() + nlf_offsets_[v+1];
+  auto it = std::lower_bound(begin, end, label);
+  if (it == end || *it != label) return 0;
+  return nlf_counts_[it - nlf_labels_.begin()];
+}
+
+// Check that N(v) has at least query_nlf[l] neighbors of label l, for every label l < len
+template<> bool GraphT<>::nlf_dominates(vidType v, const vidType* query_nlf, int len) const {
+  if (is_nlf_dense()) {
+    const vidType* hist = &nlf_counts_[size_t(v)*nlf_width_];
+    int n = std::min(len, nlf_width_);
+    int violated = 0;
+    #pragma omp simd reduction(|:violated)
+    for (int l = 0; l < n; l++)
+      violated |= (hist[l] < query_nlf[l]);
+    for (int l = n; l < len; l++)
+      violated |= (query_nlf[l] > 0);
+    return !violated;
+  }
+  auto i = nlf_offsets_[v];
+  auto end = nlf_offsets_[v+1];
+  for (int l = 0; l < len; l++) {
+    if (query_nlf[l] == 0) continue;
+    while (i < end && int(nlf_labels_[i]) < l) i++;
+    if (i == end || int(nlf_labels_[i]) != l || nlf_counts_[i] < query_nlf[l]) return false;
+  }
+  return true;
+}
+
+template<bool map_vertices, bool map_edges>
+size_t GraphT<map_vertices,map_edges>::get_nlf_memory() const {
+  return nlf_counts_.size() * sizeof(vidType) +
+         nlf_labels_.size() * sizeof(vlabel_t) +
+         nlf_offsets_.size() * sizeof(eidType);
 }
 
 template<bool map_vertices, bool map_edges>
@@ -0,0 +1,199 @@
+#include "versioned_graph.h"
+#include "scan.h"
+
+typedef std::vector<std::shared_ptr<const VertexPage>> PageTable;
+
+// pages whose lists all point into the base CSR
+static PageTable make_view_pages(std::shared_ptr<const BaseCSR> base, vidType nv) {
+  PageTable pages((nv + VertexPage::PAGE_SIZE - 1) / VertexPage::PAGE_SIZE);
+  #pragma omp parallel for
+  for (size_t i = 0; i < pages.size(); i++) {
+    auto p = std::make_shared<VertexPage>();
+    p->base = base;
+    for (vidType j = 0; j < VertexPage::PAGE_SIZE; j++) {
+      vidType v = std::min(nv, vidType(i * VertexPage::PAGE_SIZE + j));
+      p->lists[j] = base->colidx.data() + base->rowptr[v];
+      p->degrees[j] = v < nv ? base->rowptr[v+1] - base->rowptr[v] : 0;
+    }
+    pages[i] = p;
+  }
+  return pages;
+}
+
+size_t GraphSnapshot::get_memory() const {
+  size_t bytes = pages.size() * sizeof(std::shared_ptr<const VertexPage>);
+  for (auto &p : pages) bytes += p->get_memory();
+  return bytes;
+}
+
+VersionedGraph::VersionedGraph(Graph &g) :
+    num_owned_lists(0), n_compactions(0), stopping(false), compaction_threshold(0),
+    compacted_version(uint64_t(-1)) {
+  auto nv = g.V();
+  auto base = std::make_shared<BaseCSR>();
+  base->rowptr.assign(g.rowptr(), g.rowptr() + nv + 1);
+  base->colidx.assign(g.colidx(), g.colidx() + g.E());
+  current = std::make_shared<GraphSnapshot>(0, nv, g.E(), make_view_pages(base, nv));
+}
+
+SnapshotPtr VersionedGraph::snapshot() const {
+  std::lock_guard<std::mutex> lock(snapshot_mutex);
+  return current;
+}
+
+void VersionedGraph::publish(SnapshotPtr s) {
+  std::lock_guard<std::mutex> lock(snapshot_mutex);
+  current = s;
+}
+
+uint64_t VersionedGraph::apply_batch(EdgeBatch inserts, EdgeBatch deletes) {
+  sort_edge_batch(inserts, true);
+  sort_edge_batch(deletes, true);
+  std::lock_guard<std::mutex> lock(update_mutex);
+  auto cur = snapshot();
+  auto nv = cur->V();
+
+  // the vertices touched by the batch
+  VertexList touched;
+  for (auto &e : inserts) {
+    assert(e.first < nv && e.second < nv);
+    if (touched.empty() || touched.back() != e.first) touched.push_back(e.first);
+  }
+  for (auto &e : deletes)
+    if (touched.empty() || touched.back() != e.first) touched.push_back(e.first);
+  std::sort(touched.begin(), touched.end());
+  touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+
+  // new lists of the touched vertices: (old - deletes) + inserts
+  std::vector<std::shared_ptr<VertexList>> lists(touched.size());
+  int64_t num_changed = 0;
+  #pragma omp parallel for reduction(+:num_changed) schedule(dynamic, 64)
+  for (size_t t = 0; t < touched.size(); t++) {
+    auto v = touched[t];
+    auto by_src = [](const std::pair<vidType,vidType> &e, vidType u) { return e.first < u; };
+    auto ins = std::lower_bound(inserts.begin(), inserts.end(), v, by_src);
+    auto del = std::lower_bound(deletes.begin(), deletes.end(), v, by_src);
+    auto old = cur->N(v);
+    auto adj = old.begin(), adj_end = old.end();
+    auto list = std::make_shared<VertexList>();
+    list->reserve(old.size() + (std::lower_bound(ins, inserts.end(), v+1, by_src) - ins));
+    while (adj != adj_end || (ins != inserts.end() && ins->first == v)) {
+      bool from_old = adj != adj_end;
+      bool from_ins = ins != inserts.end() && ins->first == v;
+      vidType u;
+      if (from_old && from_ins && *adj == ins->second) { u = *adj++; ins++; }
+      else if (from_old && (!from_ins || *adj < ins->second)) {
+        u = *adj++;
+        while (del != deletes.end() && del->first == v && del->second < u) del++;
+        if (del != deletes.end() && del->first == v && del->second == u) { num_changed--; continue; }
+      } else {
+        u = (ins++)->second;
+        if (u == v) continue;
+        num_changed++;
+      }
+      list->push_back(u);
+    }
+    lists[t] = list;
+  }
+
+  // copy the pages holding the touched vertices and point them to the new lists
+  std::vector<size_t> page_begins; // range of each touched page in 'touched'
+  for (size_t t = 0; t < touched.size(); t++)
+    if (t == 0 || (touched[t] >> VertexPage::PAGE_BITS) != (touched[t-1] >> VertexPage::PAGE_BITS))
+      page_begins.push_back(t);
+  page_begins.push_back(touched.size());
+  PageTable pages = cur->pages;
+  int64_t num_new_owned = 0;
+  #pragma omp parallel for reduction(+:num_new_owned)
+  for (size_t k = 0; k < page_begins.size() - 1; k++) {
+    auto pid = touched[page_begins[k]] >> VertexPage::PAGE_BITS;
+    auto p = std::make_shared<VertexPage>(*pages[pid]);
+    for (auto t = page_begins[k]; t < page_begins[k+1]; t++) {
+      auto i = touched[t] & (VertexPage::PAGE_SIZE-1);
+      if (!p->owned[i]) { p->num_owned++; num_new_owned++; }
+      p->owned[i] = lists[t];
+      p->lists[i] = lists[t]->data();
+      p->degrees[i] = lists[t]->size();
+    }
+    pages[pid] = p;
+  }
+  auto s = std::make_shared<GraphSnapshot>(cur->version() + 1, nv, cur->E() + num_changed, std::move(pages));
+  publish(s);
+  num_owned_lists += num_new_owned;
+  if (compaction_threshold > 0 && num_owned_lists > compaction_threshold) {
+    { std::lock_guard<std::mutex> lk(compactor_mutex); }
+    compactor_cv.notify_one();
+  }
+  return s->version();
+}
+
+// Build a new base CSR from the latest snapshot outside of any lock, then swap in
+// views of it for the pages that have not been modified in the meantime; if all the pages
+// with owned lists were modified, nothing is freed and nothing is installed.
+void VersionedGraph::compact() {
+  auto snap = snapshot();
+  auto nv = snap->V();
+  auto base = std::make_shared<BaseCSR>();
+  base->rowptr.resize(nv + 1);
+  #pragma omp parallel for
+  for (vidType v = 0; v < nv; v++)
+    base->rowptr[v] = snap->get_degree(v);
+  parallel_prefix_sum_inplace(base->rowptr.data(), nv);
+  base->colidx.resize(base->rowptr[nv]);
+  #pragma omp parallel for schedule(dynamic, 1024)
+  for (vidType v = 0; v < nv; v++) {
+    auto adj = snap->N(v);
+    std::copy(adj.begin(), adj.end(), base->colidx.begin() + base->rowptr[v]);
+  }
+  auto views = make_view_pages(base, nv);
+
+  std::lock_guard<std::mutex> lock(update_mutex);
+  auto cur = snapshot();
+  PageTable pages = cur->pages;
+  size_t num_owned = 0, num_freed = 0;
+  for (size_t i = 0; i < pages.size(); i++) {
+    if (cur->pages[i] == snap->pages[i]) {
+      num_freed += pages[i]->num_owned;
+      pages[i] = views[i];
+    } else num_owned += pages[i]->num_owned;
+  }
+  compacted_version = cur->version();
+  if (num_freed == 0) return;
+  // same content, hence the same version
+  publish(std::make_shared<GraphSnapshot>(cur->version(), nv, cur->E(), std::move(pages)));
+  num_owned_lists = num_owned;
+  n_compactions++;
+}
+
+void VersionedGraph::start_compaction(size_t threshold) {
+  assert(threshold > 0 && !compactor.joinable());
+  compaction_threshold = threshold;
+  stopping = false;
+  compacted_version = uint64_t(-1); // no pass yet
+  compactor = std::thread([this]() {
+    while (true) {
+      std::unique_lock<std::mutex> lk(compactor_mutex);
+      // a pass runs only on a version newer than the one the last pass ended at: when the
+      // owned lists stay above the threshold after a pass (the writer modified their pages
+      // in the meantime), the next pass waits for the next batch instead of spinning
+      compactor_cv.wait(lk, [this]() {
+        return stopping || (num_owned_lists > compaction_threshold && snapshot()->version() != compacted_version);
+      });
+      if (stopping) break;
+      lk.unlock();
+      compact();
+    }
+  });
+}
+
+void VersionedGraph::stop_compaction() {
+  if (!compactor.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lk(compactor_mutex);
+    stopping = true;
+  }
+  compactor_cv.notify_one();
+  compactor.join();
+  compaction_threshold = 0;
+}
+
@@ -1,6 +1,6 @@
 // Copyright 2020, MIT
 // Authors: Xuhao Chen <cxh@mit.edu>
-#include "graph.h"
+#include "graph_kernels.h"
 
 void CCSolver(Graph &g, comp_t *comp) {
   int num_threads = 1;
@@ -17,30 +17,9 @@ void CCSolver(Graph &g, comp_t *comp) {
   Timer t;
   t.Start();
   while (change) {
-    change = false;
     iter++;
     //printf("Executing iteration %d ...\n", iter);
-    #pragma omp parallel for schedule(dynamic, 64)
-    for (vidType src = 0; src < g.V(); src ++) {
-      auto comp_src = comp[src];
-      for (auto dst : g.N(src)) {
-        auto comp_dst = comp[dst];
-        if (comp_src == comp_dst) continue;
-        // Hooking condition so lower component ID wins independent of direction
-        int high_comp = comp_src > comp_dst ? comp_src : comp_dst;
-        int low_comp = comp_src + (comp_dst - high_comp);
-        if (high_comp == comp[high_comp]) {
-          change = true;
-          comp[high_comp] = low_comp;
-        }
-      }
-    }
-    #pragma omp parallel for
-    for (vidType n = 0; n < g.V(); n++) {
-      while (comp[n] != comp[comp[n]]) {
-        comp[n] = comp[comp[n]];
-      }
-    }
+    change = cc_step(g, comp);
   }
   t.Stop();
   std::cout << "iterations = " << iter << "\n";
@@ -11,13 +11,15 @@ Converter::Converter(std::string file_type, std::string file_name, bool is_bipar
     readGraphFromGRFile(file_name, true);
   } else {
     if (file_type == "mtx") {
-      read_mtx(file_name, is_bipartite);
-      if (has_edge_weights) weighted_adjlist2CSR();
-      else adjlist2CSR();
-    } else if (file_type == "edges") {
-      // plain edgelist format
-      read_edgelist(file_name);
-      edgelist2CSR();
+      // unweighted (pattern) matrices go through the parallel path
+      if (!read_text_parallel(file_name, file_type, is_bipartite)) {
+        read_mtx(file_name, is_bipartite);
+        if (has_edge_weights) weighted_adjlist2CSR();
+        else adjlist2CSR();
+      }
+    } else if (file_type == "edges" || file_type == "snap") {
+      // plain edgelist format, 1-based (edges) or 0-based (snap) vertex IDs
+      read_text_parallel(file_name, file_type, is_bipartite);
     } else {
       read_lg(file_name);
       edgelist2CSR();
@@ -38,7 +40,7 @@ void Converter::adjlist2CSR() {
     std::cout << "]\n";
   }
   */
-  g = new Graph(nv, ne);
+  g = new Graph(vidType(nv), eidType(ne));
   degrees.resize(nv);
   for (vidType i = 0; i < g->V(); i ++)
     degrees[i] = adj_lists[i].size();
@@ -67,7 +69,7 @@ void Converter::adjlist2CSR() {
 void Converter::weighted_adjlist2CSR() {
   printf("|V| %ld |E| %ld\n", nv, ne);
   weights.resize(ne);
-  g = new Graph(nv, ne);
+  g = new Graph(vidType(nv), eidType(ne));
   degrees.resize(nv);
   for (vidType i = 0; i < g->V(); i ++)
     degrees[i] = weighted_adj_lists[i].size();
@@ -112,7 +114,7 @@ void Converter::weighted_edgelist2CSR() {
   // build CSR
   degrees.resize(nv);
   CountDegrees(el);
-  g = new Graph(nv, ne);
+  g = new Graph(vidType(nv), eidType(ne));
   std::vector<eidType> offsets(nv+1);
   parallel_prefix_sum<vidType,eidType>(degrees, offsets.data());
 
@@ -149,6 +151,8 @@ void Converter::weighted_edgelist2CSR() {
 
 void Converter::generate_binary_graph(std::string outfilename, bool v, bool e, bool vl, bool el) {
   g->write_to_file(outfilename, v, e);
+  g->compute_max_degree();
+  g->write_meta_info(outfilename);
   if (vl) {
     std::ofstream outfile((outfilename+".vlabel.bin").c_str(), std::ios::binary);
     if (!outfile) {
@@ -271,6 +275,206 @@ void Converter::read_edgelist(std::string infile_name) {
   nv = num;
 }
 
+// Parse the next unsigned integer in [p, end); returns false if the line has none
+static inline bool parse_uint(const char *&p, const char *end, uint64_t &x) {
+  while (p < end && unsigned(*p - '0') > 9) p++;
+  if (p == end) return false;
+  x = 0;
+  while (p < end && unsigned(*p - '0') <= 9) x = x * 10 + (*p++ - '0');
+  return true;
+}
+
+// Parse the edges "src dst ..." of the lines in [begin, end) into a COO block;
+// blank lines and comment lines starting with '#' or '%' are skipped
+static void parse_edge_lines(const char *begin, const char *end, uint64_t base, vidType dst_offset,
+                             bool symmetrize, EdgeList &block, uint64_t &max_vid) {
+  auto p = begin;
+  while (p < end) {
+    auto eol = static_cast<const char*>(memchr(p, '\n', end - p));
+    if (eol == NULL) eol = end;
+    while (p < eol && (*p == ' ' || *p == '\t')) p++;
+    uint64_t u = 0, v = 0;
+    if (p < eol && *p != '#' && *p != '%' && parse_uint(p, eol, u) && parse_uint(p, eol, v)) {
+      if (u < base || v < base) {
+        std::cout << "invalid vertex id in line: " << std::string(begin, eol - begin) << "\n";
+        exit(1);
+      }
+      u -= base;
+      v = v - base + dst_offset;
+      if (u != v) { // remove self-loop
+        assert(std::max(u, v) < std::numeric_limits<vidType>::max());
+        max_vid = std::max(max_vid, std::max(u, v));
+        block.push_back(Edge(u, v));
+        if (symmetrize) block.push_back(Edge(v, u));
+      }
+    }
+    p = eol + 1;
+    begin = p;
+  }
+}
+
+// High-throughput ingestion of text edge lists (edges, snap) and pattern .mtx files:
+// mmap the file, split it at newline boundaries across threads, parse into per-thread
+// COO blocks, and build the CSR with a counting sort on the source and per-row dedup.
+// Returns false if the file has to go through the sequential reader (weighted .mtx).
+bool Converter::read_text_parallel(std::string infile_name, std::string file_type, bool is_bipartite) {
+  std::cout << "Reading " << file_type << " file " << infile_name << " in parallel\n";
+  int fd = open(infile_name.c_str(), O_RDONLY);
+  if (fd == -1) {
+    std::cout << "Graph: unable to open " << infile_name << "\n";
+    exit(1);
+  }
+  struct stat buf;
+  if (fstat(fd, &buf) == -1) {
+    std::cout << "Graph: unable to stat " << infile_name << "\n";
+    exit(1);
+  }
+  size_t length = buf.st_size;
+  auto data = static_cast<const char*>(mmap(0, length, PROT_READ, MAP_PRIVATE, fd, 0));
+  if (data == MAP_FAILED) {
+    std::cout << "Graph: mmap failed.\n";
+    exit(1);
+  }
+  close(fd);
+  madvise((void*)data, length, MADV_SEQUENTIAL);
+
+  uint64_t base = file_type == "snap" ? 0 : 1;
+  bool symmetrize = true;
+  vidType dst_offset = 0;
+  uint64_t num_rows = 0;
+  const char *start = data, *end = data + length;
+  if (file_type == "mtx") {
+    std::string header(start, static_cast<const char*>(memchr(start, '\n', length)) - start);
+    std::istringstream hs(header);
+    std::string banner, object, format, field, symmetry;
+    hs >> banner >> object >> format >> field >> symmetry;
+    if (banner != "%%MatrixMarket" || object != "matrix" || format != "coordinate" || field != "pattern") {
+      munmap((void*)data, length);
+      return false;
+    }
+    symmetrize = is_bipartite || symmetry == "symmetric";
+    // skip the comments and the size line "m n nnz"
+    while (start < end && (*start == '%' || *start == '\n'))
+      start = static_cast<const char*>(memchr(start, '\n', end - start)) + 1;
+    uint64_t m = 0, n = 0, nnz = 0;
+    parse_uint(start, end, m);
+    parse_uint(start, end, n);
+    parse_uint(start, end, nnz);
+    std::cout << "m=" << m << " n=" << n << " nnz=" << nnz << "\n";
+    if (!is_bipartite && m != n) {
+      std::cout << "matrix must be square for .mtx unless it is a bipartite graph" << std::endl;
+      std::exit(-26);
+    }
+    if (is_bipartite) dst_offset = m;
+    num_rows = is_bipartite ? m + n : m;
+  }
+
+  Timer t;
+  t.Start();
+  int num_threads = 1;
+  #pragma omp parallel
+  {
+    num_threads = omp_get_num_threads();
+  }
+  std::vector<EdgeList> blocks(num_threads);
+  uint64_t max_vid = 0;
+  #pragma omp parallel reduction(max:max_vid)
+  {
+    int tid = omp_get_thread_num();
+    size_t chunk = (end - start) / num_threads;
+    // each thread owns the lines starting in [first, last)
+    auto first = start + chunk * tid;
+    auto last = tid == num_threads-1 ? end : start + chunk * (tid+1);
+    if (tid > 0) {
+      while (first < end && first[-1] != '\n') first++;
+    }
+    while (last < end && last[-1] != '\n') last++;
+    if (first < last) {
+      blocks[tid].reserve((last - first) / 8);
+      parse_edge_lines(first, last, base, dst_offset, symmetrize, blocks[tid], max_vid);
+    }
+  }
+  munmap((void*)data, length);
+  t.Stop();
+  uint64_t num_edges = 0;
+  for (auto &block : blocks) num_edges += block.size();
+  nv = std::max(num_rows, num_edges ? max_vid + 1 : 0);
+  std::cout << "parsed " << num_edges << " edges from " << length << " bytes in " << t.Seconds()
+            << " sec (" << length / 1000000.0 / t.Seconds() << " MB/s)\n";
+  coo2CSR(blocks);
+  return true;
+}
+
+// Build the CSR from per-thread COO blocks with a two-pass radix sort on the source
+// vertex: partition the edges into buckets of 2^shift sources (per-block histograms,
+// no atomics), then counting sort each bucket locally; finally sort and deduplicate
+// each row in parallel
+void Converter::coo2CSR(std::vector<EdgeList> &blocks) {
+  Timer t;
+  t.Start();
+  const int shift = 12;
+  size_t num_blocks = blocks.size();
+  size_t num_buckets = (nv >> shift) + 1;
+  // counts[b*num_blocks+i]: number of edges of block i in bucket b
+  std::vector<eidType> counts(num_buckets * num_blocks + 1, 0);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t i = 0; i < num_blocks; i++)
+    for (auto &e : blocks[i]) counts[(e.src >> shift) * num_blocks + i]++;
+  parallel_prefix_sum_inplace<eidType>(counts.data(), num_buckets * num_blocks);
+  EdgeList edges(counts[num_buckets * num_blocks]);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t i = 0; i < num_blocks; i++) {
+    std::vector<eidType> pos(num_buckets);
+    for (size_t b = 0; b < num_buckets; b++) pos[b] = counts[b * num_blocks + i];
+    for (auto &e : blocks[i]) edges[pos[e.src >> shift]++] = e;
+    EdgeList().swap(blocks[i]);
+  }
+
+  degrees.assign(nv, 0);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t b = 0; b < num_buckets; b++)
+    for (auto e = counts[b * num_blocks]; e < counts[(b+1) * num_blocks]; e++)
+      degrees[edges[e].src]++;
+  std::vector<eidType> offsets(nv+1);
+  parallel_prefix_sum<vidType,eidType>(degrees, offsets.data());
+  VertexList colidx(offsets[nv]);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t b = 0; b < num_buckets; b++) {
+    vidType first_vertex = b << shift;
+    vidType last_vertex = std::min(uint64_t(b+1) << shift, nv);
+    if (first_vertex >= last_vertex) continue;
+    std::vector<eidType> pos(offsets.begin() + first_vertex, offsets.begin() + last_vertex);
+    for (auto e = counts[b * num_blocks]; e < counts[(b+1) * num_blocks]; e++)
+      colidx[pos[edges[e].src - first_vertex]++] = edges[e].dst;
+  }
+  EdgeList().swap(edges);
+
+  // remove redundant edges
+  #pragma omp parallel for schedule(dynamic, 1024)
+  for (vidType v = 0; v < nv; v++) {
+    auto first = colidx.begin() + offsets[v];
+    auto last = colidx.begin() + offsets[v+1];
+    std::sort(first, last);
+    degrees[v] = std::unique(first, last) - first;
+  }
+  std::vector<eidType> new_offsets(nv+1);
+  parallel_prefix_sum<vidType,eidType>(degrees, new_offsets.data());
+  ne = new_offsets[nv];
+  std::cout << "removed " << offsets[nv] - ne << " redundant edges\n";
+  printf("|V| %ld |E| %ld\n", nv, ne);
+  g = new Graph(vidType(nv), eidType(ne));
+  #pragma omp parallel for schedule(dynamic, 1024)
+  for (vidType v = 0; v < nv; v++) {
+    g->fixEndEdge(v, new_offsets[v+1]);
+    std::copy(colidx.begin() + offsets[v], colidx.begin() + offsets[v] + degrees[v],
+              g->colidx() + new_offsets[v]);
+  }
+  auto max_degree = nv ? *(std::max_element(degrees.begin(), degrees.end())) : 0;
+  std::cout << "maximum degree: " << max_degree << "\n";
+  t.Stop();
+  std::cout << "Time building CSR: " << t.Seconds() << " sec\n";
+}
+
 void Converter::read_lg(std::string infile_name) {
   std::cout << "Reading TXT/LG file " << infile_name << "\n";
   std::ifstream infile;
@@ -471,7 +675,7 @@ void Converter::readGraphFromGRFile(std::string filename, bool need_sort) {
     //exit(1);
   }
   std::cout << "constructing CSR: nv " << nv << " ne " << ne << "\n";
-  g = new Graph(nv, ne);
+  g = new Graph(vidType(nv), eidType(ne));
   auto rowptr = g->out_rowptr();
   #pragma omp parallel for
   for (vidType vid = 0; vid < g->V(); ++vid) {
@@ -573,10 +777,12 @@ size_t Converter::read_masks(std::string mask_type, std::string filename, size_t
   return sample_count;
 }
 
-void Converter::splitGRFile(std::string filename, std::string outfilename) {
+// Convert a Galois .gr file in one streaming pass. Without need_sort the CSR arrays
+// are copied as is; with need_sort the edges are processed in blocks of consecutive
+// vertices: the neighbor lists of a block are sorted and cleaned (self-loops and
+// redundant edges removed) in parallel, and the block is appended to the output.
+void Converter::splitGRFile(std::string filename, std::string outfilename, bool need_sort) {
   std::cout << "Reading " << filename << " graph into CPU memory\n";
-  std::ifstream ifs;
-  ifs.open(filename);
   int masterFD = open(filename.c_str(), O_RDONLY);
   if (masterFD == -1) {
     std::cout << "Graph: unable to open " << filename << "\n";
@@ -596,52 +802,107 @@ void Converter::splitGRFile(std::string filename, std::string outfilename) {
     std::cout << "Graph: mmap failed.\n";
     exit(1);
   }
-  Timer t;
-  t.Start();
+  close(masterFD);
+  madvise(m, masterLength, MADV_SEQUENTIAL);
   uint64_t* fptr = (uint64_t*)m;
   __attribute__((unused)) uint64_t version = le64toh(*fptr++);
   assert(version == 1);
   uint64_t sizeEdgeTy = le64toh(*fptr++);
   nv = le64toh(*fptr++);
-  //assert(nv < 2147483648); // assuming 31-bit (signed integer) vertex IDs
+  assert(nv < std::numeric_limits<vidType>::max());
   ne = le64toh(*fptr++);
-  uint64_t* outIdx = fptr;
+  uint64_t* outIdx = fptr; // outIdx[v] is the end of the neighbor list of v
   fptr += nv;
-  uint32_t* fptr32 = (uint32_t*)fptr;
-  uint32_t* outs = fptr32;
-  fptr32 += ne;
-  if (ne % 2) fptr32 += 1;
+  uint32_t* outs = (uint32_t*)fptr;
   if (sizeEdgeTy != 0) {
     std::cout << "sizeEdgeType = " << sizeEdgeTy << "\n";
     std::cout << "Graph: currently edge data not supported.\n";
-    //exit(1);
   }
-  // write rowptr
-  eidType head = 0;
   std::cout << "converting GR file: nv " << nv << " ne " << ne << "\n";
-  std::cout << "rowptr[ " << nv-1 << "] = " << outIdx[nv-1] << "\n";
-  ///*
-  if (nv) {
-    std::ofstream outfile((outfilename+".vertex.bin").c_str(), std::ios::binary);
-    if (!outfile) {
-      std::cout << "File not available\n";
-      throw 1;
-    }
-    outfile.write(reinterpret_cast<const char*>(&head), sizeof(eidType));
-    outfile.write(reinterpret_cast<const char*>(outIdx), nv*sizeof(eidType));
-    outfile.close();
+  std::ofstream f_vertex((outfilename+".vertex.bin").c_str(), std::ios::binary);
+  std::ofstream f_edge((outfilename+".edge.bin").c_str(), std::ios::binary);
+  if (!f_vertex || !f_edge) {
+    std::cout << "File not available\n";
+    throw 1;
   }
-  //*/
-  ///*
-  if (ne) {
-    std::ofstream outfile1((outfilename+".edge.bin").c_str(), std::ios::binary);
-    if (!outfile1) {
-      std::cout << "File not available\n";
-      throw 1;
+  eidType head = 0;
+  vidType max_degree = 0;
+  f_vertex.write(reinterpret_cast<const char*>(&head), sizeof(eidType));
+  if (!need_sort) {
+    f_vertex.write(reinterpret_cast<const char*>(outIdx), nv*sizeof(eidType));
+    f_edge.write(reinterpret_cast<const char*>(outs), ne*sizeof(vidType));
+    #pragma omp parallel for reduction(max:max_degree)
+    for (vidType v = 0; v < nv; v++) {
+      vidType degree = outIdx[v] - (v == 0 ? 0 : outIdx[v-1]);
+      if (degree > max_degree) max_degree = degree;
     }
-    outfile1.write(reinterpret_cast<const char*>(outs), ne*sizeof(vidType));
-    outfile1.close();
-  }
-  //*/
+  } else {
+    const eidType block_size = eidType(1) << 26; // edges per block
+    VertexList in_block, out_block;
+    std::vector<eidType> offsets;
+    eidType num_edges = 0, num_removed = 0;
+    for (vidType v_begin = 0; v_begin < nv; ) {
+      eidType e_begin = v_begin == 0 ? 0 : outIdx[v_begin-1];
+      // the block ends at the first vertex whose list crosses e_begin + block_size
+      vidType v_end = std::upper_bound(outIdx + v_begin, outIdx + nv, e_begin + block_size) - outIdx;
+      if (v_end == v_begin) v_end = v_begin + 1; // a single vertex larger than a block
+      eidType e_end = outIdx[v_end-1];
+      vidType nv_block = v_end - v_begin;
+      in_block.resize(e_end - e_begin);
+      degrees.resize(nv_block);
+      #pragma omp parallel for schedule(dynamic, 64) reduction(max:max_degree)
+      for (vidType i = 0; i < nv_block; i++) {
+        auto v = v_begin + i;
+        eidType begin = (v == 0 ? 0 : outIdx[v-1]) - e_begin;
+        eidType end = outIdx[v] - e_begin;
+        auto adj = in_block.data();
+        for (auto e = begin; e < end; e++) {
+          adj[e] = le32toh(outs[e_begin+e]);
+          if (adj[e] >= nv) {
+            printf("\tinvalid edge from %u to %u\n", v, adj[e]);
+            exit(1);
+          }
+        }
+        std::sort(adj + begin, adj + end);
+        vidType n = std::unique(adj + begin, adj + end) - (adj + begin);
+        auto self = std::lower_bound(adj + begin, adj + begin + n, v);
+        if (self != adj + begin + n && *self == v) { // remove the self-loop
+          std::copy(self + 1, adj + begin + n, self);
+          n--;
+        }
+        degrees[i] = n;
+        if (n > max_degree) max_degree = n;
+      }
+      offsets.resize(nv_block+1);
+      parallel_prefix_sum<vidType,eidType>(degrees, offsets.data());
+      out_block.resize(offsets[nv_block]);
+      #pragma omp parallel for schedule(dynamic, 64)
+      for (vidType i = 0; i < nv_block; i++) {
+        auto v = v_begin + i;
+        eidType begin = (v == 0 ? 0 : outIdx[v-1]) - e_begin;
+        std::copy(in_block.data() + begin, in_block.data() + begin + degrees[i], out_block.data() + offsets[i]);
+      }
+      #pragma omp parallel for
+      for (vidType i = 1; i <= nv_block; i++)
+        offsets[i] += num_edges;
+      f_vertex.write(reinterpret_cast<const char*>(offsets.data() + 1), nv_block*sizeof(eidType));
+      f_edge.write(reinterpret_cast<const char*>(out_block.data()), out_block.size()*sizeof(vidType));
+      num_edges += out_block.size();
+      num_removed += (e_end - e_begin) - out_block.size();
+      std::cout << "  vertices [" << v_begin << ", " << v_end << "): " << out_block.size() << " edges\n";
+      v_begin = v_end;
+    }
+    std::cout << "removed " << num_removed << " self-loops and redundant edges\n";
+    ne = num_edges;
+  }
+  f_vertex.close();
+  f_edge.close();
+  munmap(m, masterLength);
+  std::ofstream f_meta((outfilename+".meta.txt").c_str());
+  f_meta << nv << "\n" << ne << "\n";
+  f_meta << sizeof(vidType) << " " << sizeof(eidType) << " " << sizeof(vlabel_t) << " " << sizeof(elabel_t) << "\n";
+  f_meta << max_degree << "\n0\n0\n0\n";
+  f_meta.close();
+  printf("|V| %ld |E| %ld\n", nv, ne);
+  std::cout << "max_degree: " << max_degree << "\n";
 }
-
@@ -10,6 +10,7 @@ struct Edge {
   vidType src;
   vidType dst;
 
+  Edge() : src(0), dst(0) {}
   Edge(vidType s, vidType d) {
     src = s; dst = d;
   }
@@ -73,6 +74,7 @@ public:
   Converter() : nv(0), ne(0), has_edge_weights(false), g(NULL) {}
   Converter(std::string file_type, std::string file_name, bool is_bipartite);
   void read_edgelist(std::string infile_name);
+  bool read_text_parallel(std::string infile_name, std::string file_type, bool is_bipartite);
   void read_sadj(std::string infile_name);
   void read_lg(std::string filename);
   void read_mtx(std::string filename, bool is_bipartite);
@@ -80,7 +82,7 @@ public:
   void readGraphFromGRFile(std::string filename, bool need_sort = false);
   void read_labels(std::string filename, size_t num_classes, bool is_single_class);
   size_t read_masks(std::string mask_type, std::string filename, size_t begin_, size_t end_, mask_t* masks);
-  void splitGRFile(std::string filename, std::string outfilename);
+  void splitGRFile(std::string filename, std::string outfilename, bool need_sort = false);
 
 private:
   uint64_t nv;
@@ -97,6 +99,7 @@ private:
   Graph *g;
 
   void edgelist2CSR();
+  void coo2CSR(std::vector<EdgeList> &blocks);
   void weighted_edgelist2CSR();
   void adjlist2CSR();
   void weighted_adjlist2CSR();
@@ -1,10 +1,11 @@
 // Copyright 2022 MIT
 // Contact: Xuhao Chen <cxh@mit.edu>
 #include "converter.h"
+#include <sys/resource.h>
 
 int main(int argc, char *argv[]) {
   if (argc < 4) {
-    printf("Usage: %s <input_file> <outpt_prefix>\n", argv[0]);
+    printf("Usage: %s <file_type(gr|edges|snap|mtx|lg)> <input_file> <output_prefix> [need_sort(0)] [is_bipartite(0)] [write_vlabel(0)] [write_elabel(0)]\n", argv[0]);
     printf("Example: %s gr ../galois_inputs/mico.gr ../inputs/mico/graph 1 0 0 0\n", argv[0]);
     exit(1);
   }
@@ -17,18 +18,21 @@ int main(int argc, char *argv[]) {
   //if (argc>7) write_feats = atoi(argv[7]);
   //if (argc>8) write_masks = atoi(argv[8]);
  
-  //Converter converter(argv[1], argv[2], is_bipartite);
-  //converter.generate_binary_graph(argv[3], 1, 1, write_vlabel, write_elabel);
-
-  Converter converter;
-  std::cout << argv[1] << "\n";
-  assert(argv[1] == "gr");
-  converter.splitGRFile(argv[2], argv[3]);
-  if (need_sort) {
-    Graph g(argv[2]);
-    g.sort_neighbors();
-    g.write_to_file(argv[2]);
+  Timer t;
+  t.Start();
+  std::string file_type = argv[1];
+  if (file_type == "gr") {
+    Converter converter;
+    converter.splitGRFile(argv[2], argv[3], need_sort);
+  } else {
+    Converter converter(file_type, argv[2], is_bipartite);
+    converter.generate_binary_graph(argv[3], 1, 1, write_vlabel, write_elabel);
   }
+  t.Stop();
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  std::cout << "runtime [converter] = " << t.Seconds() << " sec\n";
+  std::cout << "peak RSS = " << usage.ru_maxrss / 1024.0 << " MB\n";
   return 0;
 }
 
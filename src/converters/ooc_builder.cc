@@ -0,0 +1,366 @@
+// Copyright 2022 MIT
+// Out-of-core graph construction for graphs larger than memory.
+// Edges are read in runs that fit in the memory budget, each run is sorted and
+// written to disk, and the runs are merged (k-way, multi-pass if needed) into the
+// CSR binary format. Self-loops are removed when reading, redundant edges during
+// sorting and merging; symmetrization adds the reverse edge when reading and
+// orientation (by degree, as in GraphT::orientation) is applied during the final merge.
+// Only the degree array (4 bytes per vertex, when orienting) lives outside the budget.
+#include "graph.h"
+#include <queue>
+
+typedef uint64_t EdgeKey; // (src << 32) | dst, so ordering keys orders edges by (src, dst)
+static inline EdgeKey make_key(vidType src, vidType dst) { return (EdgeKey(src) << 32) | dst; }
+static inline vidType key_src(EdgeKey e) { return vidType(e >> 32); }
+static inline vidType key_dst(EdgeKey e) { return vidType(e & 0xffffffff); }
+
+static const size_t min_run_buffer = 1 << 16; // minimum read buffer per merged run, in edges
+
+// disk traffic of one phase
+class IOStats {
+public:
+  IOStats(std::string name) : name_(name), bytes_read(0), bytes_written(0) { t_.Start(); }
+  void print() {
+    t_.Stop();
+    auto secs = std::max(t_.Seconds(), 1e-9);
+    std::cout << "  [" << name_ << "] read " << bytes_read / 1048576.0 << " MB, wrote "
+              << bytes_written / 1048576.0 << " MB in " << t_.Seconds() << " sec ("
+              << (bytes_read + bytes_written) / 1048576.0 / secs << " MB/s)\n";
+  }
+  std::string name_;
+  uint64_t bytes_read, bytes_written;
+private:
+  Timer t_;
+};
+
+static FILE* open_file(std::string name, const char *mode) {
+  FILE *f = fopen(name.c_str(), mode);
+  if (f == NULL) {
+    perror(("Error opening " + name).c_str());
+    exit(EXIT_FAILURE);
+  }
+  return f;
+}
+
+// buffered sequential reader of a sorted run
+class RunReader {
+public:
+  RunReader(std::string name, size_t buffer_size, IOStats *stats) :
+      buffer_(buffer_size), pos_(0), len_(0), stats_(stats) {
+    f_ = open_file(name, "rb");
+  }
+  ~RunReader() { fclose(f_); }
+  bool next(EdgeKey &e) {
+    if (pos_ == len_) {
+      len_ = fread(buffer_.data(), sizeof(EdgeKey), buffer_.size(), f_);
+      stats_->bytes_read += len_ * sizeof(EdgeKey);
+      pos_ = 0;
+      if (len_ == 0) return false;
+    }
+    e = buffer_[pos_++];
+    return true;
+  }
+private:
+  FILE *f_;
+  std::vector<EdgeKey> buffer_;
+  size_t pos_, len_;
+  IOStats *stats_;
+};
+
+// streams edges sorted by (src, dst) into <prefix>.vertex.bin and <prefix>.edge.bin
+class CSRWriter {
+public:
+  CSRWriter(std::string prefix, vidType nv, IOStats *stats) :
+      nv_(nv), next_row_(0), ne_(0), max_degree_(0), degree_(0), stats_(stats) {
+    fv_ = open_file(prefix + ".vertex.bin", "wb");
+    fe_ = open_file(prefix + ".edge.bin", "wb");
+    buffer_.reserve(min_run_buffer);
+  }
+  void add(vidType src, vidType dst) {
+    if (src >= next_row_) {
+      degree_ = 0;
+      while (next_row_ <= src) write_rowptr();
+    }
+    buffer_.push_back(dst);
+    ne_++;
+    max_degree_ = std::max(max_degree_, ++degree_);
+    if (buffer_.size() == buffer_.capacity()) flush();
+  }
+  // finish the row pointers and write the meta file (same format as GraphT::write_meta_info)
+  void close(std::string prefix) {
+    flush();
+    while (next_row_ <= nv_) write_rowptr();
+    fclose(fv_);
+    fclose(fe_);
+    std::ofstream f_meta((prefix + ".meta.txt").c_str());
+    f_meta << nv_ << "\n" << ne_ << "\n";
+    f_meta << sizeof(vidType) << " " << sizeof(eidType) << " " << sizeof(vlabel_t) << " " << sizeof(elabel_t) << "\n";
+    f_meta << max_degree_ << "\n0\n0\n0\n";
+    f_meta.close();
+  }
+  eidType num_edges() const { return ne_; }
+  vidType max_degree() const { return max_degree_; }
+private:
+  FILE *fv_, *fe_;
+  vidType nv_, next_row_;
+  eidType ne_;
+  vidType max_degree_, degree_;
+  VertexList buffer_;
+  IOStats *stats_;
+  void write_rowptr() {
+    fwrite(&ne_, sizeof(eidType), 1, fv_);
+    stats_->bytes_written += sizeof(eidType);
+    next_row_++;
+  }
+  void flush() {
+    fwrite(buffer_.data(), sizeof(vidType), buffer_.size(), fe_);
+    stats_->bytes_written += buffer_.size() * sizeof(vidType);
+    buffer_.clear();
+  }
+};
+
+class ExternalGraphBuilder {
+public:
+  ExternalGraphBuilder(std::string tmp_prefix, size_t memory_budget, bool symmetrize, bool orient) :
+      tmp_prefix_(tmp_prefix), budget_(memory_budget / sizeof(EdgeKey)),
+      symmetrize_(symmetrize), orient_(orient), nv_(0), num_runs_created_(0),
+      num_input_edges_(0), num_selfloops_(0), stats_("run generation") {
+    assert(budget_ >= 4 * min_run_buffer);
+    buffer_.reserve(budget_);
+  }
+
+  void add_edge(vidType src, vidType dst) {
+    num_input_edges_++;
+    nv_ = std::max(nv_, std::max(src, dst) + 1);
+    if (src == dst) { num_selfloops_++; return; }
+    push(make_key(src, dst));
+    if (symmetrize_) push(make_key(dst, src));
+  }
+
+  void add_input_bytes(uint64_t n) { stats_.bytes_read += n; }
+
+  void build(std::string outfile_prefix, vidType nv) {
+    nv_ = std::max(nv_, nv);
+    if (!buffer_.empty()) write_run();
+    std::vector<EdgeKey>().swap(buffer_); // the merge buffers take the whole budget
+    stats_.print();
+    std::cout << "Read " << num_input_edges_ << " edges (" << num_selfloops_ << " self loops) into "
+              << runs_.size() << " sorted runs\n";
+    // multi-pass merge until all runs fit in one merge
+    size_t fan_in = std::max(size_t(2), budget_ / min_run_buffer - 1);
+    int pass = 0;
+    while (runs_.size() > fan_in) {
+      IOStats stats("merge pass " + std::to_string(pass++));
+      std::vector<std::string> merged;
+      for (size_t i = 0; i < runs_.size(); i += fan_in) {
+        std::vector<std::string> group(runs_.begin() + i, runs_.begin() + std::min(runs_.size(), i + fan_in));
+        auto name = run_name();
+        FILE *f = open_file(name, "wb");
+        std::vector<EdgeKey> out;
+        out.reserve(min_run_buffer);
+        merge(group, stats, [&](EdgeKey e) {
+          out.push_back(e);
+          if (out.size() == out.capacity()) {
+            fwrite(out.data(), sizeof(EdgeKey), out.size(), f);
+            stats.bytes_written += out.size() * sizeof(EdgeKey);
+            out.clear();
+          }
+        });
+        fwrite(out.data(), sizeof(EdgeKey), out.size(), f);
+        stats.bytes_written += out.size() * sizeof(EdgeKey);
+        fclose(f);
+        for (auto &r : group) remove(r.c_str());
+        merged.push_back(name);
+      }
+      runs_.swap(merged);
+      stats.print();
+      std::cout << "  " << runs_.size() << " runs left\n";
+    }
+
+    // orientation needs the degrees of the cleaned graph: count them in a merge without output
+    std::vector<vidType> degrees;
+    if (orient_) {
+      IOStats stats("degree counting");
+      degrees.resize(nv_, 0);
+      merge(runs_, stats, [&](EdgeKey e) { degrees[key_src(e)]++; });
+      stats.print();
+    }
+    IOStats stats("final merge");
+    CSRWriter writer(outfile_prefix, nv_, &stats);
+    merge(runs_, stats, [&](EdgeKey e) {
+      auto src = key_src(e), dst = key_dst(e);
+      if (orient_ && !(degrees[dst] > degrees[src] || (degrees[dst] == degrees[src] && dst > src)))
+        return;
+      writer.add(src, dst);
+    });
+    writer.close(outfile_prefix);
+    stats.print();
+    for (auto &r : runs_) remove(r.c_str());
+    std::cout << "|V| " << nv_ << " |E| " << writer.num_edges() << " max_degree " << writer.max_degree() << "\n";
+  }
+
+private:
+  std::string tmp_prefix_;
+  size_t budget_; // in edges
+  bool symmetrize_, orient_;
+  vidType nv_;
+  int num_runs_created_;
+  uint64_t num_input_edges_, num_selfloops_;
+  std::vector<EdgeKey> buffer_;
+  std::vector<std::string> runs_;
+  IOStats stats_;
+
+  std::string run_name() { return tmp_prefix_ + ".run" + std::to_string(num_runs_created_++) + ".bin"; }
+
+  void push(EdgeKey e) {
+    buffer_.push_back(e);
+    if (buffer_.size() == budget_) write_run();
+  }
+
+  // sort the buffer in parallel pieces, and write each deduplicated piece as a run
+  void write_run() {
+    int num_threads = 1;
+    #pragma omp parallel
+    {
+      num_threads = omp_get_num_threads();
+    }
+    size_t num_pieces = std::min(size_t(num_threads), (buffer_.size() + min_run_buffer - 1) / min_run_buffer);
+    size_t piece_size = (buffer_.size() + num_pieces - 1) / num_pieces;
+    std::vector<size_t> sizes(num_pieces);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < num_pieces; i++) {
+      auto first = buffer_.begin() + std::min(buffer_.size(), i * piece_size);
+      auto last = buffer_.begin() + std::min(buffer_.size(), (i+1) * piece_size);
+      std::sort(first, last);
+      sizes[i] = std::unique(first, last) - first;
+    }
+    for (size_t i = 0; i < num_pieces; i++) {
+      auto name = run_name();
+      FILE *f = open_file(name, "wb");
+      fwrite(buffer_.data() + i * piece_size, sizeof(EdgeKey), sizes[i], f);
+      fclose(f);
+      stats_.bytes_written += sizes[i] * sizeof(EdgeKey);
+      runs_.push_back(name);
+    }
+    std::cout << "  sorted " << buffer_.size() << " edges into " << num_pieces << " runs ("
+              << runs_.size() << " runs so far)\n";
+    buffer_.clear();
+  }
+
+  // k-way merge of sorted runs; each distinct edge is passed to sink once, in order
+  template <typename F>
+  void merge(const std::vector<std::string> &runs, IOStats &stats, F sink) {
+    size_t buffer_size = std::max(min_run_buffer, budget_ / (runs.size() + 1));
+    std::vector<RunReader*> readers;
+    typedef std::pair<EdgeKey, size_t> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    for (size_t i = 0; i < runs.size(); i++) {
+      readers.push_back(new RunReader(runs[i], buffer_size, &stats));
+      EdgeKey e;
+      if (readers[i]->next(e)) heap.push(Entry(e, i));
+    }
+    bool first = true;
+    EdgeKey last = 0;
+    while (!heap.empty()) {
+      auto top = heap.top();
+      heap.pop();
+      if (first || top.first != last) sink(top.first);
+      first = false;
+      last = top.first;
+      EdgeKey e;
+      if (readers[top.second]->next(e)) heap.push(Entry(e, top.second));
+    }
+    for (auto r : readers) delete r;
+  }
+};
+
+// read a text edge list ("src dst" per line, '#' and '%' lines are comments) in chunks
+template <typename F>
+static uint64_t read_text_edges(std::string filename, F add_edge) {
+  FILE *f = open_file(filename, "rb");
+  uint64_t num_bytes = 0, num_skipped = 0;
+  std::vector<char> chunk(1 << 24);
+  size_t carry = 0;
+  while (true) {
+    auto n = fread(chunk.data() + carry, 1, chunk.size() - carry, f);
+    num_bytes += n;
+    auto len = n + carry;
+    bool eof = len < chunk.size();
+    size_t end = len;
+    if (!eof) { // process complete lines only
+      while (end > 0 && chunk[end-1] != '\n') end--;
+      assert(end > 0);
+    }
+    const char *p = chunk.data(), *stop = chunk.data() + end;
+    while (p < stop) {
+      while (p < stop && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+      if (p == stop) break;
+      if (*p == '#' || *p == '%') {
+        while (p < stop && *p != '\n') p++;
+        continue;
+      }
+      uint64_t x[2] = {0, 0};
+      int digits[2] = {0, 0};
+      for (int i = 0; i < 2; i++) {
+        while (p < stop && (*p == ' ' || *p == '\t')) p++;
+        for (; p < stop && unsigned(*p - '0') <= 9; digits[i]++) x[i] = x[i] * 10 + (*p++ - '0');
+      }
+      if (digits[0] == 0 || digits[1] == 0) { // not an edge
+        num_skipped++;
+        while (p < stop && *p != '\n') p++;
+        continue;
+      }
+      assert(x[0] < std::numeric_limits<vidType>::max() && x[1] < std::numeric_limits<vidType>::max());
+      add_edge(vidType(x[0]), vidType(x[1]));
+      while (p < stop && *p != '\n') p++;
+    }
+    if (eof) break;
+    carry = len - end;
+    std::copy(chunk.begin() + end, chunk.begin() + len, chunk.begin());
+  }
+  fclose(f);
+  if (num_skipped > 0) std::cout << "Skipped " << num_skipped << " lines without two vertex ids\n";
+  return num_bytes;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 4) {
+    std::cout << "Usage: " << argv[0] << " <input> <output_prefix> <memory_budget_MB> [symmetrize(0)] [orient(0)] [tmp_prefix(output_prefix)]\n";
+    std::cout << "  input: a graph prefix in the binary CSR format, or a text edge list (0-based \"src dst\" lines)\n";
+    std::cout << "Example: " << argv[0] << " ~/datasets/wdc14/graph ~/datasets/wdc14-clean/graph 16384 1 0\n";
+    exit(1);
+  }
+  std::string input = argv[1];
+  std::string output = argv[2];
+  size_t budget = size_t(atol(argv[3])) << 20;
+  int symmetrize = 0, orient = 0;
+  if (argc > 4) symmetrize = atoi(argv[4]);
+  if (argc > 5) orient = atoi(argv[5]);
+  std::string tmp_prefix = output;
+  if (argc > 6) tmp_prefix = argv[6];
+  int num_threads = 1;
+  #pragma omp parallel
+  {
+    num_threads = omp_get_num_threads();
+  }
+  std::cout << "Out-of-core graph builder (" << num_threads << " threads), memory budget "
+            << (budget >> 20) << " MB, symmetrize " << symmetrize << ", orient " << orient << "\n";
+
+  Timer t;
+  t.Start();
+  ExternalGraphBuilder builder(tmp_prefix, budget, symmetrize, orient);
+  vidType nv = 0;
+  if (std::ifstream((input + ".meta.txt").c_str()).good()) {
+    OutOfCoreGraph g(input);
+    nv = g.V();
+    for (vidType v = 0; v < g.V(); v++)
+      for (auto u : g.N(v)) builder.add_edge(v, u);
+    builder.add_input_bytes((g.V()+1) * sizeof(eidType) + g.E() * sizeof(vidType));
+  } else {
+    builder.add_input_bytes(read_text_edges(input, [&](vidType u, vidType v) { builder.add_edge(u, v); }));
+  }
+  builder.build(output, nv);
+  t.Stop();
+  std::cout << "runtime [ooc_builder] = " << t.Seconds() << " sec\n";
+  return 0;
+}
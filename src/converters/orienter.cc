@@ -9,5 +9,6 @@ int main(int argc, char *argv[]) {
   g.orientation();
   g.compute_max_degree();
   g.write_to_file(argv[2]);
+  g.write_meta_info(argv[2]);
   return 0;
 } 
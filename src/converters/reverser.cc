@@ -0,0 +1,16 @@
+// Copyright 2022 MIT
+// Contact: Xuhao Chen <cxh@mit.edu>
+#include "graph.h"
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cout << "Usage: " << argv[0] << " <graph_prefix>\n";
+    std::cout << "Writes the in-edges of a directed graph as <graph_prefix>.reverse.{vertex,edge}.bin,\n"
+              << "which are then loaded instead of building the reverse graph\n";
+    exit(1);
+  }
+  Graph g(argv[1], false, true, false, false, true); // directed, with the reverse graph
+  g.print_meta_data();
+  g.write_reverse_graph(argv[1]);
+  return 0;
+}
@@ -0,0 +1,115 @@
+// Copyright 2020 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#pragma once
+#include "dynamic_graph.h"
+#include "platform_atomics.h"
+
+// Maintains the global and per-vertex triangle counts of an undirected DynamicGraph
+// under batches of edge insertions and deletions. A triangle gained (lost) by a batch
+// contains at least one inserted (deleted) edge, so only the common neighbors of the
+// endpoints of the batch edges are visited: the cost depends on the batch and the
+// degrees of its endpoints, not on the size of the graph.
+class IncrementalTC {
+public:
+  IncrementalTC(DynamicGraph &graph) : g(graph) {
+    assert(!g.is_directed());
+    recount(local_counts);
+    total = 0;
+    for (auto c : local_counts) total += c;
+    total /= 3;
+  }
+  uint64_t get_total() const { return total; }
+  int64_t get_local(vidType v) const { return local_counts[v]; }
+  const std::vector<int64_t>& get_local_counts() const { return local_counts; }
+
+  // Apply the deletions and then the insertions of a batch to the graph and update the
+  // counts. The batch is cleaned like sort_and_clean_neighbors() does it: self-loops and
+  // redundant edges are removed; insertions of existing edges and deletions of missing
+  // edges are ignored.
+  void apply_batch(EdgeBatch inserts, EdgeBatch deletes) {
+    clean_batch(deletes, true);
+    total -= count_with(deletes, -1);
+    g.delete_edges(deletes);
+    clean_batch(inserts, false);
+    g.insert_edges(inserts);
+    total += count_with(inserts, 1);
+  }
+
+  // count the triangles of each vertex from scratch
+  void recount(std::vector<int64_t> &counts) const {
+    counts.assign(g.V(), 0);
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (vidType u = 0; u < g.V(); u++) {
+      auto adj_u = g.N(u);
+      for (auto v : adj_u) {
+        if (v >= u) break;
+        auto adj_v = g.N(v);
+        vidType i = 0, j = 0;
+        while (i < adj_u.size() && j < adj_v.size() && adj_u[i] < v && adj_v[j] < v) {
+          if (adj_u[i] < adj_v[j]) i++;
+          else if (adj_u[i] > adj_v[j]) j++;
+          else {
+            fetch_and_add(counts[u], int64_t(1));
+            fetch_and_add(counts[v], int64_t(1));
+            fetch_and_add(counts[adj_u[i]], int64_t(1));
+            i++; j++;
+          }
+        }
+      }
+    }
+  }
+
+private:
+  DynamicGraph &g;
+  uint64_t total;
+  std::vector<int64_t> local_counts;
+
+  static std::pair<vidType,vidType> canonical(vidType u, vidType v) {
+    return u < v ? std::make_pair(u, v) : std::make_pair(v, u);
+  }
+
+  // keep each edge once as (min, max), sorted, without self-loops and duplicates,
+  // and only the edges that are (present) or are not (!present) in the graph
+  void clean_batch(EdgeBatch &batch, bool present) {
+    for (auto &e : batch) e = canonical(e.first, e.second);
+    sort_edge_batch(batch, false);
+    std::vector<uint8_t> keep(batch.size());
+    #pragma omp parallel for
+    for (size_t i = 0; i < batch.size(); i++)
+      keep[i] = batch[i].first != batch[i].second && g.is_connected(batch[i].first, batch[i].second) == present;
+    size_t n = 0;
+    for (size_t i = 0; i < batch.size(); i++)
+      if (keep[i]) batch[n++] = batch[i];
+    batch.resize(n);
+  }
+
+  // Count the triangles containing at least one edge of the (cleaned) batch in the
+  // current graph, and add 'sign' to the count of each of their vertices. A triangle
+  // with several batch edges is counted once, by the smallest of them.
+  uint64_t count_with(const EdgeBatch &batch, int64_t sign) {
+    auto in_batch = [&batch](vidType a, vidType b) {
+      return std::binary_search(batch.begin(), batch.end(), canonical(a, b));
+    };
+    uint64_t counter = 0;
+    #pragma omp parallel for reduction(+ : counter) schedule(dynamic, 1)
+    for (size_t k = 0; k < batch.size(); k++) {
+      auto u = batch[k].first, v = batch[k].second;
+      auto adj_u = g.N(u), adj_v = g.N(v);
+      vidType i = 0, j = 0;
+      while (i < adj_u.size() && j < adj_v.size()) {
+        if (adj_u[i] < adj_v[j]) { i++; continue; }
+        if (adj_u[i] > adj_v[j]) { j++; continue; }
+        auto w = adj_u[i];
+        i++; j++;
+        if (canonical(u, w) < batch[k] && in_batch(u, w)) continue;
+        if (canonical(v, w) < batch[k] && in_batch(v, w)) continue;
+        fetch_and_add(local_counts[u], sign);
+        fetch_and_add(local_counts[v], sign);
+        fetch_and_add(local_counts[w], sign);
+        counter++;
+      }
+    }
+    return counter;
+  }
+};
+
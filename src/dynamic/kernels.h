@@ -0,0 +1,53 @@
+// Copyright 2020 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#pragma once
+#include "graph_kernels.h"
+
+// The queries run on the dynamic graphs: the kernels of graph_kernels.h, shared with the
+// static baselines, driven to completion without the timing and the logging of the solvers.
+
+// the graph is undirected, with sorted neighbor lists
+template <typename GraphTy>
+uint64_t tc_kernel(GraphTy &g) {
+  return tc_count<false>(g);
+}
+
+template <typename GraphTy>
+void bfs_kernel(GraphTy &g, vidType source, VertexList &depth) {
+  depth.assign(g.V(), MYINFINITY);
+  depth[source] = 0;
+  SlidingQueue<vidType> queue(g.E());
+  queue.push_back(source);
+  queue.slide_window();
+  while (!queue.empty()) {
+    bfs_step(g, depth.data(), queue);
+    queue.slide_window();
+  }
+}
+
+template <typename GraphTy>
+int pr_kernel(GraphTy &g, std::vector<score_t> &scores) {
+  auto nv = g.V();
+  const score_t base_score = (1.0f - kDamp) / nv;
+  scores.assign(nv, 1.0f / nv);
+  std::vector<score_t> outgoing_contrib(nv);
+  int iter = 0;
+  for (; iter < MAX_ITER; iter ++) {
+    if (pr_step(g, scores.data(), outgoing_contrib.data(), base_score) < EPSILON) break;
+  }
+  return iter+1;
+}
+
+// returns the number of connected components
+template <typename GraphTy>
+vidType cc_kernel(GraphTy &g, std::vector<comp_t> &comp) {
+  comp.resize(g.V());
+  #pragma omp parallel for
+  for (vidType n = 0; n < g.V(); n ++) comp[n] = n;
+  while (cc_step(g, comp.data())) {}
+  vidType num_comps = 0;
+  #pragma omp parallel for reduction(+ : num_comps)
+  for (vidType n = 0; n < g.V(); n++)
+    if (comp[n] == comp_t(n)) num_comps++;
+  return num_comps;
+}
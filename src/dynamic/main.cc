@@ -0,0 +1,33 @@
+// Copyright 2020 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#include "graph.h"
+/*
+Dynamic graph: batched edge insertion and deletion on a per-vertex blocked adjacency
+(DynamicGraph in include/dynamic_graph.h). The edges of the input graph are inserted in
+shuffled batches, then the same TC/BFS/PR kernels are run on the static CSR and the dynamic
+graph to measure the query slowdown; finally a random fraction of the edges is deleted and
+re-inserted, and the result is checked against the input.
+
+dyn_omp_base: OpenMP implementation, parallel over the source vertices of each batch
+*/
+
+void DynamicSolver(Graph &g, int batch_size, double delete_ratio, int seed);
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cout << "Usage: " << argv[0] << " <graph> [batch_size(1000000)] [delete_ratio(0.5)] [seed(0)]\n";
+    std::cout << "Example: " << argv[0] << " ../inputs/citeseer/graph 10000\n";
+    exit(1);
+  }
+  int batch_size = 1000000;
+  double delete_ratio = 0.5;
+  int seed = 0;
+  if (argc > 2) batch_size = atoi(argv[2]);
+  if (argc > 3) delete_ratio = atof(argv[3]);
+  if (argc > 4) seed = atoi(argv[4]);
+  assert(batch_size > 0 && delete_ratio >= 0 && delete_ratio <= 1);
+  Graph g(argv[1], 0, 0, 0, 0, 0);
+  g.print_meta_data();
+  DynamicSolver(g, batch_size, delete_ratio, seed);
+  return 0;
+}
@@ -0,0 +1,87 @@
+// Copyright 2020 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#include <random>
+#include "graph.h"
+#include "dynamic_graph.h"
+#include "kernels.h"
+
+// apply the edges in batches and return the throughput in edges per second
+template <bool insert>
+double apply_batches(DynamicGraph &dg, const EdgeBatch &edges, int batch_size, eidType &num_changed) {
+  Timer t;
+  t.Start();
+  num_changed = 0;
+  for (size_t i = 0; i < edges.size(); i += batch_size) {
+    auto last = std::min(edges.size(), i + batch_size);
+    EdgeBatch batch(edges.begin() + i, edges.begin() + last);
+    num_changed += insert ? dg.insert_edges(batch) : dg.delete_edges(batch);
+  }
+  t.Stop();
+  return double(edges.size()) / t.Seconds();
+}
+
+bool same_graph(Graph &g, DynamicGraph &dg) {
+  if (g.E() != dg.E()) return false;
+  bool same = true;
+  #pragma omp parallel for reduction(&& : same)
+  for (vidType v = 0; v < g.V(); v++) {
+    auto adj = g.N(v), dadj = dg.N(v);
+    same = same && adj.size() == dadj.size() && std::equal(adj.begin(), adj.end(), dadj.begin());
+  }
+  return same;
+}
+
+// run a kernel on the static and the dynamic graph and report the slowdown
+template <typename F>
+void compare_query(std::string name, F kernel, Graph &g, DynamicGraph &dg) {
+  Timer t_static, t_dynamic;
+  t_static.Start();
+  auto expected = kernel(g);
+  t_static.Stop();
+  t_dynamic.Start();
+  auto result = kernel(dg);
+  t_dynamic.Stop();
+  std::cout << "runtime [" << name << "] static = " << t_static.Seconds() << " sec, dynamic = "
+            << t_dynamic.Seconds() << " sec, slowdown = " << t_dynamic.Seconds() / t_static.Seconds()
+            << (result == expected ? "" : " (results differ)") << "\n";
+}
+
+void DynamicSolver(Graph &g, int batch_size, double delete_ratio, int seed) {
+  int num_threads = 1;
+  #pragma omp parallel
+  {
+    num_threads = omp_get_num_threads();
+  }
+  std::cout << "OpenMP Dynamic Graph (" << num_threads << " threads), batch size = " << batch_size << "\n";
+  // each undirected edge once, in random order
+  EdgeBatch edges;
+  edges.reserve(g.E() / 2);
+  for (vidType v = 0; v < g.V(); v++)
+    for (auto u : g.N(v))
+      if (u > v) edges.push_back(std::make_pair(v, u));
+  std::mt19937_64 rng(seed);
+  std::shuffle(edges.begin(), edges.end(), rng);
+
+  DynamicGraph dg(g.V());
+  eidType num_changed = 0;
+  auto throughput = apply_batches<true>(dg, edges, batch_size, num_changed);
+  std::cout << "inserted " << num_changed << " edges, throughput = " << throughput << " edges/sec\n";
+  std::cout << "memory: static " << (g.V()+1) * sizeof(eidType) + g.E() * sizeof(vidType)
+            << " bytes, dynamic " << dg.get_memory() << " bytes\n";
+  if (!same_graph(g, dg)) std::cout << "Error: dynamic graph differs from the input after insertion\n";
+
+  compare_query("tc", [](auto &graph) { return tc_kernel(graph); }, g, dg);
+  compare_query("bfs", [](auto &graph) { VertexList depth; bfs_kernel(graph, 0, depth); return depth; }, g, dg);
+  compare_query("pr", [](auto &graph) { std::vector<score_t> scores; pr_kernel(graph, scores); return scores; }, g, dg);
+
+  // delete a random fraction of the edges and insert them back
+  std::shuffle(edges.begin(), edges.end(), rng);
+  edges.resize(size_t(edges.size() * delete_ratio));
+  throughput = apply_batches<false>(dg, edges, batch_size, num_changed);
+  std::cout << "deleted " << num_changed << " edges, throughput = " << throughput << " edges/sec\n";
+  throughput = apply_batches<true>(dg, edges, batch_size, num_changed);
+  std::cout << "re-inserted " << num_changed << " edges, throughput = " << throughput << " edges/sec\n";
+  if (same_graph(g, dg)) std::cout << "Correct\n";
+  else std::cout << "Wrong: dynamic graph differs from the input\n";
+}
+
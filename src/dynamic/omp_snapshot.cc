@@ -0,0 +1,121 @@
+// Copyright 2020 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#include <random>
+#include "graph.h"
+#include "versioned_graph.h"
+#include "kernels.h"
+
+// a snapshot is consistent if its lists are sorted, free of duplicates and
+// self-loops, symmetric, and add up to its edge count
+bool is_consistent(const GraphSnapshot &s) {
+  eidType num_edges = 0;
+  bool valid = true;
+  #pragma omp parallel for reduction(+ : num_edges) reduction(&& : valid) schedule(dynamic, 64)
+  for (vidType v = 0; v < s.V(); v++) {
+    auto adj = s.N(v);
+    num_edges += adj.size();
+    for (vidType i = 0; i < adj.size(); i++) {
+      auto u = adj[i];
+      valid = valid && u != v && (i == 0 || adj[i-1] < u) && s.is_connected(u, v);
+    }
+  }
+  return valid && num_edges == s.E();
+}
+
+bool same_graph(Graph &g, const GraphSnapshot &s) {
+  if (g.E() != s.E()) return false;
+  bool same = true;
+  #pragma omp parallel for reduction(&& : same)
+  for (vidType v = 0; v < g.V(); v++) {
+    auto adj = g.N(v), sadj = s.N(v);
+    same = same && adj.size() == sadj.size() && std::equal(adj.begin(), adj.end(), sadj.begin());
+  }
+  return same;
+}
+
+// Writer: each batch deletes a random slice of the edges and inserts back the slice deleted
+// by the previous batch. Reader: runs PR and CC on the latest snapshot until the writer is done.
+void DynamicSolver(Graph &g, int batch_size, double delete_ratio, int seed) {
+  int num_threads = 1;
+  #pragma omp parallel
+  {
+    num_threads = omp_get_num_threads();
+  }
+  std::cout << "OpenMP Versioned Graph (" << num_threads << " threads), batch size = " << batch_size << "\n";
+  EdgeBatch edges;
+  edges.reserve(g.E() / 2);
+  for (vidType v = 0; v < g.V(); v++)
+    for (auto u : g.N(v))
+      if (u > v) edges.push_back(std::make_pair(v, u));
+  std::mt19937_64 rng(seed);
+  std::shuffle(edges.begin(), edges.end(), rng);
+  edges.resize(size_t(edges.size() * delete_ratio));
+
+  std::vector<score_t> scores;
+  std::vector<comp_t> comp;
+  Timer t_pr, t_cc;
+  t_pr.Start();
+  pr_kernel(g, scores);
+  t_pr.Stop();
+  t_cc.Start();
+  auto num_comps = cc_kernel(g, comp);
+  t_cc.Stop();
+  std::cout << "static: " << num_comps << " components, runtime [pr] = " << t_pr.Seconds()
+            << " sec, runtime [cc] = " << t_cc.Seconds() << " sec\n";
+
+  VersionedGraph vg(g);
+  vg.start_compaction(std::max(vidType(1), g.V() / 8)); // compact once 1/8 of the lists are owned
+  std::atomic<bool> writing(true);
+  double update_time = 0;
+  std::thread writer([&]() {
+    Timer t;
+    t.Start();
+    size_t prev = 0;
+    for (size_t i = 0; i <= edges.size(); i += batch_size) {
+      auto last = std::min(edges.size(), i + batch_size);
+      EdgeBatch deletes(edges.begin() + i, edges.begin() + last);
+      EdgeBatch inserts(edges.begin() + prev, edges.begin() + i);
+      vg.apply_batch(inserts, deletes);
+      prev = i;
+      if (last == edges.size()) {
+        vg.apply_batch(EdgeBatch(edges.begin() + i, edges.end()), EdgeBatch());
+        break;
+      }
+    }
+    t.Stop();
+    update_time = t.Seconds();
+    writing = false;
+  });
+
+  int num_snapshots = 0, num_inconsistent = 0;
+  size_t max_overhead = 0;
+  double pr_time = 0, cc_time = 0;
+  do {
+    auto s = vg.snapshot();
+    max_overhead = std::max(max_overhead, s->get_memory());
+    t_pr.Start();
+    pr_kernel(*s, scores);
+    t_pr.Stop();
+    t_cc.Start();
+    cc_kernel(*s, comp);
+    t_cc.Stop();
+    pr_time += t_pr.Seconds();
+    cc_time += t_cc.Seconds();
+    if (!is_consistent(*s)) num_inconsistent++;
+    num_snapshots++;
+  } while (writing);
+  writer.join();
+  vg.stop_compaction();
+
+  auto num_updates = 2 * edges.size(); // each edge deleted and inserted back
+  std::cout << "versions = " << vg.snapshot()->version() << ", compactions = " << vg.num_compactions()
+            << ", update throughput = " << num_updates / update_time << " edges/sec\n";
+  std::cout << "snapshots analyzed = " << num_snapshots << ", inconsistent = " << num_inconsistent
+            << ", average runtime [pr] = " << pr_time / num_snapshots << " sec, [cc] = " << cc_time / num_snapshots << " sec\n";
+  std::cout << "max memory overhead of a snapshot = " << max_overhead << " bytes (base CSR "
+            << (g.V()+1) * sizeof(eidType) + g.E() * sizeof(vidType) << " bytes)\n";
+  auto s = vg.snapshot();
+  if (num_inconsistent == 0 && same_graph(g, *s) && cc_kernel(*s, comp) == num_comps) std::cout << "Correct\n";
+  else std::cout << "Wrong\n";
+}
+
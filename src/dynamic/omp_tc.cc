@@ -0,0 +1,70 @@
+// Copyright 2020 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#include <random>
+#include "graph.h"
+#include "incremental_tc.h"
+#include "kernels.h"
+
+// Start from the input graph without a random fraction H of its edges. Each batch inserts
+// a slice of H and deletes a slice of a random set R of the other edges; a last batch
+// inserts R back, which must give the triangle count of the input graph.
+void DynamicSolver(Graph &g, int batch_size, double delete_ratio, int seed) {
+  int num_threads = 1;
+  #pragma omp parallel
+  {
+    num_threads = omp_get_num_threads();
+  }
+  std::cout << "OpenMP Incremental Triangle Counting (" << num_threads << " threads), batch size = " << batch_size << "\n";
+  EdgeBatch edges;
+  edges.reserve(g.E() / 2);
+  for (vidType v = 0; v < g.V(); v++)
+    for (auto u : g.N(v))
+      if (u > v) edges.push_back(std::make_pair(v, u));
+  std::mt19937_64 rng(seed);
+  std::shuffle(edges.begin(), edges.end(), rng);
+  size_t num_held = size_t(edges.size() * delete_ratio / 2);
+  EdgeBatch held(edges.begin(), edges.begin() + num_held);
+  EdgeBatch removed(edges.begin() + num_held, edges.begin() + 2 * num_held);
+
+  Timer t;
+  t.Start();
+  auto expected = tc_kernel(g);
+  t.Stop();
+  std::cout << "triangles = " << expected << ", runtime [static] = " << t.Seconds() << " sec\n";
+
+  DynamicGraph dg(g.V());
+  dg.insert_edges(EdgeBatch(edges.begin() + num_held, edges.end()));
+  t.Start();
+  IncrementalTC itc(dg);
+  t.Stop();
+  std::cout << "initial triangles = " << itc.get_total() << ", runtime [recount] = " << t.Seconds() << " sec\n";
+
+  int num_batches = 0;
+  double update_time = 0;
+  for (size_t i = 0; i <= num_held; i += batch_size) {
+    EdgeBatch inserts, deletes;
+    if (i < num_held) {
+      auto last = std::min(num_held, i + size_t(batch_size));
+      inserts.assign(held.begin() + i, held.begin() + last);
+      deletes.assign(removed.begin() + i, removed.begin() + last);
+    }
+    if (i + batch_size > num_held) // the last batch also inserts R back
+      inserts.insert(inserts.end(), removed.begin(), removed.end());
+    t.Start();
+    itc.apply_batch(inserts, deletes);
+    t.Stop();
+    update_time += t.Seconds();
+    num_batches++;
+  }
+  std::cout << "batches = " << num_batches << ", average runtime [incremental] = "
+            << update_time / num_batches << " sec per batch\n";
+
+  std::vector<int64_t> counts;
+  t.Start();
+  itc.recount(counts);
+  t.Stop();
+  std::cout << "runtime [recount] = " << t.Seconds() << " sec\n";
+  std::cout << "triangles = " << itc.get_total() << "\n";
+  if (itc.get_total() == expected && counts == itc.get_local_counts()) std::cout << "Correct\n";
+  else std::cout << "Wrong\n";
+}
@@ -0,0 +1,90 @@
+// Copyright 2022
+// Author: Xuhao Chen <cxh@mit.edu>
+#include "cf_kernels.h"
+
+// Alternating least squares with weighted-lambda regularization [Yunhong Zhou et. al.,
+// Large-Scale Parallel Collaborative Filtering for the Netflix Prize, AAIM 2008]: with the item
+// vectors fixed, the vector of user u is the exact minimizer
+//   p_u = (Q_u^T Q_u + lambda n_u I)^-1 Q_u^T r_u
+// over its n_u ratings r_u of the items Q_u, and then the same for the items with the user
+// vectors fixed. Each vertex is an independent dim x dim system, solved by Cholesky.
+
+// the vectors of the vertices [begin, end) from the vectors of their neighbors
+template <int D>
+static void als_half(BipartiteGraph &g, vidType begin, vidType end, std::vector<latent_t> &latents, int dim) {
+  auto ratings = get_ratings(g);
+  int n = latent_len<D>(dim);
+  #pragma omp parallel
+  {
+    std::vector<latent_t> A(size_t(n) * n), b(n);
+    #pragma omp for schedule(dynamic, 64)
+    for (vidType v = begin; v < end; v++) {
+      auto degree = g.get_degree(v);
+      if (degree == 0) continue;
+      // the lower triangle of A = Q^T Q + lambda n_v I, and b = Q^T r
+      std::fill(A.begin(), A.end(), 0.f);
+      std::fill(b.begin(), b.end(), 0.f);
+      for (auto e = g.edge_begin(v); e < g.edge_end(v); e++) {
+        auto q = &latents[size_t(g.getEdgeDst(e)) * n];
+        for (int k = 0; k < n; k++)
+          blas1::axpy(k + 1, q[k], q, &A[size_t(k) * n]);
+        blas1::axpy(n, ratings[e], q, b.data());
+      }
+      for (int k = 0; k < n; k++) A[size_t(k) * n + k] += lambda * degree;
+      // A = L L^T, with L in the lower triangle of A
+      for (int j = 0; j < n; j++) {
+        auto row_j = &A[size_t(j) * n];
+        latent_t d = std::sqrt(std::max(row_j[j] - blas1::dot(j, row_j, row_j), 1e-12f));
+        row_j[j] = d;
+        for (int i = j + 1; i < n; i++) {
+          auto row_i = &A[size_t(i) * n];
+          row_i[j] = (row_i[j] - blas1::dot(j, row_i, row_j)) / d;
+        }
+      }
+      // solve L y = b, then L^T x = y, into the vector of v
+      for (int i = 0; i < n; i++)
+        b[i] = (b[i] - blas1::dot(i, &A[size_t(i) * n], b.data())) / A[size_t(i) * n + i];
+      auto x = &latents[size_t(v) * n];
+      for (int i = n - 1; i >= 0; i--) {
+        latent_t s = b[i];
+        for (int k = i + 1; k < n; k++) s -= A[size_t(k) * n + i] * x[k];
+        x[i] = s / A[size_t(i) * n + i];
+      }
+    }
+  }
+}
+
+template <int D>
+static void als_iterations(BipartiteGraph &g, std::vector<latent_t> &latents, int dim, int &iter) {
+  Timer t;
+  t.Start();
+  do {
+    iter ++;
+    als_half<D>(g, 0, g.V(0), latents, dim);
+    als_half<D>(g, g.V(0), g.V(), latents, dim);
+    #ifdef COMPUTE_ERROR
+    score_t total_error = compute_rmse(g, latents, dim);
+    t.Stop();
+    printf("Iteration %d: RMSE error = %f (%.3f sec)\n", iter, total_error, t.Seconds());
+    if (total_error < cf_epsilon) break;
+    #endif
+  } while (iter < max_iters);
+}
+
+void ALSSolver(BipartiteGraph &g, std::vector<latent_t> &latents, int *ordering) {
+  int num_threads = 1;
+  #pragma omp parallel
+  {
+    num_threads = omp_get_num_threads();
+  }
+  std::cout << "OpenMP CF (" << num_threads << " threads): ALS\n";
+  int iter = 0;
+  Timer t;
+  t.Start();
+  dispatch_dim(latent_dim, [&](auto d) {
+    als_iterations<decltype(d)::value>(g, latents, latent_dim, iter);
+  });
+  t.Stop();
+  std::cout << "iterations = " << iter << ".\n";
+  std::cout << "runtime [cf_omp_base] = " << t.Seconds() << " sec\n";
+}
@@ -0,0 +1,64 @@
+// Copyright 2022 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#pragma once
+#include "graph.h"
+#include "utils/blas1.h"
+#include <type_traits>
+
+// The kernels of the CPU CF solvers. The latent dimension is a runtime parameter; the kernels
+// are templates over it, instantiated for the common dimensions (D > 0) so that the loops have
+// a constant trip count and are fully unrolled and vectorized, and for any other one (D = 0).
+// The users are the vertices [0, V(0)), the items [V(0), V()), and the latent vector of vertex
+// v is latents[v*dim : v*dim+dim).
+
+// the ratings, stored as floats in the edge label file
+inline const float *get_ratings(BipartiteGraph &g) {
+  static_assert(sizeof(elabel_t) == sizeof(float), "the ratings are 4-byte floats");
+  return reinterpret_cast<const float*>(g.get_elabel_ptr());
+}
+
+template <int D>
+inline int latent_len(int dim) { return D > 0 ? D : dim; }
+
+// call f(std::integral_constant<int, D>()), D = dim if dim is a specialized dimension, 0 otherwise
+template <typename F>
+void dispatch_dim(int dim, F f) {
+  switch (dim) {
+    case 16:  f(std::integral_constant<int, 16>()); break;
+    case 20:  f(std::integral_constant<int, 20>()); break;
+    case 32:  f(std::integral_constant<int, 32>()); break;
+    case 64:  f(std::integral_constant<int, 64>()); break;
+    case 128: f(std::integral_constant<int, 128>()); break;
+    default:  f(std::integral_constant<int, 0>()); break;
+  }
+}
+
+// One SGD step on the rating r of (p, q), with both vectors updated from their old values;
+// returns the error before the step.
+template <int D>
+inline score_t sgd_update(int dim, latent_t *p, latent_t *q, score_t r, score_t step, score_t lambda) {
+  int n = latent_len<D>(dim);
+  score_t err = r - blas1::dot(n, p, q);
+  #pragma omp simd
+  for (int k = 0; k < n; k++) {
+    latent_t pk = p[k], qk = q[k];
+    p[k] += step * (err * qk - lambda * pk);
+    q[k] += step * (err * pk - lambda * qk);
+  }
+  return err;
+}
+
+// the root mean squared error of the latents over all the ratings
+inline score_t compute_rmse(BipartiteGraph &g, const std::vector<latent_t> &latents, int dim) {
+  auto ratings = get_ratings(g);
+  double total = 0.;
+  #pragma omp parallel for reduction(+ : total) schedule(dynamic, 64)
+  for (vidType u = 0; u < g.V(0); u++) {
+    for (auto e = g.edge_begin(u); e < g.edge_end(u); e++) {
+      double err = ratings[e] - blas1::dot(dim, &latents[size_t(u)*dim], &latents[size_t(g.getEdgeDst(e))*dim]);
+      total += err * err;
+    }
+  }
+  eidType num_ratings = g.edge_begin(g.V(0)); // the edges of the users
+  return std::sqrt(total / num_ratings);
+}
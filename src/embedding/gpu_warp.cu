@@ -56,7 +56,11 @@ __global__ void compute_error(GraphGPU g, latent_t *latents,
   }
 }
 
+const score_t default_lambda = 0.001;
+const score_t default_step = 0.00000035;
+
 void SGDSolver(BipartiteGraph &g, std::vector<latent_t> &latents, int *h_ordering) {
+  assert(latent_dim == K); // the kernels are compiled for K latent features
   size_t memsize = print_device_info(0);
   auto nv = g.V();
   auto ne = g.E();
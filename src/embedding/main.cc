@@ -1,62 +1,66 @@
 // Copyright 2022 MIT
 // Authors: Xuhao Chen <cxh@mit.edu>
 #include "graph.h"
-#include <random>
+#include "utils/philox.h"
 
 // CF parameters
 score_t cf_epsilon = 0.1;    // convergence condition
-score_t lambda = 0.001;     // regularization_factor
-score_t step = 0.00000035;  // learning rate in the algorithm
+score_t lambda = default_lambda; // regularization_factor
+score_t step = default_step;     // learning rate in the algorithm
 int max_iters = 5;          // maximum number of iterations
+int latent_dim = K;         // dimension of the latent vector
 
 void SGDSolver(BipartiteGraph &g, std::vector<latent_t> &latents, int *ordering);
-void SGDVerifier(BipartiteGraph &g, std::vector<latent_t> &latents, int *ordering);
+void ALSSolver(BipartiteGraph &g, std::vector<latent_t> &latents, int *ordering);
+void CFVerifier(BipartiteGraph &g, std::vector<latent_t> &latents);
 
+// uniform in [0, 1/sqrt(dim)), so that the initial estimates are about 1/4
 void Initialize(std::vector<latent_t> &lv) {
-  size_t nv = lv.size() / K;
-  //std::cout << "nv = " << nv << "\n";
+  size_t nv = lv.size() / latent_dim;
+  Philox rng(0);
+  latent_t scale = 1. / std::sqrt(latent_dim);
+  #pragma omp parallel for
   for (size_t i = 0; i < nv; ++i) {
-    std::default_random_engine rng;
-    std::uniform_real_distribution<float> dist(0, 1);
-    //srand(0);
-    //long seed = rand();
-    for (int j = 0; j < K; j++) {
-      //lv[i*K+j] = 0.5; 
-      lv[i*K+j] = dist(rng);
-      //lv[i*K+j] = (float)(seed+hashInt((uintE)i*K+j))/(float)UINT_E_MAX;
-    }
+    rng.uniforms(0, i * latent_dim, latent_dim, &lv[i * latent_dim]);
+    for (int j = 0; j < latent_dim; j++)
+      lv[i*latent_dim+j] *= scale;
   }
 }
 
 int main(int argc, char *argv[]) {
   if (argc < 2) {
-    printf("Usage: %s <graph> [lambda(0.001)] [step(0.00000035)] [max_iter(5)] [epsilon(0.1)] [K(20)]\n", argv[0]);
+    printf("Usage: %s <graph> [lambda(%g)] [step(%g)] [max_iter(5)] [epsilon(0.1)] [K(20)] [solver(sgd)]\n",
+           argv[0], default_lambda, default_step);
+    printf("solvers: sgd (blocked SGD on CPU, batch gradient descent on GPU), als (CPU only)\n");
     exit(1);
   }
   if (argc > 2) lambda = atof(argv[2]);
   if (argc > 3) step = atof(argv[3]);
   if (argc > 4) max_iters = atof(argv[4]);
   if (argc > 5) cf_epsilon = atof(argv[5]);
-  //if (argc > 6) K = atoi(argv[6]);
+  if (argc > 6) latent_dim = atoi(argv[6]);
+  std::string solver = argc > 7 ? argv[7] : "sgd";
+  if (solver != "sgd" && solver != "als") {
+    std::cout << "unknown solver " << solver << "\n";
+    exit(1);
+  }
   BipartiteGraph g(argv[1], 0, 1, 0, 1, 0, 1); // no-dag; directed; no-vlabel; elabel; no-reverse; bipartite
   auto nv = g.V();
   auto num_users = g.V(0);
   auto num_items = g.V(1);
   g.print_meta_data();
-  std::cout << "Matrix completion. WARNING: elabel must be floating point type!\n";
+  std::cout << "Matrix completion. The edge labels are the ratings, as 4-byte floats\n";
   std::cout << "# users: " << num_users << " ; # items: " << num_items << "\n";
-  std::cout << "lambda: " << lambda << " ; step: " << step << " ; max_iter: " 
-            << max_iters << " ; epsilon: " << cf_epsilon << " ; K: " << K << "\n";
+  std::cout << "lambda: " << lambda << " ; step: " << step << " ; max_iter: "
+            << max_iters << " ; epsilon: " << cf_epsilon << " ; K: " << latent_dim << "\n";
   //g.print_graph();
 
-  std::vector<latent_t> latents_init(size_t(nv) * K);
-  Initialize(latents_init);
-  std::vector<latent_t> latents(latents_init);
+  std::vector<latent_t> latents(size_t(nv) * latent_dim);
+  Initialize(latents);
   std::vector<int> ordering(num_users, 0);
-  //std::cout << "Shuffling users...\n";
-  //for (vidType i = 0; i < num_users; i ++) ordering[i] = i;
-  std::random_shuffle(ordering.begin(), ordering.end());
-  SGDSolver(g, latents, &ordering[0]);
-  SGDVerifier(g, latents_init, &ordering[0]);
+  for (vidType i = 0; i < num_users; i ++) ordering[i] = i;
+  if (solver == "als") ALSSolver(g, latents, &ordering[0]);
+  else SGDSolver(g, latents, &ordering[0]);
+  CFVerifier(g, latents);
   return 0;
 }
@@ -1,74 +1,120 @@
 // Copyright 2022
 // Author: Xuhao Chen <cxh@mit.edu>
-#include "graph.h"
+#include "cf_kernels.h"
+#include "utils/philox.h"
 
-inline score_t rmse_par(int nv, int ne, score_t *errors) {
-  score_t total_error = 0.0;
-  #pragma omp parallel for reduction(+ : total_error)
-  for(int i = 0; i < nv; i ++) {
-    total_error += errors[i];
-  }
-  total_error = sqrt(total_error/ne);
-  return total_error;
+// Blocked SGD (DSGD) [Rainer Gemulla et. al., Large-Scale Matrix Factorization with Distributed
+// Stochastic Gradient Descent, KDD 2011] [Wei-Sheng Chin et. al., A Fast Parallel Stochastic
+// Gradient Method for Matrix Factorization in Shared Memory Systems, TIST 2015]:
+// the rating matrix is cut into nb x nb blocks, the users and the items each split into nb
+// ranges of about the same number of ratings. The nb blocks (b, (b+s) % nb) of stratum s share
+// no user and no item, so the threads update them in parallel with no conflict; an iteration
+// visits the nb strata in a random order. Each rating updates its two latent vectors in place.
+
+struct Rating {
+  vidType user, item;
+  score_t value;
+};
+
+// split the vertices [begin, end) into nb ranges of about the same number of edges
+static std::vector<vidType> split_by_edges(BipartiteGraph &g, vidType begin, vidType end, int nb) {
+  auto rowptr = g.rowptr();
+  std::vector<vidType> bounds(nb + 1);
+  auto first = rowptr[begin], total = rowptr[end] - first;
+  for (int b = 0; b <= nb; b++)
+    bounds[b] = std::lower_bound(rowptr + begin, rowptr + end, first + total * b / nb) - rowptr;
+  bounds[0] = begin;
+  bounds[nb] = end;
+  return bounds;
 }
 
-void SGDSolver(BipartiteGraph &g, std::vector<latent_t> &latents, int * ordering) {
-  int num_threads = 1;
-  #pragma omp parallel
-  {
-    num_threads = omp_get_num_threads();
+// the ratings of block (b, c) are ratings[offsets[b*nb+c] : offsets[b*nb+c+1]), in CSR order
+static void build_blocks(BipartiteGraph &g, int nb, std::vector<Rating> &ratings, std::vector<eidType> &offsets) {
+  auto num_users = g.V(0);
+  auto user_bounds = split_by_edges(g, 0, num_users, nb);
+  auto item_bounds = split_by_edges(g, num_users, g.V(), nb);
+  std::vector<int> item_block(g.V(1));
+  for (int c = 0; c < nb; c++)
+    for (auto i = item_bounds[c]; i < item_bounds[c+1]; i++)
+      item_block[i - num_users] = c;
+  auto values = get_ratings(g);
+  // count, scan and scatter the ratings of each block
+  offsets.assign(size_t(nb) * nb + 1, 0);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int b = 0; b < nb; b++)
+    for (auto e = g.edge_begin(user_bounds[b]); e < g.edge_begin(user_bounds[b+1]); e++)
+      offsets[b * nb + item_block[g.getEdgeDst(e) - num_users] + 1] ++;
+  for (int i = 0; i < nb * nb; i++) offsets[i+1] += offsets[i];
+  ratings.resize(offsets[nb * nb]);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (int b = 0; b < nb; b++) {
+    std::vector<eidType> pos(&offsets[b * nb], &offsets[b * nb + nb]);
+    for (auto u = user_bounds[b]; u < user_bounds[b+1]; u++) {
+      for (auto e = g.edge_begin(u); e < g.edge_end(u); e++) {
+        auto i = g.getEdgeDst(e);
+        ratings[pos[item_block[i - num_users]]++] = {u, i, values[e]};
+      }
+    }
   }
-  std::cout << "OpenMP CF (" << num_threads << " threads)\n";
-  auto nv = g.V();
-  //auto num_users = g.V(0);
-  //auto num_items = g.V(1);
-
-  std::vector<score_t> errors(nv*K, 0);
-  #ifdef COMPUTE_ERROR
-  std::vector<score_t> squared_errors(nv, 0.0);
-  score_t total_error = 0.0;
-  #endif
+}
 
-  int iter = 0;
+template <int D>
+static void sgd_iterations(int nb, const std::vector<Rating> &ratings, const std::vector<eidType> &offsets,
+                           std::vector<latent_t> &latents, int dim, int &iter) {
+  eidType num_ratings = ratings.size();
+  Philox rng(1);
   Timer t;
   t.Start();
   do {
     iter ++;
-    #ifdef COMPUTE_ERROR
-    for (int i = 0; i < nv; i ++) squared_errors[i] = 0;
-    #endif
-    #pragma omp parallel for schedule(dynamic, 64)
-    for (int u = 0; u < nv; u ++) {
-      latent_t *u_latent = &latents[K*u];
-      latent_t *u_err = &errors[K*u];
-      auto offset = g.edge_begin(u);
-      for (auto v : g.N(u)) {
-        latent_t *v_latent = &latents[K*v];
-        score_t estimate = 0;
-        for (int i = 0; i < K; i++)
-          estimate += u_latent[i] * v_latent[i];
-        score_t rating = g.getEdgeData(offset++);
-        score_t delta = rating - estimate;
-        #ifdef COMPUTE_ERROR
-        squared_errors[u] += delta * delta;
-        #endif
-        for (int i = 0; i < K; i++)
-          u_err[i] += v_latent[i] * delta;
-      }
-    }
-    #pragma omp parallel for schedule(dynamic, 64)
-    for (vidType u = 0; u < nv; u ++) {
-      for (int i = 0; i < K; i++) {
-        latents[K*u+i] += step * (-lambda * latents[K*u+i] + errors[K*u+i]);
-        errors[K*u+i] = 0.0;
+    double squared_errors = 0.;
+    for (int s = 0; s < nb; s++) {
+      int stratum = rng.permute(iter, s, nb);
+      #pragma omp parallel for schedule(dynamic, 1) reduction(+ : squared_errors)
+      for (int b = 0; b < nb; b++) {
+        int blk = b * nb + (b + stratum) % nb;
+        for (auto e = offsets[blk]; e < offsets[blk+1]; e++) {
+          auto &r = ratings[e];
+          auto err = sgd_update<D>(dim, &latents[size_t(r.user) * dim], &latents[size_t(r.item) * dim], r.value, step, lambda);
+          squared_errors += err * err;
+        }
       }
     }
+    // the error of each rating is the one before its update in this iteration
+    score_t total_error = std::sqrt(squared_errors / num_ratings);
     #ifdef COMPUTE_ERROR
-    total_error = rmse_par(nv, g.E(), &squared_errors[0]);
-    printf("Iteration %d: RMSE error = %f\n", iter, total_error);
+    t.Stop();
+    printf("Iteration %d: RMSE error = %f (%.3f sec)\n", iter, total_error, t.Seconds());
     if (total_error < cf_epsilon) break;
     #endif
   } while (iter < max_iters);
+}
+
+const score_t default_lambda = 0.05;
+const score_t default_step = 0.01;
+
+void SGDSolver(BipartiteGraph &g, std::vector<latent_t> &latents, int * ordering) {
+  int num_threads = 1;
+  #pragma omp parallel
+  {
+    num_threads = omp_get_num_threads();
+  }
+  // twice as many blocks per stratum as threads, for the load balance
+  int nb = std::max(1, std::min(2 * num_threads, int(std::min(g.V(0), g.V(1)))));
+  std::cout << "OpenMP CF (" << num_threads << " threads): DSGD over " << nb << "x" << nb << " blocks\n";
+  std::vector<Rating> ratings;
+  std::vector<eidType> offsets;
+  Timer t;
+  t.Start();
+  build_blocks(g, nb, ratings, offsets);
+  t.Stop();
+  std::cout << "blocking time = " << t.Seconds() << " sec\n";
+
+  int iter = 0;
+  t.Start();
+  dispatch_dim(latent_dim, [&](auto d) {
+    sgd_iterations<decltype(d)::value>(nb, ratings, offsets, latents, latent_dim, iter);
+  });
   t.Stop();
   std::cout << "iterations = " << iter << ".\n";
   std::cout << "runtime [cf_omp_base] = " << t.Seconds() << " sec\n";
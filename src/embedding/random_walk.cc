@@ -0,0 +1,215 @@
+// Copyright 2022 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#include "random_walk.h"
+#include <thread>
+
+#define SHUFFLE_STREAM (uint64_t(1) << 63) // the order of the start vertices of round r: stream SHUFFLE_STREAM | r
+#define WALK_BATCH 16384                   // walks generated while the previous batch is written
+
+EdgeAliasTables::EdgeAliasTables(Graph &graph) : g(graph), prob(graph.E()), alias(graph.E()) {
+  assert(g.has_elabel());
+  auto nv = g.V();
+  #pragma omp parallel
+  {
+    std::vector<uint32_t> small, large;
+    #pragma omp for schedule(dynamic, 64)
+    for (vidType v = 0; v < nv; v++) {
+      auto begin = g.edge_begin(v);
+      build_alias(g.get_elabel_ptr() + begin, g.get_degree(v), &prob[begin], &alias[begin], small, large);
+    }
+  }
+}
+
+CorpusWriter::CorpusWriter(std::string filename, int walk_length) :
+    max_length(walk_length), num_walks(0), num_vertices(0), num_bytes(0) {
+  f = fopen(filename.c_str(), "wb");
+  if (f == NULL) {
+    perror(("Error opening " + filename).c_str());
+    exit(EXIT_FAILURE);
+  }
+  setvbuf(f, NULL, _IOFBF, 1 << 22);
+  uint64_t magic = MAGIC;
+  uint32_t vid_size = sizeof(vidType);
+  fwrite(&magic, sizeof(uint64_t), 1, f);
+  fwrite(&vid_size, sizeof(uint32_t), 1, f);
+  fwrite(&max_length, sizeof(uint32_t), 1, f);
+  fwrite(&num_walks, sizeof(uint64_t), 1, f);
+  fwrite(&num_vertices, sizeof(uint64_t), 1, f);
+  num_bytes = 32;
+}
+
+void CorpusWriter::write(const vidType *walks, const uint32_t *lengths, size_t n, size_t stride) {
+  for (size_t i = 0; i < n; i++) {
+    fwrite(&lengths[i], sizeof(uint32_t), 1, f);
+    fwrite(walks + i * stride, sizeof(vidType), lengths[i], f);
+    num_vertices += lengths[i];
+    num_bytes += sizeof(uint32_t) + sizeof(vidType) * lengths[i];
+  }
+  num_walks += n;
+}
+
+void CorpusWriter::close() {
+  if (f == NULL) return;
+  fseek(f, 16, SEEK_SET);
+  fwrite(&num_walks, sizeof(uint64_t), 1, f);
+  fwrite(&num_vertices, sizeof(uint64_t), 1, f);
+  fclose(f);
+  f = NULL;
+}
+
+CorpusReader::CorpusReader(std::string filename, vidType nv) : name(filename), graph_vertices(nv) {
+  f = fopen(filename.c_str(), "rb");
+  if (f == NULL) {
+    perror(("Error opening " + filename).c_str());
+    exit(EXIT_FAILURE);
+  }
+  setvbuf(f, NULL, _IOFBF, 1 << 22);
+  uint64_t magic = 0;
+  uint32_t vid_size = 0;
+  if (fread(&magic, sizeof(uint64_t), 1, f) != 1 || magic != CorpusWriter::MAGIC ||
+      fread(&vid_size, sizeof(uint32_t), 1, f) != 1 || vid_size != sizeof(vidType) ||
+      fread(&max_length, sizeof(uint32_t), 1, f) != 1 ||
+      fread(&num_walks, sizeof(uint64_t), 1, f) != 1 ||
+      fread(&num_vertices, sizeof(uint64_t), 1, f) != 1) {
+    std::cout << "Error: " << filename << " is not a walk corpus\n";
+    exit(EXIT_FAILURE);
+  }
+}
+
+size_t CorpusReader::read(size_t max_walks, std::vector<vidType> &tokens, std::vector<uint64_t> &offsets) {
+  tokens.resize(max_walks * max_length);
+  offsets.assign(1, 0);
+  size_t n = 0;
+  uint32_t len;
+  for (; n < max_walks && fread(&len, sizeof(uint32_t), 1, f) == 1; n++) {
+    if (len > max_length || fread(tokens.data() + offsets[n], sizeof(vidType), len, f) != len) {
+      std::cout << "Error: " << name << " is truncated\n";
+      exit(EXIT_FAILURE);
+    }
+    for (uint32_t i = 0; i < len; i++) {
+      if (tokens[offsets[n] + i] >= graph_vertices) {
+        std::cout << "Error: " << name << " has vertex " << tokens[offsets[n] + i]
+                  << ", but the graph has " << graph_vertices << " vertices\n";
+        exit(EXIT_FAILURE);
+      }
+    }
+    offsets.push_back(offsets[n] + len);
+  }
+  tokens.resize(offsets[n]);
+  return n;
+}
+
+void CorpusReader::rewind() {
+  fseek(f, 32, SEEK_SET);
+}
+
+RandomWalker::RandomWalker(Graph &graph, int length, bool weighted, double p_, double q_, uint64_t seed) :
+    g(graph), walk_length(length), p(p_), q(q_), sorted(true), rng(seed), tables(NULL),
+    num_steps(0), num_proposals(0) {
+  assert(walk_length > 0 && p > 0. && q > 0.);
+  bias_return = 1. / p;
+  bias_out = 1. / q;
+  max_bias = std::max(1.f, std::max(bias_return, bias_out));
+  if (weighted) {
+    Timer t;
+    t.Start();
+    tables = new EdgeAliasTables(g);
+    t.Stop();
+    std::cout << "alias tables: " << g.E() * (sizeof(float) + sizeof(uint32_t)) / 1048576.0
+              << " MB built in " << t.Seconds() << " sec\n";
+  }
+  if (second_order()) {
+    auto nv = g.V();
+    #pragma omp parallel for schedule(dynamic, 64) reduction(&& : sorted)
+    for (vidType v = 0; v < nv; v++)
+      for (auto e = g.edge_begin(v) + 1; e < g.edge_end(v); e++)
+        sorted = sorted && g.getEdgeDst(e-1) <= g.getEdgeDst(e);
+    if (!sorted) std::cout << "WARNING: neighbor lists not sorted; testing the edges by linear search\n";
+  }
+}
+
+RandomWalker::~RandomWalker() {
+  if (tables) delete tables;
+}
+
+inline vidType RandomWalker::first_order(vidType v, PhiloxStream &stream) const {
+  if (tables) {
+    auto r0 = stream.next();
+    return g.N(v, tables->draw(v, r0, stream.next()));
+  }
+  return g.N(v, stream.below(g.get_degree(v)));
+}
+
+inline bool RandomWalker::is_neighbor(vidType t, vidType x) const {
+  auto begin = g.adj_ptr(t), end = begin + g.get_degree(t);
+  if (sorted) return std::binary_search(begin, end, x);
+  return std::find(begin, end, x) != end;
+}
+
+int RandomWalker::walk(uint64_t id, vidType start, vidType *walk, uint64_t &proposals) const {
+  PhiloxStream stream(rng, id);
+  walk[0] = start;
+  int len = 1;
+  for (; len < walk_length; len++) {
+    auto v = walk[len-1];
+    if (g.get_degree(v) == 0) break;
+    if (len == 1 || !second_order()) {
+      walk[len] = first_order(v, stream);
+      proposals++;
+      continue;
+    }
+    auto t = walk[len-2];
+    vidType x;
+    // a draw below min(1, 1/q) is accepted and one above max(1, 1/q) is rejected without
+    // testing the edge (t, x)
+    float lo = std::min(1.f, bias_out), hi = std::max(1.f, bias_out);
+    while (1) {
+      x = first_order(v, stream);
+      proposals++;
+      float y = stream.uniform() * max_bias;
+      if (x == t) {
+        if (y < bias_return) break;
+      } else if (y < lo) {
+        break;
+      } else if (y < hi) {
+        if (y < (is_neighbor(t, x) ? 1.f : bias_out)) break;
+      }
+    }
+    walk[len] = x;
+  }
+  return len;
+}
+
+void RandomWalker::run(int walks_per_vertex, CorpusWriter *writer) {
+  auto nv = g.V();
+  uint64_t total = uint64_t(walks_per_vertex) * nv;
+  // two batch buffers: one is written by the writer thread while the walks go to the other
+  std::vector<vidType> walks[2];
+  std::vector<uint32_t> lengths[2];
+  for (int i = 0; i < 2; i++) {
+    walks[i].resize(size_t(WALK_BATCH) * walk_length);
+    lengths[i].resize(WALK_BATCH);
+  }
+  std::thread io;
+  int cur = 0;
+  uint64_t steps = 0, proposals = 0;
+  for (uint64_t first = 0; first < total; first += WALK_BATCH) {
+    size_t n = std::min(uint64_t(WALK_BATCH), total - first);
+    auto buffer = walks[cur].data();
+    auto lens = lengths[cur].data();
+    #pragma omp parallel for schedule(dynamic, 64) reduction(+ : steps, proposals)
+    for (size_t i = 0; i < n; i++) {
+      auto id = first + i;
+      auto round = id / nv;
+      auto start = vidType(rng.permute(SHUFFLE_STREAM | round, id % nv, nv));
+      lens[i] = walk(id, start, buffer + i * walk_length, proposals);
+      steps += lens[i] - 1;
+    }
+    if (io.joinable()) io.join();
+    if (writer) io = std::thread([=] { writer->write(buffer, lens, n, walk_length); });
+    cur ^= 1;
+  }
+  if (io.joinable()) io.join();
+  num_steps += steps;
+  num_proposals += proposals;
+}
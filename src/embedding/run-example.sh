@@ -1,5 +1,6 @@
 #!/bin/bash
 ../../bin/cf_omp_base ../../inputs/amazon-ratings/graph
+#../../bin/cf_omp_base ../../inputs/amazon-ratings/graph 0.05 0.01 20 0.01 32 als
 #../../bin/cf_omp_base ../../inputs/netflix_mm.mtx 0.05 0.003
 
 ./bin/cf_omp_base ~/datasets/bipartite-graphs/netflix_mm/graph 0.001 0.00003
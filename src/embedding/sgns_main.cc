@@ -0,0 +1,44 @@
+// Copyright 2022 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#include "skip_gram.h"
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    std::cout << "Usage: " << argv[0] << " <graph> <corpus_file> [dim(128)] [window(10)] [negatives(5)]"
+              << " [epochs(1)] [lr(0.025)] [output_file]\n";
+    std::cout << "The corpus is generated by walk_omp_base\n";
+    std::cout << "Example: " << argv[0] << " ../../inputs/cora/graph cora.walks 128 10 5 1 0.025 cora.emb\n";
+    exit(1);
+  }
+  int dim = argc > 3 ? atoi(argv[3]) : 128;
+  int window = argc > 4 ? atoi(argv[4]) : 10;
+  int negatives = argc > 5 ? atoi(argv[5]) : 5;
+  int epochs = argc > 6 ? atoi(argv[6]) : 1;
+  float lr = argc > 7 ? atof(argv[7]) : 0.025;
+  std::string output = argc > 8 ? argv[8] : "";
+  Graph g(argv[1]);
+  g.print_meta_data();
+  CorpusReader corpus(argv[2], g.V());
+  std::cout << "corpus: " << corpus.walks() << " walks, " << corpus.vertices() << " vertices\n";
+
+  int num_threads = 1;
+  #pragma omp parallel
+  {
+    num_threads = omp_get_num_threads();
+  }
+  std::cout << "OpenMP Skip-gram (" << num_threads << " threads): dim = " << dim << ", window = " << window
+            << ", negatives = " << negatives << ", epochs = " << epochs << ", lr = " << lr << "\n";
+  SkipGram model(g, dim, window, negatives, lr);
+  Timer t;
+  t.Start();
+  for (int epoch = 0; epoch < epochs; epoch++) {
+    model.train(corpus, epoch, epochs);
+    std::cout << "Epoch " << epoch << ": loss = " << model.loss() << "\n";
+  }
+  t.Stop();
+  std::cout << "samples = " << model.samples() << ", throughput = " << model.samples() / t.Seconds()
+            << " samples/sec, " << model.samples() / t.Seconds() / num_threads << " samples/sec/core\n";
+  std::cout << "runtime [sgns_omp_base] = " << t.Seconds() << " sec\n";
+  if (output != "") model.save(output);
+  return 0;
+}
@@ -0,0 +1,136 @@
+// Copyright 2022 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#include "skip_gram.h"
+#include "utils/blas1.h"
+#include <thread>
+
+#define MAX_EXP 6             // sigmoid(x) is taken as 0 or 1 out of [-MAX_EXP, MAX_EXP]
+#define SIGMOID_TABLE 1024    // entries of the sigmoid table over [-MAX_EXP, MAX_EXP]
+#define TRAIN_BATCH 16384     // walks trained while the next batch is read
+#define INIT_STREAM (uint64_t(1) << 63)
+
+SkipGram::SkipGram(Graph &g, int d, int w, int neg, float rate, uint64_t seed) :
+    nv(g.V()), dim(d), window(w), negatives(neg), lr(rate), rng(seed),
+    num_samples(0), total_loss(0.) {
+  assert(dim > 0 && window > 0 && negatives >= 0);
+  std::vector<double> weights(nv);
+  #pragma omp parallel for
+  for (vidType v = 0; v < nv; v++)
+    weights[v] = std::pow(double(g.get_degree(v)), 0.75);
+  noise = AliasTable(weights.data(), nv);
+  // input vectors uniform in [-0.5/dim, 0.5/dim), output vectors 0
+  emb.resize(size_t(nv) * dim);
+  ctx.assign(size_t(nv) * dim, 0.);
+  #pragma omp parallel for
+  for (vidType v = 0; v < nv; v++) {
+    auto x = row(emb, v);
+    rng.uniforms(INIT_STREAM, uint64_t(v) * dim, dim, x);
+    for (int i = 0; i < dim; i++) x[i] = (x[i] - 0.5f) / dim;
+  }
+  sigmoid_table.resize(SIGMOID_TABLE + 1);
+  log_sigmoid_table.resize(SIGMOID_TABLE + 1);
+  for (int i = 0; i <= SIGMOID_TABLE; i++) {
+    double x = (2. * i / SIGMOID_TABLE - 1.) * MAX_EXP;
+    sigmoid_table[i] = 1. / (1. + std::exp(-x));
+    log_sigmoid_table[i] = -std::log1p(std::exp(-x));
+  }
+}
+
+// For each position i, the context is the positions within a window of w - b, b uniform in
+// [0, w) (nearer positions weigh more). Each (vertex, context) pair moves the context's input
+// vector toward the output vector of the vertex and away from those of 'negatives' draws.
+double SkipGram::train_walk(uint64_t id, const vidType *tokens, int len, float alpha, latent_t *grad, uint64_t &samples) {
+  PhiloxStream stream(rng, id);
+  double loss = 0.;
+  for (int i = 0; i < len; i++) {
+    auto v = tokens[i];
+    int w = window - stream.below(window);
+    for (int j = std::max(0, i - w); j < std::min(len, i + w + 1); j++) {
+      if (j == i) continue;
+      auto h = row(emb, tokens[j]);
+      std::fill(grad, grad + dim, 0.f);
+      for (int k = 0; k <= negatives; k++) {
+        vidType target = v;
+        if (k > 0) {
+          auto r0 = stream.next();
+          target = noise.draw(r0, stream.next());
+          if (target == v) continue;
+        }
+        float label = k == 0 ? 1.f : 0.f;
+        auto o = row(ctx, target);
+        float f = blas1::dot(dim, h, o);
+        // gradient of log sigmoid(f) for the positive, log sigmoid(-f) for the negatives
+        float g;
+        if (f >= MAX_EXP) {
+          g = label - 1.f;
+          loss += label > 0.f ? 0. : MAX_EXP;
+        } else if (f <= -MAX_EXP) {
+          g = label;
+          loss += label > 0.f ? MAX_EXP : 0.;
+        } else {
+          int t = int((f + MAX_EXP) * (SIGMOID_TABLE / (2.f * MAX_EXP)));
+          g = label - sigmoid_table[t];
+          loss -= label > 0.f ? log_sigmoid_table[t] : log_sigmoid_table[SIGMOID_TABLE - t];
+        }
+        g *= alpha;
+        blas1::axpy(dim, g, o, grad);
+        blas1::axpy(dim, g, h, o);
+      }
+      blas1::axpy(dim, 1.f, grad, h);
+      samples++;
+    }
+  }
+  return loss;
+}
+
+void SkipGram::train(CorpusReader &corpus, int epoch, int num_epochs) {
+  double total_tokens = double(corpus.vertices()) * num_epochs;
+  uint64_t trained = uint64_t(epoch) * corpus.vertices(); // tokens trained in the previous epochs
+  uint64_t first = uint64_t(epoch) * corpus.walks();      // the id of the next walk
+  corpus.rewind();
+  // two batch buffers: the next batch is read by the reader thread while one is trained
+  std::vector<vidType> tokens[2];
+  std::vector<uint64_t> offsets[2];
+  size_t n[2];
+  int cur = 0;
+  n[cur] = corpus.read(TRAIN_BATCH, tokens[cur], offsets[cur]);
+  uint64_t samples = 0;
+  double loss = 0.;
+  while (n[cur] > 0) {
+    int next = cur ^ 1;
+    std::thread io([&, next] { n[next] = corpus.read(TRAIN_BATCH, tokens[next], offsets[next]); });
+    auto batch = tokens[cur].data();
+    auto offs = offsets[cur].data();
+    #pragma omp parallel reduction(+ : samples, loss)
+    {
+      std::vector<latent_t> grad(dim);
+      #pragma omp for schedule(dynamic, 16)
+      for (size_t i = 0; i < n[cur]; i++) {
+        // linear decay of the learning rate over all the tokens of all the epochs
+        float alpha = lr * std::max(1e-4, 1. - (trained + offs[i]) / total_tokens);
+        loss += train_walk(first + i, batch + offs[i], offs[i+1] - offs[i], alpha, grad.data(), samples);
+      }
+    }
+    trained += offs[n[cur]];
+    first += n[cur];
+    io.join();
+    cur = next;
+  }
+  num_samples += samples;
+  total_loss = samples > 0 ? loss / samples : 0.;
+}
+
+void SkipGram::save(std::string filename) const {
+  FILE *f = fopen(filename.c_str(), "w");
+  if (f == NULL) {
+    perror(("Error opening " + filename).c_str());
+    exit(EXIT_FAILURE);
+  }
+  fprintf(f, "%u %d\n", nv, dim);
+  for (vidType v = 0; v < nv; v++) {
+    fprintf(f, "%u", v);
+    for (int i = 0; i < dim; i++) fprintf(f, " %.6f", emb[size_t(v) * dim + i]);
+    fprintf(f, "\n");
+  }
+  fclose(f);
+}
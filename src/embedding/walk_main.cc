@@ -0,0 +1,52 @@
+// Copyright 2022 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#include "random_walk.h"
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cout << "Usage: " << argv[0] << " <graph> [walk(uniform)] [walks_per_vertex(10)] [walk_length(80)]"
+              << " [corpus_file] [p(1)] [q(1)]\n";
+    std::cout << "walks: uniform, weighted (by the edge labels), node2vec, weighted-node2vec\n";
+    std::cout << "Example: " << argv[0] << " ../../inputs/cora/graph node2vec 10 80 cora.walks 1 0.5\n";
+    exit(1);
+  }
+  std::string method = argc > 2 ? argv[2] : "uniform";
+  int walks_per_vertex = argc > 3 ? atoi(argv[3]) : 10;
+  int walk_length = argc > 4 ? atoi(argv[4]) : 80;
+  std::string corpus = argc > 5 ? argv[5] : "";
+  double p = argc > 6 ? atof(argv[6]) : 1.;
+  double q = argc > 7 ? atof(argv[7]) : 1.;
+  bool weighted = method == "weighted" || method == "weighted-node2vec";
+  if (method != "node2vec" && method != "weighted-node2vec") p = q = 1.;
+  if (!weighted && method != "uniform" && method != "node2vec") {
+    std::cout << "unknown walk " << method << "\n";
+    exit(1);
+  }
+  Graph g(argv[1], 0, 0, 0, weighted);
+  g.print_meta_data();
+
+  int num_threads = 1;
+  #pragma omp parallel
+  {
+    num_threads = omp_get_num_threads();
+  }
+  std::cout << "OpenMP Random Walks (" << num_threads << " threads): " << walks_per_vertex
+            << " " << method << " walks of length " << walk_length << " per vertex";
+  if (p != 1. || q != 1.) std::cout << ", p = " << p << " q = " << q;
+  std::cout << "\n";
+  RandomWalker walker(g, walk_length, weighted, p, q);
+  CorpusWriter *writer = corpus == "" ? NULL : new CorpusWriter(corpus, walk_length);
+  Timer t;
+  t.Start();
+  walker.run(walks_per_vertex, writer);
+  if (writer) writer->close();
+  t.Stop();
+  auto steps = walker.steps();
+  std::cout << "steps = " << steps << ", proposals per step = " << double(walker.proposals()) / steps << "\n";
+  if (writer) std::cout << "corpus: " << writer->bytes() / 1048576.0 << " MB written to " << corpus << "\n";
+  std::cout << "throughput = " << steps / t.Seconds() << " steps/sec, "
+            << steps / t.Seconds() / num_threads << " steps/sec/core\n";
+  std::cout << "runtime [walk_omp_base] = " << t.Seconds() << " sec\n";
+  if (writer) delete writer;
+  return 0;
+}
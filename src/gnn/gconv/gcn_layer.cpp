@@ -7,10 +7,6 @@ void GCN_layer::forward(float* feat_out) {
   auto y = dim_in;
   auto z = dim_out;
   //std::cout << "GCN Layer " << level_ << " forward: [" << x << " x " << y << "] to [" << x << " x " << z << "]\n";
-#ifdef CSR_SEGMENTING
-  //if (y < z) graph->update_feat_len(y);
-  //else graph->update_feat_len(z);
-#endif
   float* in_data = feat_in;
   if (feat_dropout_rate > 0. && phase_ == net_phase::TRAIN) {
     dropout_cpu(x, y, feat_scale, feat_dropout_rate, in_data, dropout_mask, &in_temp[0]);
@@ -34,10 +30,6 @@ void GCN_layer::backward(float* feat_out, float* grad_out) {
   auto y = dim_in;
   auto z = dim_out;
   //std::cout << "GCN Layer " << level_ << " backward: [" << x << " x " << y << "] to [" << x << " x " << z << "]\n";
-#ifdef CSR_SEGMENTING
-  //if (y < z) graph->update_feat_len(y);
-  //else graph->update_feat_len(z);
-#endif
   if (is_act) d_relu_cpu(x*z, grad_in, feat_out, grad_in);
   if (is_bias) reduce_sum(x, z, grad_in, bias_grad);
   if (y > z) {
@@ -55,6 +55,14 @@ void graph_conv_layer<Aggregator>::update_dim_size(size_t x) {
   num_samples = x;
 }
 
+template <typename Aggregator>
+void graph_conv_layer<Aggregator>::save_weights(std::ostream &out) {
+  write_tensor(out, W_neigh);
+  write_tensor(out, W_self);
+  write_tensor(out, bias);
+  aggr.save_weights(out);
+}
+
 template class graph_conv_layer<GCN_Aggregator>;
 template class graph_conv_layer<GAT_Aggregator>;
 template class graph_conv_layer<SAGE_Aggregator>;
@@ -0,0 +1,114 @@
+#include "utils.h"
+#include "reader.h"
+#include "inference.h"
+#include "math_functions.hh"
+std::map<char,double> time_ops;
+
+int main(int argc, char* argv[]) {
+  if (argc < 4) {
+    std::cout << "Usage: ./infer data model_file num_threads [precision(fp32|bf16|int8)] [batch_size(0)]\n"
+              << "The model file is saved by cpu_train_*; with batch_size > 0, the test vertices are\n"
+              << "also scored in batches, each over the receptive field of its vertices only\n"
+              << "Example: ./bin/cpu_infer cora cora.model 4 bf16 64\n";
+    exit(1);
+  }
+  std::string dataset_name = argv[1];
+  int num_threads = atoi(argv[3]);
+  omp_set_num_threads(num_threads);
+  std::string precision = argc > 4 ? argv[4] : "fp32";
+  size_t batch_size = argc > 5 ? atoi(argv[5]) : 0;
+  feat_precision prec = feat_precision::FP32;
+  if (precision == "bf16") prec = feat_precision::BF16;
+  else if (precision == "int8") prec = feat_precision::INT8;
+  else if (precision != "fp32") {
+    std::cout << "unknown precision " << precision << "\n";
+    exit(1);
+  }
+  time_ops[OP_DENSEMM]  = 0.;
+  time_ops[OP_SPARSEMM] = 0.;
+
+  InferenceEngine engine(argv[2]);
+  auto arch = engine.get_arch();
+  std::cout << "Using " << (arch == gnn_arch::GAT ? "Graph Attention Network" :
+                            arch == gnn_arch::SAGE ? "GraphSAGE" : "Graph Convolutional Network")
+            << " with " << engine.get_num_layers() << " layers\n";
+  Graph* graph = new Graph(false);
+  Reader reader(dataset_name);
+  reader.readGraphFromGRFile(graph);
+  if (arch != gnn_arch::SAGE) graph->add_selfloop();
+  size_t nv = graph->size();
+  vec_t feats;
+  int dim_init = reader.read_features(feats);
+  assert(dim_init == engine.get_input_length());
+  std::vector<label_t> labels;
+  int num_cls = reader.read_labels(labels, !engine.get_is_sigmoid());
+  assert(num_cls == engine.get_num_classes());
+  std::vector<mask_t> masks_test(nv, 0);
+  size_t test_begin = 0, test_end = 0, test_count = 0;
+  if (dataset_name == "reddit") {
+    test_begin = 177262;
+    test_count = 55703;
+    test_end = test_begin + test_count;
+    std::fill(&masks_test[test_begin], &masks_test[test_end], 1);
+  } else {
+    test_count = reader.read_masks("test", nv, test_begin, test_end, masks_test.data());
+  }
+  engine.set_graph(graph);
+  engine.set_features(std::move(feats), prec);
+  std::cout << "num_threads = " << num_threads << ", num_vertices = " << nv
+            << ", num_edges = " << graph->sizeEdges() << ", precision = " << precision
+            << ", feature memory = " << engine.get_feature_bytes() / 1048576.0 << " MB\n";
+
+  auto accuracy = [&](vec_t &logits) {
+    if (!engine.get_is_sigmoid())
+      return masked_accuracy_single(test_begin, test_end, test_count, num_cls, &masks_test[0], &logits[0], &labels[0]);
+    vec_t probs(logits.size());
+    sigmoid(logits.size(), &logits[0], &probs[0]);
+    return masked_accuracy_multi(test_begin, test_end, test_count, num_cls, &masks_test[0], &probs[0], &labels[0]);
+  };
+
+  // full-graph inference, layer by layer
+  vec_t logits(nv * num_cls);
+  double t1 = omp_get_wtime();
+  engine.infer_all(&logits[0]);
+  double t2 = omp_get_wtime();
+  std::cout << "Full-graph inference: test accuracy " << accuracy(logits) << ", time " << t2 - t1
+            << " sec, buffer memory " << engine.get_buffer_bytes() / 1048576.0 << " MB\n";
+  std::cout << "AGGR time: " << time_ops[OP_SPARSEMM] << ", LINEAR time: " << time_ops[OP_DENSEMM] << "\n";
+  if (batch_size == 0) return 0;
+
+  // the test vertices in batches, each over its receptive field
+  std::vector<index_t> test_nodes;
+  for (size_t v = test_begin; v < test_end; v++)
+    if (masks_test[v]) test_nodes.push_back(v);
+  vec_t batch_logits(nv * num_cls, 0.), out(batch_size * num_cls);
+  std::vector<double> latencies;
+  size_t max_field = 0;
+  float max_diff = 0.;
+  for (size_t begin = 0; begin < test_nodes.size(); begin += batch_size) {
+    size_t end = std::min(test_nodes.size(), begin + batch_size);
+    std::vector<index_t> targets(test_nodes.begin() + begin, test_nodes.begin() + end);
+    double t3 = omp_get_wtime();
+    engine.infer(targets, &out[0]);
+    double t4 = omp_get_wtime();
+    latencies.push_back(t4 - t3);
+    max_field = std::max(max_field, engine.get_field_size());
+    for (size_t i = 0; i < targets.size(); i++) {
+      for (int j = 0; j < num_cls; j++) {
+        batch_logits[size_t(targets[i]) * num_cls + j] = out[i * num_cls + j];
+        max_diff = std::max(max_diff, std::fabs(out[i * num_cls + j] - logits[size_t(targets[i]) * num_cls + j]));
+      }
+    }
+  }
+  double total = std::accumulate(latencies.begin(), latencies.end(), 0.);
+  std::sort(latencies.begin(), latencies.end());
+  std::cout << "Batched inference (" << latencies.size() << " batches of " << batch_size
+            << "): test accuracy " << accuracy(batch_logits) << ", max difference to full-graph "
+            << max_diff << "\n";
+  std::cout << "latency per batch: mean " << total / latencies.size() * 1000 << " ms, median "
+            << latencies[latencies.size() / 2] * 1000 << " ms, max " << latencies.back() * 1000
+            << " ms; throughput " << test_nodes.size() / total << " vertices/sec\n";
+  std::cout << "largest receptive field " << max_field << " vertices, buffer memory "
+            << engine.get_buffer_bytes() / 1048576.0 << " MB\n";
+  return 0;
+}
@@ -0,0 +1,324 @@
+#include "inference.h"
+#include "math_functions.hh"
+#include "fused_spmm.h"
+
+void FeatureStore::init(vec_t &&feats, int len, feat_precision p) {
+  length = len;
+  precision = p;
+  num_rows = feats.size() / len;
+  size_t n = feats.size();
+  if (p == feat_precision::FP32) {
+    fp32 = std::move(feats);
+    return;
+  }
+  const float *x = &feats[0];
+  if (p == feat_precision::BF16) {
+    bf16.resize(n);
+    #pragma omp parallel for
+    for (size_t i = 0; i < n; i++) {
+      uint32_t bits;
+      memcpy(&bits, &x[i], sizeof(bits));
+      bits += 0x7fff + ((bits >> 16) & 1); // round to nearest even
+      bf16[i] = uint16_t(bits >> 16);
+    }
+  } else {
+    // symmetric quantization: row v is scales[v] * int8[v*len : (v+1)*len)
+    int8.resize(n);
+    scales.resize(num_rows);
+    #pragma omp parallel for
+    for (size_t v = 0; v < num_rows; v++) {
+      const float *row = x + v * len;
+      float max = 0.;
+      for (int j = 0; j < len; j++) max = std::max(max, std::fabs(row[j]));
+      float scale = max > 0. ? max / 127.0f : 1.0f;
+      for (int j = 0; j < len; j++) int8[v * len + j] = int8_t(std::nearbyint(row[j] / scale));
+      scales[v] = scale;
+    }
+  }
+  vec_t().swap(feats);
+}
+
+size_t FeatureStore::bytes() const {
+  return fp32.size() * sizeof(float) + bf16.size() * sizeof(uint16_t) +
+         int8.size() * sizeof(int8_t) + scales.size() * sizeof(float);
+}
+
+void FeatureStore::decode_rows(size_t begin, size_t n, const index_t *ids, float *out) const {
+  #pragma omp parallel for
+  for (size_t i = 0; i < n; i++) {
+    size_t v = ids ? ids[begin + i] : begin + i;
+    float *y = out + i * length;
+    if (precision == feat_precision::FP32) {
+      std::copy(&fp32[v * length], &fp32[(v + 1) * length], y);
+    } else if (precision == feat_precision::BF16) {
+      const uint16_t *x = &bf16[v * length];
+      for (int j = 0; j < length; j++) {
+        uint32_t bits = uint32_t(x[j]) << 16;
+        memcpy(&y[j], &bits, sizeof(bits));
+      }
+    } else {
+      const int8_t *x = &int8[v * length];
+      float scale = scales[v];
+      for (int j = 0; j < length; j++) y[j] = scale * x[j];
+    }
+  }
+}
+
+InferenceEngine::InferenceEngine(std::string model_file) : graph(NULL) {
+  std::ifstream in(model_file.c_str(), std::ios::binary);
+  if (!in) {
+    std::cout << "cannot open model file " << model_file << "\n";
+    exit(1);
+  }
+  ModelHeader header;
+  in.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!in || header.magic != MODEL_FILE_MAGIC) {
+    std::cout << model_file << " is not a model file\n";
+    exit(1);
+  }
+  arch = gnn_arch(header.arch);
+  num_layers = header.num_layers;
+  dim_init = header.dim_init;
+  dim_hid = header.dim_hid;
+  num_cls = header.num_cls;
+  use_l2norm = header.use_l2norm;
+  use_dense = header.use_dense;
+  is_sigmoid = header.is_sigmoid;
+  dims.resize(num_layers + 1, dim_hid);
+  dims[0] = dim_init;
+  dims[num_layers] = use_dense ? dim_hid : num_cls;
+  W_neigh.resize(num_layers);
+  W_self.resize(num_layers);
+  bias.resize(num_layers);
+  alpha_l.resize(num_layers);
+  alpha_r.resize(num_layers);
+  for (int l = 0; l < num_layers; l++) {
+    read_tensor(in, W_neigh[l]);
+    read_tensor(in, W_self[l]);
+    read_tensor(in, bias[l]);
+    read_tensor(in, alpha_l[l]);
+    read_tensor(in, alpha_r[l]);
+    size_t size = size_t(dims[l]) * dims[l+1];
+    assert(W_neigh[l].size() == size);
+    assert(arch != gnn_arch::SAGE || W_self[l].size() == size);
+    assert(arch != gnn_arch::GAT || alpha_l[l].size() == size_t(dims[l+1]));
+  }
+  if (use_dense) {
+    read_tensor(in, dense_weight);
+    read_tensor(in, dense_bias);
+    assert(dense_weight.size() == size_t(dim_hid) * num_cls);
+  }
+  if (!in) {
+    std::cout << "model file " << model_file << " is truncated\n";
+    exit(1);
+  }
+}
+
+void InferenceEngine::set_graph(Graph *g) {
+  graph = g;
+  size_t n = g->size();
+  norms.resize(n);
+  #pragma omp parallel for
+  for (size_t v = 0; v < n; v++) {
+    auto degree = g->get_degree(v);
+    norms[v] = degree == 0 ? 0.0f : 1.0f / std::sqrt(float(degree));
+  }
+  local_id.assign(n, index_t(-1));
+}
+
+size_t InferenceEngine::get_buffer_bytes() const {
+  return (buffers[0].size() + buffers[1].size() + tile.size() + el.size() + er.size()) * sizeof(float);
+}
+
+// the vertices within k hops of the targets, by hop; the vertices of a hop are sorted by id,
+// so that their features are decoded and gathered in the order of memory
+void InferenceEngine::build_field(const std::vector<index_t> &targets) {
+  field.clear();
+  hop_ends.clear();
+  for (auto t : targets) {
+    if (local_id[t] != index_t(-1)) continue;
+    local_id[t] = field.size();
+    field.push_back(t);
+  }
+  hop_ends.push_back(field.size());
+  auto g_rowptr = graph->row_start_ptr();
+  auto g_colidx = graph->edge_dst_ptr();
+  for (int h = 1; h <= num_layers; h++) {
+    size_t begin = h == 1 ? 0 : hop_ends[h-2];
+    size_t end = hop_ends[h-1];
+    for (size_t i = begin; i < end; i++) {
+      for (auto e = g_rowptr[field[i]]; e < g_rowptr[field[i]+1]; e++) {
+        auto u = g_colidx[e];
+        if (local_id[u] != index_t(-1)) continue;
+        local_id[u] = 0; // seen
+        field.push_back(u);
+      }
+    }
+    std::sort(field.begin() + end, field.end());
+    for (size_t i = end; i < field.size(); i++) local_id[field[i]] = i;
+    hop_ends.push_back(field.size());
+  }
+  // the rows of the vertices within k-1 hops: all their neighbors are in the field
+  size_t n = hop_ends[num_layers-1];
+  rowptr.resize(n + 1);
+  rowptr[0] = 0;
+  for (size_t i = 0; i < n; i++)
+    rowptr[i+1] = rowptr[i] + graph->get_degree(field[i]);
+  colidx.resize(rowptr[n]);
+  field_norms.resize(field.size());
+  #pragma omp parallel for
+  for (size_t i = 0; i < field.size(); i++) {
+    field_norms[i] = norms[field[i]];
+    if (i >= n) continue;
+    auto e = g_rowptr[field[i]];
+    for (auto j = rowptr[i]; j < rowptr[i+1]; j++, e++)
+      colidx[j] = local_id[g_colidx[e]];
+  }
+}
+
+// out[0:n) = in[0:n) * W of layer l; the input of layer 0 is decoded from the feature store,
+// one tile at a time, for the rows ids[0:n) (or [0:n) if ids is NULL)
+void InferenceEngine::transform(int l, size_t n, const float *in, const index_t *ids,
+                                const float *W, float *out, bool accum) {
+  int y = dims[l], z = dims[l+1];
+  if (l > 0) {
+    matmul(n, z, y, in, W, out, false, false, accum);
+    return;
+  }
+  size_t tile_rows = std::min(n, size_t(INFER_TILE_ROWS));
+  if (tile.size() < tile_rows * y) tile.resize(tile_rows * y);
+  for (size_t begin = 0; begin < n; begin += tile_rows) {
+    size_t m = std::min(n - begin, tile_rows);
+    features.decode_rows(begin, m, ids, &tile[0]);
+    matmul(m, z, y, &tile[0], W, out + begin * z, false, false, accum);
+  }
+}
+
+// out[0:n) = the aggregation of layer l of the rows in[0:n_in) of 'len' features, by the rows
+// [0:n) of the CSR
+void InferenceEngine::aggregate(int l, int len, size_t n, size_t n_in, const index_t *rows, const index_t *cols,
+                                const float *vnorms, const float *in, float *out) {
+  double t1 = omp_get_wtime();
+  if (arch == gnn_arch::GCN) {
+    fused_spmm_cpu(n, len, rows, cols, [vnorms](size_t, index_t u) { return vnorms[u]; },
+                   [vnorms](size_t v) { return vnorms[v]; }, in, out);
+  } else if (arch == gnn_arch::SAGE) {
+    fused_spmm_cpu(n, len, rows, cols, [](size_t, index_t) { return 1.0f; },
+                   [rows](size_t v) { return 1.0f / float(rows[v+1] - rows[v]); }, in, out);
+  } else {
+    // the attention of GAT_Aggregator::aggregate: the softmax over the edges of v of
+    // LeakyReLU(el[v] + er[u]), with el = alpha_l * in and er = alpha_r * in
+    const float epsilon = 0.2f; // LeakyReLU negative slope
+    el.resize(n);
+    er.resize(n_in);
+    const float *a_l = &alpha_l[l][0], *a_r = &alpha_r[l][0];
+    #pragma omp parallel for
+    for (size_t v = 0; v < n_in; v++) {
+      if (v < n) el[v] = dot(len, a_l, &in[v*len]);
+      er[v] = dot(len, a_r, &in[v*len]);
+    }
+    auto score = [epsilon](float x) { return x > 0.0f ? x : epsilon * x; };
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t v = 0; v < n; v++) {
+      auto begin = rows[v], end = rows[v+1];
+      auto a = el[v];
+      float max = -std::numeric_limits<float>::infinity(), sum = 0.;
+      for (auto e = begin; e != end; e++) {
+        auto x = score(a + er[cols[e]]);
+        if (x > max) {
+          sum = sum * expf(max - x) + 1.0f;
+          max = x;
+        } else sum += expf(x - max);
+      }
+      auto c = begin == end ? 0.0f : max + logf(sum);
+      fused_spmm::gather_row(len, in, cols, begin, end,
+                             [this, a, c, score](size_t, index_t u) { return expf(score(a + er[u]) - c); },
+                             1.0f, &out[v*len]);
+    }
+  }
+  double t2 = omp_get_wtime();
+  time_ops[OP_SPARSEMM] += t2 - t1;
+}
+
+// Layer l reads the rows [0:ends[l]) and computes the rows [0:ends[l+1]), in the two buffers:
+// the input of layer 0 is in the feature store, and its output in buffers[1]; a layer that
+// transforms first writes X * W into the other buffer, and then aggregates it over its input,
+// which is no longer needed. Returns the logits of the rows [0:ends[num_layers]).
+float *InferenceEngine::propagate(const std::vector<index_t> &ends, const index_t *ids,
+                                  const index_t *rows, const index_t *cols, const float *vnorms) {
+  size_t max_dim = *std::max_element(dims.begin() + 1, dims.end());
+  if (use_dense) max_dim = std::max(max_dim, size_t(num_cls));
+  for (int b = 0; b < 2; b++)
+    if (buffers[b].size() < ends[0] * max_dim) buffers[b].resize(ends[0] * max_dim);
+  int cur = 0; // the buffer of the input of layer l > 0
+  for (int l = 0; l < num_layers; l++) {
+    size_t n_in = ends[l], n = ends[l+1];
+    int y = dims[l], z = dims[l+1];
+    float *x = &buffers[cur][0], *other = &buffers[1-cur][0];
+    if (arch == gnn_arch::SAGE && l > 0) {
+      // mean(x of the neighbors) * W_neigh + x * W_self, a tile of rows at a time, since x is
+      // still needed after the aggregation
+      size_t tile_rows = std::min(n, size_t(INFER_TILE_ROWS));
+      if (tile.size() < tile_rows * y) tile.resize(tile_rows * y);
+      for (size_t begin = 0; begin < n; begin += tile_rows) {
+        size_t m = std::min(n - begin, tile_rows);
+        aggregate(l, y, m, n_in, rows + begin, cols, vnorms, x, &tile[0]);
+        matmul(m, z, y, &tile[0], &W_neigh[l][0], other + begin * z);
+        matmul(m, z, y, x + begin * y, &W_self[l][0], other + begin * z, false, false, true);
+      }
+      cur = 1 - cur;
+    } else if (arch == gnn_arch::GCN && l > 0 && y <= z) {
+      // aggregate first, into the other buffer, then transform back into this one
+      aggregate(l, y, n, n_in, rows, cols, vnorms, x, other);
+      matmul(n, z, y, other, &W_neigh[l][0], x);
+    } else {
+      float *t = l == 0 ? &buffers[0][0] : other;
+      float *out = l == 0 ? &buffers[1][0] : x;
+      transform(l, n_in, x, ids, &W_neigh[l][0], t, false);
+      aggregate(l, z, n, n_in, rows, cols, vnorms, t, out);
+      if (arch == gnn_arch::SAGE) transform(l, n, x, ids, &W_self[l][0], out, true);
+      if (l == 0) cur = 1;
+    }
+    float *h = &buffers[cur][0];
+    if (!bias[l].empty()) bias_mv(n, z, h, &bias[l][0]);
+    if (l < num_layers - 1) relu_cpu(n * z, h, h);
+  }
+  size_t n = ends[num_layers];
+  float *h = &buffers[cur][0];
+  if (use_l2norm) {
+    #pragma omp parallel for
+    for (size_t v = 0; v < n; v++) {
+      float sum = 0;
+      for (int j = 0; j < dim_hid; j++) sum += h[v*dim_hid+j] * h[v*dim_hid+j];
+      sum = std::sqrt(std::max(sum, 1.0e-12f));
+      for (int j = 0; j < dim_hid; j++) h[v*dim_hid+j] /= sum;
+    }
+  }
+  if (use_dense) {
+    float *out = &buffers[1-cur][0];
+    matmul(n, num_cls, dim_hid, h, &dense_weight[0], out);
+    if (!dense_bias.empty()) bias_mv(n, num_cls, out, &dense_bias[0]);
+    h = out;
+  }
+  return h;
+}
+
+void InferenceEngine::infer_all(float *out) {
+  size_t n = graph->size();
+  std::vector<index_t> ends(num_layers + 1, n);
+  auto logits = propagate(ends, NULL, graph->row_start_ptr(), graph->edge_dst_ptr(), &norms[0]);
+  std::copy(logits, logits + n * num_cls, out);
+}
+
+void InferenceEngine::infer(const std::vector<index_t> &targets, float *out) {
+  build_field(targets);
+  std::vector<index_t> ends(num_layers + 1);
+  for (int l = 0; l <= num_layers; l++) ends[l] = hop_ends[num_layers - l];
+  auto logits = propagate(ends, field.data(), rowptr.data(), colidx.data(), field_norms.data());
+  #pragma omp parallel for
+  for (size_t i = 0; i < targets.size(); i++) {
+    auto row = logits + size_t(local_id[targets[i]]) * num_cls;
+    std::copy(row, row + num_cls, out + i * num_cls);
+  }
+  for (auto v : field) local_id[v] = index_t(-1);
+}
@@ -2,9 +2,10 @@
 // Authors: Xuhao Chen <cxh@mit.edu>
 #include "lgraph.h"
 #include "reader.h"
+#include <unistd.h>
 
 void LearningGraph::compute_edge_data() {
-  if (edge_data_ && edata_size < num_edges_) delete[] edge_data_; // graph size may change due to subgraph sampling
+  if (edge_data_ && edata_size < num_edges_) { delete[] edge_data_; edge_data_ = NULL; } // graph size may change due to subgraph sampling
   if (edge_data_ == NULL) edge_data_ = new edata_t[num_edges_];
   edata_size = num_edges_;
   #pragma omp parallel for
@@ -12,7 +13,7 @@ void LearningGraph::compute_edge_data() {
     float c_i = std::sqrt(float(get_degree(i)));
     for (auto e = edge_begin(i); e != edge_end(i); e++) {
       const auto j = getEdgeDst(e);
-      float c_j  = std::sqrt(float(get_degree(j)));
+      float c_j  = std::sqrt(float(transposed().get_degree(j))); // the in-degree of j
       if (c_i == 0.0 || c_j == 0.0) edge_data_[e] = 0.0;
       else edge_data_[e] = 1.0 / (c_i * c_j);
     }
@@ -21,7 +22,7 @@ void LearningGraph::compute_edge_data() {
 
 void LearningGraph::compute_vertex_data() {
   //std::cout << "Computing vertex data\n";
-  if (vertex_data_ && vdata_size < num_vertices_) delete[] vertex_data_; // graph size may change due to subgraph sampling
+  if (vertex_data_ && vdata_size < num_vertices_) { delete[] vertex_data_; vertex_data_ = NULL; } // graph size may change due to subgraph sampling
   if (vertex_data_ == NULL) vertex_data_ = new vdata_t[num_vertices_];
   vdata_size = num_vertices_;
   #pragma omp parallel for
@@ -38,123 +39,99 @@ void LearningGraph::dealloc() {
   delete[] colidx_;
   if (vertex_data_) delete[] vertex_data_;
   if (edge_data_) delete[] edge_data_;
+  rowptr_ = colidx_ = NULL;
+  vertex_data_ = NULL;
+  edge_data_ = NULL;
+  vdata_size = edata_size = 0;
 }
 
-void LearningGraph::update_feat_len(size_t len) {
-  for (int i = 0; i < num_subgraphs; ++i) {
-    #pragma omp parallel for
-    for (index_t j = 0; j < nvs_of_subgraphs[i]; ++j) {
-      delete[] partial_sums[i][j];
-      partial_sums[i][j] = new float[len];
-    }
+// size in bytes of the (data or unified) cache of the given level, 0 if unknown
+static size_t get_cache_size(int level) {
+  long size = sysconf(level == 2 ? _SC_LEVEL2_CACHE_SIZE : _SC_LEVEL3_CACHE_SIZE);
+  if (size > 0) return size;
+  for (int i = 0; i < 8; i++) {
+    std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(i) + "/";
+    std::ifstream level_file(dir + "level"), size_file(dir + "size");
+    if (!level_file || !size_file) break;
+    int l = 0;
+    std::string s;
+    level_file >> l;
+    size_file >> s;
+    if (l != level || s.empty()) continue;
+    size_t bytes = std::stoul(s);
+    if (s.back() == 'K') bytes <<= 10;
+    else if (s.back() == 'M') bytes <<= 20;
+    return bytes;
   }
+  return 0;
 }
 
 // This implements the CSR segmenting technique for graph computation
 // This is for pull model, using incomming edges
+// The source vertices are split into subgraphs whose feature tiles (of up to MAX_FEAT_TILE
+// features, len rounded up) fit in half of the LLC, and the destinations into ranges whose
+// output tiles fit in half of the L2; the other halves are left to the edges and partial sums.
 void LearningGraph::segmenting(size_t len) {
-  num_subgraphs = (num_vertices_ - 1) / SUBGRAPH_SIZE + 1;
-  num_ranges = (num_vertices_ - 1) / RANGE_WIDTH + 1;
+  feat_tile = std::min(MAX_FEAT_TILE, int((len + 15) / 16 * 16));
+  size_t tile_bytes = feat_tile * sizeof(float);
+  size_t l2 = get_cache_size(2);
+  size_t llc = get_cache_size(3);
+  if (l2 == 0) l2 = 1024 * 1024;
+  if (llc < l2) llc = l2;
+  // the LLC is shared with the cores (or tenants) not running this process: count the
+  // slices of the threads only
+  llc = std::min(llc, size_t(omp_get_max_threads()) * LLC_SLICE);
+  subgraph_size = std::max(size_t(MIN_SUBGRAPH_SIZE), llc / 2 / tile_bytes);
+  range_width = std::max(size_t(MIN_RANGE_WIDTH), l2 / 2 / tile_bytes);
+  num_subgraphs = (num_vertices_ - 1) / subgraph_size + 1;
+  num_ranges = (num_vertices_ - 1) / range_width + 1;
+  printf("L2 = %lu KB, LLC = %lu KB, feature tile = %d, subgraph size = %u, range width = %u\n",
+         l2 >> 10, llc >> 10, feat_tile, subgraph_size, range_width);
   printf("number of subgraphs and ranges: %d, %d\n", num_subgraphs, num_ranges);
 
   Timer t;
   t.Start();
-/*
   rowptr_blocked.resize(num_subgraphs);
   colidx_blocked.resize(num_subgraphs);
-  //edge_data_blocked.resize(num_subgraphs);
-  nvs_of_subgraphs.resize(num_subgraphs, 0);
-  nes_of_subgraphs.resize(num_subgraphs, 0);
+  nvs_of_subgraphs.resize(num_subgraphs);
+  nes_of_subgraphs.resize(num_subgraphs);
   idx_map.resize(num_subgraphs);
   range_indices.resize(num_subgraphs);
-  //partial_sums.resize(num_subgraphs);
-  std::vector<int> flag(num_subgraphs, false);
-  //for (int i = 0; i < num_subgraphs; ++i) {
-  //  nvs_of_subgraphs[i] = 0;
-  //  nes_of_subgraphs[i] = 0;
-  //}
-
-  std::cout << "calculating number of vertices and edges in each subgraph\n";
-  for (index_t dst = 0; dst < num_vertices_; ++ dst) {
-    auto start = rowptr_[dst];
-    auto end = rowptr_[dst+1];
-    for (auto j = start; j < end; ++j) {
-      auto src = colidx_[j];
-      auto bcol = src / SUBGRAPH_SIZE;
-      flag[bcol] = true;
-      nes_of_subgraphs[bcol]++;
-    }
-    for (int i = 0; i < num_subgraphs; ++i) {
-      if (flag[i]) nvs_of_subgraphs[i] ++;
-    }
-    for (int i = 0; i < num_subgraphs; ++i) flag[i] = false;
-  }
-
-  std::cout << "allocating memory for each subgraph\n";
-  for (int i = 0; i < num_subgraphs; ++i) {
-    rowptr_blocked[i].resize(nvs_of_subgraphs[i]+1);
-    colidx_blocked[i].resize(nes_of_subgraphs[i]);
-    //edge_data_blocked[i].resize(nes_of_subgraphs[i]);
-    //partial_sums[i].resize(nvs_of_subgraphs[i]);
-    nes_of_subgraphs[i] = 0;
-    rowptr_blocked[i][0] = 0;
-  }
   for (int i = 0; i < num_subgraphs; ++i) {
-    //#pragma omp parallel for
-    for (index_t j = 0; j < nvs_of_subgraphs[i]; ++j) {
-      //partial_sums[i][j].reserve(len);
-      //partial_sums[i][j].resize(len);
-    }
-  }
-
-  std::cout << "allocating memory for IdxMap, RangeIndices and IntermBuf\n";
-  for (int i = 0; i < num_subgraphs; ++i) {
-    idx_map[i].resize(nvs_of_subgraphs[i]);
-    range_indices[i].resize(num_ranges+1);
-    range_indices[i][0] = 0;
+    rowptr_blocked[i].assign(1, 0);
+    colidx_blocked[i].clear();
+    idx_map[i].clear();
+    range_indices[i].assign(num_ranges+1, 0);
   }
-
-  std::cout << "constructing the blocked CSR\n";
-  std::vector<int> index(num_subgraphs, 0);
+  // one pass over the edges, bucketed by the subgraph of their source: the destinations are
+  // visited in order, so that each one gets the next local id in the subgraphs it has edges in
+  std::vector<index_t> last_dst(num_subgraphs, index_t(-1));
   for (index_t dst = 0; dst < num_vertices_; ++ dst) {
-    for (index_t j = rowptr_[dst]; j < rowptr_[dst+1]; ++j) {
-      index_t src = colidx_[j];
-      int bcol = src / SUBGRAPH_SIZE;
-      colidx_blocked[bcol][nes_of_subgraphs[bcol]] = src;
-      //assert(!edge_data_.empty());
-      //edge_data_blocked[bcol][nes_of_subgraphs[bcol]] = edge_data_[j];
-      flag[bcol] = true;
-      nes_of_subgraphs[bcol]++;
-    }
-    for (int i = 0; i < num_subgraphs; ++i) {
-      if (flag[i]) {
-        idx_map[i][index[i]] = dst;
-        rowptr_blocked[i][++index[i]] = nes_of_subgraphs[i];
+    for (auto j = rowptr_[dst]; j < rowptr_[dst+1]; ++j) {
+      auto src = colidx_[j];
+      int i = src / subgraph_size;
+      auto &rowptr = rowptr_blocked[i];
+      if (last_dst[i] != dst) {
+        last_dst[i] = dst;
+        idx_map[i].push_back(dst);
+        rowptr.push_back(rowptr.back());
+        range_indices[i][dst/range_width+1] ++;
       }
+      colidx_blocked[i].push_back(src);
+      rowptr.back() ++;
     }
-    for (int i = 0; i < num_subgraphs; ++i) flag[i] = false;
   }
-  //printf("printing subgraphs:\n");
-  //for (int i = 0; i < num_subgraphs; ++i) {
-  //  printf("\tprinting subgraph[%d] (%d vertices, %d edges):\n", i, nvs_of_subgraphs[i], nes_of_subgraphs[i]);
-  //}
-
-  std::cout << "constructing IdxMap and RangeIndices\n";
   for (int i = 0; i < num_subgraphs; ++i) {
-    std::vector<int> counts(num_ranges, 0);
-    for (index_t j = 0; j < nvs_of_subgraphs[i]; ++ j) {
-      int dst = idx_map[i][j];
-      counts[dst/RANGE_WIDTH] ++;
-    }
-    for (int j = 1; j < num_ranges+1; ++j) {
-      range_indices[i][j] = range_indices[i][j-1] + counts[j-1];
-    }
+    auto &ranges = range_indices[i];
+    for (int j = 0; j < num_ranges; ++j) ranges[j+1] += ranges[j];
+    nvs_of_subgraphs[i] = idx_map[i].size();
+    nes_of_subgraphs[i] = rowptr_blocked[i].back();
   }
   partitioned = true;
-*/
   t.Stop();
   std::cout << "preprocessing time = " << t.Millisecs() << " ms.\n";
 }
+
 void LearningGraph::alloc_on_device() {}
 void LearningGraph::alloc_on_device(index_t n) {}
 void LearningGraph::copy_to_gpu() {}
@@ -0,0 +1,180 @@
+#include "neighbor_sampler.h"
+
+// The draws of batch b and layer l form the stream b * num_layers + l, indexed by
+// (vertex << 32 | draw); the shuffle of epoch i is keyed by the stream SHUFFLE_STREAM | i.
+#define SHUFFLE_STREAM (uint64_t(1) << 63)
+
+NeighborSampler::NeighborSampler(Graph* g, std::vector<index_t> train_nodes, std::vector<int> fo,
+                                 index_t bs, int num_epochs, const float* x, int xlen,
+                                 const label_t* y, int ylen, bool sl, int nw, int d, uint64_t s) :
+    graph(g), nodes(train_nodes), fanouts(fo), batch_size(bs), feats(x), feat_len(xlen),
+    labels(y), label_len(ylen), selfloop(sl), num_workers(nw), depth(d), rng(s),
+    next_consumed(0), next_produced(0), stopping(false) {
+  assert(batch_size > 0 && !nodes.empty() && !fanouts.empty());
+  num_batches = (nodes.size() - 1) / batch_size + 1;
+  total_batches = num_batches * num_epochs;
+  if (depth < num_workers) depth = num_workers;
+  slots.resize(depth);
+  slot_next.resize(depth);
+  slot_ready.assign(depth, false);
+  for (int i = 0; i < depth; i++) slot_next[i] = i;
+  std::cout << "neighbor sampling: batch size " << batch_size << ", " << num_batches
+            << " batches per epoch, " << num_workers << " workers, " << depth << " batches prefetched\n";
+}
+
+NeighborSampler::~NeighborSampler() {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stopping = true;
+  }
+  cv.notify_all();
+  for (auto &t : workers) t.join();
+}
+
+void NeighborSampler::start() {
+  for (int i = 0; i < num_workers; i++)
+    workers.push_back(std::thread(&NeighborSampler::produce, this));
+}
+
+MiniBatch* NeighborSampler::next() {
+  std::unique_lock<std::mutex> lock(mtx);
+  assert(next_consumed < total_batches);
+  auto s = next_consumed % depth;
+  cv.wait(lock, [&] { return slot_ready[s]; });
+  return &slots[s];
+}
+
+void NeighborSampler::release(MiniBatch* batch) {
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto s = batch->id % depth;
+    assert(batch->id == next_consumed);
+    slot_ready[s] = false;
+    slot_next[s] = batch->id + depth;
+    next_consumed ++;
+  }
+  cv.notify_all();
+}
+
+void NeighborSampler::produce() {
+  std::vector<index_t> local_ids(graph->size(), index_t(-1)); // of the vertices of the batch
+  std::vector<std::vector<index_t>> edges(fanouts.size()); // sampled (dst, src) pairs of local ids, by layer
+  while (true) {
+    auto id = next_produced++;
+    if (id >= total_batches) return;
+    auto s = id % depth;
+    {
+      std::unique_lock<std::mutex> lock(mtx);
+      cv.wait(lock, [&] { return stopping || slot_next[s] == id; });
+      if (stopping) return;
+    }
+    sample(id, local_ids, edges, slots[s]);
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      slot_ready[s] = true;
+    }
+    cv.notify_all();
+  }
+}
+
+void NeighborSampler::sample(int64_t id, std::vector<index_t>& local_ids,
+                             std::vector<std::vector<index_t>>& edges, MiniBatch& batch) {
+  int64_t epoch = id / num_batches;
+  uint64_t begin = (id % num_batches) * batch_size;
+  uint64_t end = std::min(uint64_t(nodes.size()), begin + batch_size);
+  batch.id = id;
+  batch.num_seeds = end - begin;
+  auto &vertices = batch.vertices;
+  vertices.clear();
+  for (auto i = begin; i < end; i++) {
+    auto v = nodes[rng.permute(SHUFFLE_STREAM | epoch, i, nodes.size())];
+    local_ids[v] = vertices.size();
+    vertices.push_back(v);
+  }
+  int num_layers = fanouts.size();
+  std::vector<index_t> num_dst(num_layers);
+  std::vector<index_t> picks;
+  for (int l = num_layers-1; l >= 0; l--) {
+    edges[l].clear();
+    num_dst[l] = vertices.size();
+    for (index_t i = 0; i < num_dst[l]; i++) {
+      auto u = vertices[i];
+      auto row = graph->edge_begin_host(u);
+      index_t deg = graph->edge_end_host(u) - row;
+      index_t k = fanouts[l];
+      picks.clear();
+      if (fanouts[l] <= 0 || deg <= k) {
+        for (index_t j = 0; j < deg; j++) picks.push_back(j);
+      } else {
+        // Floyd's algorithm: k distinct positions out of deg
+        for (index_t j = deg - k; j < deg; j++) {
+          index_t t = rng.below(j + 1, id * num_layers + l, (uint64_t(u) << 32) | j);
+          if (std::find(picks.begin(), picks.end(), t) != picks.end()) t = j;
+          picks.push_back(t);
+        }
+      }
+      for (auto j : picks) {
+        auto w = graph->getEdgeDstHost(row + j);
+        if (local_ids[w] == index_t(-1)) {
+          local_ids[w] = vertices.size();
+          vertices.push_back(w);
+        }
+        edges[l].push_back(i);
+        edges[l].push_back(local_ids[w]);
+      }
+    }
+  }
+  for (auto v : vertices) local_ids[v] = index_t(-1);
+
+  size_t nv = vertices.size();
+  batch.blocks.resize(num_layers);
+  batch.trans_blocks.resize(num_layers);
+  for (int l = 0; l < num_layers; l++)
+    build_block(nv, num_dst[l], edges[l], batch.blocks[l], batch.trans_blocks[l]);
+  batch.feats.resize(nv * feat_len);
+  batch.labels.resize(nv * label_len);
+  for (size_t i = 0; i < nv; i++) {
+    auto v = vertices[i];
+    std::copy(feats + size_t(v) * feat_len, feats + size_t(v+1) * feat_len, &batch.feats[i * feat_len]);
+    std::copy(labels + size_t(v) * label_len, labels + size_t(v+1) * label_len, &batch.labels[i * label_len]);
+  }
+}
+
+// the block of a layer from its sampled edges, without the duplicates (e.g., a sampled
+// self-loop), and with a self-loop on each dst vertex if requested; then its transpose
+void NeighborSampler::build_block(index_t nv, index_t num_dst, const std::vector<index_t>& edges,
+                                  BlockCSR& block, BlockCSR& trans_block) {
+  auto &rowptr = block.rowptr;
+  auto &colidx = block.colidx;
+  rowptr.assign(nv + 1, 0);
+  for (size_t e = 0; e < edges.size(); e += 2) rowptr[edges[e]+1] ++;
+  if (selfloop) for (index_t v = 0; v < num_dst; v++) rowptr[v+1] ++;
+  for (index_t v = 0; v < nv; v++) rowptr[v+1] += rowptr[v];
+  colidx.resize(rowptr[nv]);
+  std::vector<index_t> pos(rowptr.begin(), rowptr.end() - 1);
+  for (size_t e = 0; e < edges.size(); e += 2) colidx[pos[edges[e]]++] = edges[e+1];
+  if (selfloop) for (index_t v = 0; v < num_dst; v++) colidx[pos[v]++] = v;
+  // sort and compact the rows in place
+  index_t ne = 0;
+  for (index_t v = 0; v < nv; v++) {
+    auto first = colidx.begin() + rowptr[v];
+    auto last = colidx.begin() + rowptr[v+1];
+    std::sort(first, last);
+    auto row_end = std::unique(first, last);
+    rowptr[v] = ne;
+    ne = std::copy(first, row_end, colidx.begin() + ne) - colidx.begin();
+  }
+  rowptr[nv] = ne;
+  colidx.resize(ne);
+  // the rows of the transpose come out sorted, as the rows of the block are visited in order
+  auto &trans_rowptr = trans_block.rowptr;
+  auto &trans_colidx = trans_block.colidx;
+  trans_rowptr.assign(nv + 1, 0);
+  for (auto u : colidx) trans_rowptr[u+1] ++;
+  for (index_t v = 0; v < nv; v++) trans_rowptr[v+1] += trans_rowptr[v];
+  trans_colidx.resize(ne);
+  pos.assign(trans_rowptr.begin(), trans_rowptr.end() - 1);
+  for (index_t v = 0; v < nv; v++)
+    for (auto e = rowptr[v]; e < rowptr[v+1]; e++)
+      trans_colidx[pos[colidx[e]]++] = v;
+}
@@ -33,6 +33,7 @@ void Model<gconv_layer>::load_data(int argc, char* argv[]) {
   lrate = DEFAULT_RATE_LEARN;
   num_layers = DEFAULT_NUM_LAYER;
   subg_size = 0;
+  batch_size = 0;
   val_interval = EVAL_INTERVAL;
   if (argc == 6) {
     dim_hid = atoi(argv[5]);
@@ -49,7 +50,7 @@ void Model<gconv_layer>::load_data(int argc, char* argv[]) {
     feat_drop = atof(argv[7]);
     lrate = atof(argv[8]);
   } else if (argc > 9) {
-    assert(argc == 13);
+    assert(argc >= 13 && argc <= 16);
     dim_hid = atoi(argv[5]);
     score_drop = atof(argv[6]);
     feat_drop = atof(argv[7]);
@@ -58,8 +59,21 @@ void Model<gconv_layer>::load_data(int argc, char* argv[]) {
     subg_size = atoi(argv[10]);
     val_interval = atoi(argv[11]);
     inductive = atoi(argv[12]);
+    if (argc == 14 || argc == 16) model_file = argv[argc-1];
+    if (argc >= 15) {
+      batch_size = atoi(argv[13]);
+      // comma-separated, from the first layer to the last; the last one is repeated if needed
+      std::stringstream ss(argv[14]);
+      std::string fanout;
+      while (std::getline(ss, fanout, ',')) fanouts.push_back(atoi(fanout.c_str()));
+    }
   }
   assert(num_layers >= 2);
+  assert(subg_size == 0 || batch_size == 0);
+  if (batch_size > 0) {
+    if (fanouts.empty()) fanouts.push_back(0);
+    fanouts.resize(num_layers, fanouts.back());
+  }
 
   // l2norm+dense layer is useful for sampling and GAT
   if (subg_size > 0 || arch == gnn_arch::GAT) use_l2norm = true;
@@ -152,6 +166,21 @@ void Model<gconv_layer>::load_data(int argc, char* argv[]) {
     }
     subg_masks = new mask_t[num_samples * num_subgraphs];
   }
+  if (batch_size > 0) {
+    assert(!use_gpu);
+    std::vector<index_t> train_nodes;
+    for (int i = 0; i < num_samples; i++)
+      if (masks_train[i] == 1) train_nodes.push_back(i);
+    loader = new NeighborSampler(training_graph, train_nodes, fanouts, batch_size, num_epochs,
+                                 &input_features[0], dim_init, &labels[0], is_sigmoid ? num_cls : 1,
+                                 arch != gnn_arch::SAGE);
+    for (int l = 0; l < num_layers; l++) {
+      blocks.push_back(new Graph(use_gpu));
+      trans_blocks.push_back(new Graph(use_gpu));
+      blocks[l]->set_transposed(trans_blocks[l]);
+      trans_blocks[l]->set_transposed(blocks[l]);
+    }
+  }
   if (use_gpu) {
     if (subg_size > 0) {
       float_malloc_device(subg_size*dim_init, d_feats_subg);
@@ -167,10 +196,10 @@ void Model<gconv_layer>::load_data(int argc, char* argv[]) {
   if (subg_size == 0 || !use_gpu) {
 #if (defined(USE_MKL) && defined(PRECOMPUTE_SCORES)) || (defined(ENABLE_GPU) && defined(USE_CUSPARSE))
     if (inductive) training_graph->compute_edge_data();
-    else full_graph->compute_edge_data();
+    if (!inductive || !use_gpu) full_graph->compute_edge_data(); // evaluate() on CPU reuses it
 #else
     if (inductive) training_graph->compute_vertex_data();
-    else full_graph->compute_vertex_data();
+    if (!inductive || !use_gpu) full_graph->compute_vertex_data(); // evaluate() on CPU reuses it
 #endif
   }
 }
@@ -197,6 +226,26 @@ void Model<gconv_layer>::transfer_data_to_device() {
   copy_uint8_device(num_samples, &masks_val[0], d_masks_val);
 }
 
+template <typename gconv_layer>
+void Model<gconv_layer>::save_model() {
+#ifdef ENABLE_GPU
+  std::cout << "saving the model is not supported on GPU\n";
+#else
+  std::ofstream out(model_file.c_str(), std::ios::binary);
+  if (!out) {
+    std::cout << "cannot open model file " << model_file << "\n";
+    exit(1);
+  }
+  ModelHeader header = {MODEL_FILE_MAGIC, int32_t(arch), num_layers, dim_init, dim_hid, num_cls,
+                        use_l2norm, use_dense, is_sigmoid};
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (int i = 0; i < num_layers; i++)
+    layer_gconv[i].save_weights(out);
+  if (use_dense) layer_dense->save_weights(out);
+  std::cout << "model saved to " << model_file << "\n";
+#endif
+}
+
 template <typename gconv_layer>
 void Model<gconv_layer>::update_weights(optimizer* opt) {
   //std::cout << "Updating weights\n";
@@ -264,9 +313,9 @@ void Model<gconv_layer>::subgraph_sampling(int curEpoch, int &num_subg_remain) {
     #pragma omp parallel for
     for (int sid = 0; sid < num_subgraphs; sid++) {
       VertexSet sampledSet;
-      auto tid = omp_get_thread_num();
-      auto seed = tid;
-      //auto seed = curEpoch;
+      // subgraph sid is trained at epoch curEpoch + num_subgraphs-1-sid: the subgraph of
+      // an epoch is drawn from the stream of that epoch, whatever the number of threads
+      uint64_t seed = curEpoch + num_subgraphs - 1 - sid;
       auto nv = sampler->select_vertices(subg_size, sampledSet, seed);
       //std::cout << nv << " vertices seleceted\n";
       sampler->generateSubgraph(sampledSet, &subg_masks[sid*num_samples], get_subg_ptr(sid));
@@ -286,6 +335,7 @@ void Model<gconv_layer>::subgraph_sampling(int curEpoch, int &num_subg_remain) {
   int sg_id     = num_subg_remain;
   auto subg_ptr = get_subg_ptr(sg_id);
   subg_nv = subg_ptr->size();
+  subg_nseeds = subg_nv;
 
 #ifdef ENABLE_GPU
   if (arch != gnn_arch::SAGE) subg_ptr->add_selfloop();
@@ -327,29 +377,106 @@ void Model<gconv_layer>::subgraph_sampling(int curEpoch, int &num_subg_remain) {
   //std::cout << "Sampling done!\n";
 }
 
+static void copy_block(index_t nv, const BlockCSR& block, Graph* g) {
+  g->dealloc();
+  g->allocateFrom(nv, block.colidx.size());
+  std::copy(block.rowptr.begin(), block.rowptr.end(), g->row_start_host_ptr());
+  std::copy(block.colidx.begin(), block.colidx.end(), g->edge_dst_host_ptr());
+  g->degree_counting();
+}
+
+// switch the network to the blocks, features and labels of a mini-batch
+template <typename gconv_layer>
+void Model<gconv_layer>::use_minibatch(MiniBatch* batch) {
+  double t1 = omp_get_wtime();
+  subg_nv = batch->vertices.size();
+  subg_nseeds = batch->num_seeds;
+  for (int i = 0; i < num_layers; i++) {
+    copy_block(subg_nv, batch->blocks[i], blocks[i]);
+    copy_block(subg_nv, batch->trans_blocks[i], trans_blocks[i]);
+    // the scores of a block need the degrees of its transpose
+#if defined(USE_MKL) && defined(PRECOMPUTE_SCORES)
+    blocks[i]->compute_edge_data();
+    trans_blocks[i]->compute_edge_data();
+#else
+    blocks[i]->compute_vertex_data();
+    trans_blocks[i]->compute_vertex_data();
+#endif
+    layer_gconv[i].update_dim_size(subg_nv);
+    layer_gconv[i].set_graph_ptr(blocks[i]);
+  }
+  if (use_l2norm) layer_l2norm->update_dim_size(subg_nv);
+  if (use_dense) layer_dense->update_dim_size(subg_nv);
+  layer_loss->update_dim_size(subg_nv);
+  layer_gconv[0].set_feat_in(&batch->feats[0]);
+  layer_loss->set_labels_ptr(&batch->labels[0]);
+  double t2 = omp_get_wtime();
+  time_ops[OP_COPY] += t2 - t1;
+}
+
+// one epoch of mini-batch training; the batches are sampled by the loader in the background,
+// so only the time spent waiting for a batch is counted as sampling time
+template <typename gconv_layer>
+acc_t Model<gconv_layer>::train_minibatches(optimizer* opt, acc_t& loss, double& fw_time, double& bw_time) {
+  acc_t total_loss = 0., total_acc = 0.;
+  size_t total_seeds = 0;
+  fw_time = bw_time = 0.;
+  for (int64_t b = 0; b < loader->batches_per_epoch(); b++) {
+    double t1 = omp_get_wtime();
+    auto batch = loader->next();
+    double t2 = omp_get_wtime();
+    time_ops[OP_SAMPLE] += t2 - t1;
+    use_minibatch(batch);
+    set_netphases(net_phase::TRAIN);
+    acc_t batch_loss = 0.;
+    double t_f1 = omp_get_wtime();
+    auto batch_acc = forward_prop(batch_loss);
+    double t_f2 = omp_get_wtime();
+    backward_prop();
+    update_weights(opt);
+    double t_b2 = omp_get_wtime();
+    fw_time += t_f2 - t_f1;
+    bw_time += t_b2 - t_f2;
+    total_loss += batch_loss * subg_nseeds;
+    total_acc += batch_acc * subg_nseeds;
+    total_seeds += subg_nseeds;
+    loader->release(batch);
+  }
+  loss = total_loss / total_seeds;
+  return total_acc / total_seeds;
+}
+
 template <typename gconv_layer>
 void Model<gconv_layer>::train() {
   optimizer* opt = new adam(lrate);
   std::cout << "Start training...\n";
   double total_train_time = 0.0;
   int num_subg_remain = 0;
+  if (batch_size > 0) loader->start();
 
   for (int itr = 0; itr < num_epochs; itr ++) {
     if (subg_size > 0) subgraph_sampling(itr, num_subg_remain);
     std::cout << "Epoch " << std::setw(3) << itr << " ";
     // training
-    set_netphases(net_phase::TRAIN);
-    acc_t train_loss = 0.0;
-    double t_f1 = omp_get_wtime();
-    auto train_acc = forward_prop(train_loss);
-    double t_f2 = omp_get_wtime();
-    double fw_time = t_f2 - t_f1;
-    double t_b1 = omp_get_wtime();
-    backward_prop();
-    update_weights(opt);
-    double t_b2 = omp_get_wtime();
-    double bw_time = t_b2 - t_b1;
-    double epoch_time = fw_time + bw_time;
+    acc_t train_loss = 0.0, train_acc = 0.0;
+    double fw_time = 0.0, bw_time = 0.0;
+    double t_e1 = omp_get_wtime();
+    if (batch_size > 0) {
+      train_acc = train_minibatches(opt, train_loss, fw_time, bw_time);
+    } else {
+      set_netphases(net_phase::TRAIN);
+      double t_f1 = omp_get_wtime();
+      train_acc = forward_prop(train_loss);
+      double t_f2 = omp_get_wtime();
+      fw_time = t_f2 - t_f1;
+      double t_b1 = omp_get_wtime();
+      backward_prop();
+      update_weights(opt);
+      double t_b2 = omp_get_wtime();
+      bw_time = t_b2 - t_b1;
+    }
+    double t_e2 = omp_get_wtime();
+    double epoch_time = t_e2 - t_e1;
     total_train_time += epoch_time;
     std::cout << "train_loss " << std::setprecision(3) << std::fixed
               << train_loss << " train_acc " << train_acc << " ";
@@ -386,6 +513,13 @@ void Model<gconv_layer>::train() {
     free_device<label_t>(d_labels_subg);
 #endif
   }
+  if (batch_size > 0) {
+    delete loader;
+    for (int l = 0; l < num_layers; l++) {
+      blocks[l]->dealloc();
+      trans_blocks[l]->dealloc();
+    }
+  }
   if (inductive) training_graph->dealloc();
 }
 
@@ -443,16 +577,16 @@ acc_t Model<gconv_layer>::forward_prop(acc_t& loss) {
   labels_ptr = d_labels;
 #endif
   size_t begin = train_begin, end = train_end, count = train_count;
-  if (subg_size > 0) {
+  if (subg_size > 0 || batch_size > 0) {
 #ifdef ENABLE_GPU
     labels_ptr = d_labels_subg;
 #else
-    labels_ptr = &labels_subg[0];
+    labels_ptr = layer_loss->get_labels_ptr();
 #endif
     masks_ptr = NULL;
     begin = 0;
-    end = subg_nv;
-    count = subg_nv;
+    end = subg_nseeds;
+    count = subg_nseeds;
   }
   layer_loss->forward(begin, end, masks_ptr);
   loss = layer_loss->get_prediction_loss(begin, end, count, masks_ptr);
@@ -471,7 +605,7 @@ acc_t Model<gconv_layer>::forward_prop(acc_t& loss) {
 template <typename gconv_layer>
 acc_t Model<gconv_layer>::evaluate(std::string type) {
   set_netphases(net_phase::TEST);
-  if (subg_size > 0 || inductive) {
+  if (subg_size > 0 || batch_size > 0 || inductive) {
     // not training; switch back to use the full graph
     for (int i = 0; i < num_layers; i++)
       layer_gconv[i].set_graph_ptr(full_graph);
@@ -485,7 +619,7 @@ acc_t Model<gconv_layer>::evaluate(std::string type) {
   #endif
 #endif
     // for sampling, also need to switch back the input features and labels
-    if (subg_size > 0) {
+    if (subg_size > 0 || batch_size > 0) {
       for (int i = 0; i < num_layers; i++)
         layer_gconv[i].update_dim_size(num_samples);
       if (use_dense) layer_dense->update_dim_size(num_samples);
@@ -547,10 +681,10 @@ void Model<gconv_layer>::backward_prop() {
   masks_ptr = d_masks_train;
 #endif
   size_t begin = train_begin, end = train_end;
-  if (subg_size > 0) {
+  if (subg_size > 0 || batch_size > 0) {
     masks_ptr = NULL;
     begin = 0;
-    end = subg_nv;
+    end = subg_nseeds;
   }
   if (use_dense) {
     layer_loss->backward(begin, end, masks_ptr, layer_dense->get_grad_in());
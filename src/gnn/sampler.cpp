@@ -1,4 +1,5 @@
 #include "utils.h"
+#include "scan.h"
 #include "sampler.h"
 
 //! debug function: prints out sets of vertices
@@ -21,8 +22,7 @@ size_t Sampler::selectVertices(index_t n, VertexSet& vertex_set, unsigned seed)
   #pragma omp parallel for
   for (index_t i = 0; i < nv; i++)
     vertices[i] = i;
-  srand(seed);
-  return selectVertices(nv, n, full_graph, vertices, vertex_set); 
+  return selectVertices(nv, n, full_graph, vertices, vertex_set, seed);
 }
 */
 
@@ -31,11 +31,12 @@ size_t Sampler::selectVertices(index_t n, VertexSet& vertex_set, unsigned seed)
 // nv: number of vertices in the original graph;
 // n: number of vertices in the subgraph;
 // m: number of vertices in the frontier.
-size_t Sampler::selectVertices(index_t nv, index_t n, Graph* g, VertexList vertices, VertexSet& vertex_set) {
+size_t Sampler::selectVertices(index_t nv, index_t n, Graph* g, VertexList vertices, VertexSet& vertex_set, uint64_t seed) {
   // "Select a vertex set of size ", n, " from ", nv, " vertices, graph size: ", g->size(), "\n");
   assert(nv == vertices.size());
+  PhiloxStream rs(rng, seed);
   // randomly select m vertices from vertices as frontier
-  auto frontier_indices = utils::select_k_items((int)m, 0, (int)nv);
+  auto frontier_indices = utils::select_k_items((int)m, 0, (int)nv, rs);
   VertexList frontier(m);
   for (index_t i = 0; i < m; i++)
     frontier[i] = vertices[frontier_indices[i]];
@@ -44,12 +45,12 @@ size_t Sampler::selectVertices(index_t nv, index_t n, Graph* g, VertexList verti
   for (index_t i = 0; i < m; i++)
     degrees[i] = (int)getDegree(g, frontier[i]);
   for (index_t i = 0; i < n - m; i++) {
-    auto pos    = utils::select_one_item((int)m, degrees);
+    auto pos    = utils::select_one_item((int)m, degrees, rs);
     auto u      = frontier[pos];
     auto degree = degrees[pos];
     int j       = 0;
     for (; j < degree; j++) {
-      auto neighbor_id = rand() % degree; // randomly select a neighbor
+      auto neighbor_id = rs.below(degree); // randomly select a neighbor
       auto dst         = g->getEdgeDstHost(g->edge_begin_host(u) + neighbor_id);
       if (vertex_set.find(dst) == vertex_set.end()) {
         frontier[pos] = dst;
@@ -65,82 +66,38 @@ size_t Sampler::selectVertices(index_t nv, index_t n, Graph* g, VertexList verti
   return vertex_set.size();
 }
 
-// Given a subset of vertices and a graph g, generate a subgraph sg from the graph g
-void Sampler::reindexSubgraph(VertexSet& keptVertices, Graph& origGraph, Graph& reindexGraph) {
-  auto nv = keptVertices.size(); // new graph (subgraph) size
-  VertexList new_ids = reindexVertices(full_graph->size(), keptVertices);
-  std::vector<uint32_t> degrees(nv, 0); // degrees of vertices in the subgraph
-  for (auto v : keptVertices)
-    degrees[new_ids[v]] = getDegree(&origGraph, v);
-  // auto offsets = parallel_prefix_sum(degrees);
-  auto offsets = utils::prefix_sum(degrees);
-  auto ne      = offsets[nv];
-  //std::cout << "reindex subgraph |V| = " << nv << " |E| = " << ne << "\n";
-  reindexGraph.allocateFrom(nv, ne);
-  //reindexGraph.constructNodes();
-  VertexList old_ids(keptVertices.begin(), keptVertices.end()); // vertex ID mapping
-  //#pragma omp parallel for
-  for (size_t i = 0; i < nv; i++) {
-    reindexGraph.fixEndEdge(i, offsets[i + 1]);
-    unsigned j  = 0;
-    auto old_id = old_ids[i];
-    for (auto e = origGraph.edge_begin_host(old_id);
-        e != origGraph.edge_end_host(old_id); e++) {
-      auto dst = new_ids[origGraph.getEdgeDstHost(e)];
-      assert(dst < nv);
-      reindexGraph.constructEdge(offsets[i] + j, dst);
-      j++;
-    }
-  }
-}
-
-template <typename GraphTy>
-void Sampler::getMaskedDegrees(size_t n, mask_t* masks, GraphTy* g, std::vector<uint32_t>& degrees) {
-  assert(degrees.size() == n);
+// do the sampling of vertices from training set + using masked graph:
+// mask the vertex set, count the edges kept in each row, scan and scatter them,
+// the vertices numbered in id order (the order of the set)
+void Sampler::generateSubgraph(VertexSet& sampledSet, mask_t* masks, Graph* sg) {
+  createMasks(full_graph->size(), sampledSet, masks); // create the masks
+  VertexList old_ids(sampledSet.begin(), sampledSet.end()); // vertex ID mapping
+  index_t nv = old_ids.size();
+  // new ids by old id, allocated once per thread: only the entries of the sampled vertices,
+  // written below, are read, so the array is neither cleared nor reallocated per subgraph
+  static thread_local VertexList new_ids;
+  if (new_ids.size() < full_graph->size()) new_ids.resize(full_graph->size());
+  for (index_t i = 0; i < nv; i++) new_ids[old_ids[i]] = i;
+  std::vector<index_t> offsets(nv + 1, 0); // degrees of vertices in the subgraph, then offsets
   #pragma omp parallel for
-  for (size_t src = 0; src < n; src++) {
-    if (masks[src] == 1) {
-      for (auto e = g->edge_begin_host(src); e != g->edge_end_host(src); e++) {
-        const auto dst = g->getEdgeDstHost(e);
-        if (masks[dst] == 1) degrees[src]++;
-      }
-    }
+  for (index_t i = 0; i < nv; i++) {
+    auto v = old_ids[i];
+    for (auto e = full_graph->edge_begin_host(v); e != full_graph->edge_end_host(v); e++)
+      offsets[i] += masks[full_graph->getEdgeDstHost(e)];
   }
-}
-
-// trim edges from g to form sub
-template <typename GraphTy, typename SubgraphTy>
-void Sampler::getMaskedGraph(index_t n, mask_t* masks, GraphTy* g, SubgraphTy* sub) {
-  std::vector<uint32_t> degrees(n, 0);
-  getMaskedDegrees(n, masks, g, degrees);
-  // auto offsets = parallel_prefix_sum(degrees);
-  auto offsets = utils::prefix_sum(degrees);
-  size_t ne    = offsets[n];
-  //std::cout << "subgraph |V| = " << n << " |E| = " << ne << "\n";
-  sub->allocateFrom(n, ne);
-  //sub->constructNodes();
-  //#pragma omp parallel for
-  for (size_t src = 0; src < n; src++) {
-    sub->fixEndEdge(src, offsets[src + 1]);
-    if (masks[src] == 1) {
-      auto idx = offsets[src];
-      for (auto e = g->edge_begin_host(src); e != g->edge_end_host(src); e++) {
-        auto dst = g->getEdgeDstHost(e);
-        if (masks[dst] == 1)
-          sub->constructEdge(idx++, dst);
-      }
+  parallel_prefix_sum_inplace<index_t>(offsets.data(), nv);
+  sg->dealloc();
+  sg->allocateFrom(nv, offsets[nv]);
+  #pragma omp parallel for
+  for (index_t i = 0; i < nv; i++) {
+    sg->fixEndEdge(i, offsets[i + 1]);
+    auto idx = offsets[i];
+    auto v = old_ids[i];
+    for (auto e = full_graph->edge_begin_host(v); e != full_graph->edge_end_host(v); e++) {
+      auto dst = full_graph->getEdgeDstHost(e);
+      if (masks[dst] == 1) sg->constructEdge(idx++, new_ids[dst]);
     }
   }
-}
-
-// do the sampling of vertices from training set + using masked graph
-void Sampler::generateSubgraph(VertexSet& sampledSet, mask_t* masks, Graph* sg) {
-  createMasks(full_graph->size(), sampledSet, masks); // create the masks
-  //for (int i = 0; i < 100; i++) std::cout << "masks[" << i << "]=" << unsigned(masks[i]) << "\n";
-  Graph maskedSG; // sampled vertex set induced subgraph
-  // remove edges whose destination is not masked
-  getMaskedGraph(full_graph->size(), masks, full_graph, &maskedSG);
-  reindexSubgraph(sampledSet, maskedSG, *sg);
   //std::cout << "subg |E| " << sg->sizeEdges() << "\n";
 }
 
@@ -160,9 +117,9 @@ void checkGSDB(std::vector<db_t>& DB0, std::vector<db_t>& DB1,
 // implementation from GraphSAINT
 // https://github.com/GraphSAINT/GraphSAINT/blob/master/ipdps19_cpp/sample.cpp
 // n: subgraph_size; m: size_frontier
-size_t Sampler::select_vertices(index_t n, VertexSet& st, unsigned seed) {
+size_t Sampler::select_vertices(index_t n, VertexSet& st, uint64_t seed) {
   if (n < m) m = n;
-  unsigned myseed = seed;
+  PhiloxStream rs(rng, seed);
   // DBx: Dashboard line x, IAx: Index array line x
   std::vector<db_t> DB0, DB1, DB2, IA0, IA1, IA2, IA3, IA4, nDB0, nDB1, nDB2;
   DB0.reserve(subg_deg * m * ETA);
@@ -179,7 +136,7 @@ size_t Sampler::select_vertices(index_t n, VertexSet& st, unsigned seed) {
   IA3.resize(m);
 
   for (index_t i = 0; i < m; i++) {
-    auto rand_idx = rand_r(&myseed) % trainingNodes.size();
+    auto rand_idx = rs.below(trainingNodes.size());
     db_t v = IA3[i] = trainingNodes[rand_idx];
     st.insert(v);
     IA0[i] = getDegree(masked_graph, v);
@@ -208,7 +165,7 @@ size_t Sampler::select_vertices(index_t n, VertexSet& st, unsigned seed) {
   for (index_t itr = 0; itr < n - m; itr++) {
     choose = db_t(-1);
     while (choose == db_t(-1)) {
-      tmp = rand_r(&myseed) % DB0.size();
+      tmp = rs.below(DB0.size());
       if (size_t(tmp) < DB0.size())
         if (DB0[tmp] != db_t(-1))
           choose = tmp;
@@ -216,7 +173,7 @@ size_t Sampler::select_vertices(index_t n, VertexSet& st, unsigned seed) {
     choose      = (DB1[choose] < 0) ? choose : (choose - DB1[choose]);
     db_t v      = DB0[choose];
     auto degree = getDegree(masked_graph, v);
-    neigh_v     = (degree != 0) ? rand_r(&myseed) % degree : db_t(-1);
+    neigh_v     = (degree != 0) ? db_t(rs.below(degree)) : db_t(-1);
     if (neigh_v != db_t(-1)) {
       neigh_v = masked_graph->getEdgeDstHost(masked_graph->edge_begin_host(v) + neigh_v);
       st.insert(neigh_v);
@@ -3,10 +3,11 @@
 std::map<char,double> time_ops;
 
 int main(int argc, char* argv[]) {
-  if (argc <= 4 || (argc>9 && argc!=13)) {
+  if (argc <= 4 || (argc>9 && argc<13) || argc>16) {
     std::cout << "Usage: ./train data num_epochs num_threads type_loss "
               << "hidden(16) score_drop_rate(0.) feat_drop_rate(0.) "
-              << "learnng_rate(0.01) num_layers(2) subg_size(0) val_interval(50) inductive(0)\n"
+              << "learnng_rate(0.01) num_layers(2) subg_size(0) val_interval(50) inductive(0) "
+              << "[batch_size(0) fanouts(10,25)] [model_file]\n"
               << "Example: ./bin/cpu_train_gcn citeseer 10 2 softmax\n";
     exit(1);
   }
@@ -61,5 +62,6 @@ int main(int argc, char* argv[]) {
   auto test_acc = model.evaluate("test");
   double tt2 = omp_get_wtime();
   std::cout << "Test accuracy: " << test_acc << "  test time: " << tt2-tt1 << " seconds\n";
+  if (model.get_model_file() != "") model.save_model();
 }
 
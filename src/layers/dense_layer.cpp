@@ -91,3 +91,8 @@ void dense_layer::update_dim_size(int x) {
   }
   num_samples = x;
 }
+
+void dense_layer::save_weights(std::ostream &out) {
+  write_tensor(out, weight);
+  write_tensor(out, bias);
+}
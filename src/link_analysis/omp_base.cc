@@ -1,6 +1,6 @@
 // Copyright 2020 MIT
 // Authors: Xuhao Chen <cxh@mit.edu>
-#include "graph.h"
+#include "graph_kernels.h"
 
 void PRSolver(Graph &g, score_t *scores) {
   if (!g.has_reverse_graph()) {
@@ -21,19 +21,7 @@ void PRSolver(Graph &g, score_t *scores) {
   Timer t;
   t.Start();
   for (; iter < MAX_ITER; iter ++) {
-    double error = 0;
-    #pragma omp parallel for
-    for (vidType n = 0; n < nv; n ++)
-      outgoing_contrib[n] = scores[n] / g.get_degree(n);
-    #pragma omp parallel for reduction(+ : error) schedule(dynamic, 64)
-    for (vidType dst = 0; dst < nv; dst ++) {
-      score_t incoming_total = 0;
-      for (auto src : g.in_neigh(dst))
-        incoming_total += outgoing_contrib[src];
-      score_t old_score = scores[dst];
-      scores[dst] = base_score + kDamp * incoming_total;
-      error += fabs(scores[dst] - old_score);
-    }   
+    double error = pr_step(g, scores, outgoing_contrib, base_score);
     printf(" %2d    %lf\n", iter+1, error);
     if (error < EPSILON) break;
   }
@@ -15,23 +15,92 @@ void PartitionedGraph::print_subgraphs() {
   }
 }
 
+void PartitionedGraph::write_subgraph(std::string outfile, int i) {
+  std::cout << "Writing subgraph[" << i << "]\n";
+  auto prefix = outfile+"-part"+std::to_string(i);
+  subgraphs[i]->write_to_file(prefix);
+  subgraphs[i]->write_meta_info(prefix);
+  if (idx_map.size() > size_t(i) && !idx_map[i].empty()) {
+    std::ofstream f_map((prefix+".idxmap.bin").c_str(), std::ios::binary);
+    if (!f_map) {
+      std::cout << "File not available\n";
+      throw 1;
+    }
+    f_map.write(reinterpret_cast<const char*>(idx_map[i].data()), idx_map[i].size()*sizeof(vidType));
+    f_map.close();
+  }
+}
+
+void PartitionedGraph::write_partition_ids(std::string outfile, const std::vector<int> &ids) {
+  std::ofstream f_ids((outfile+"-vparts.bin").c_str(), std::ios::binary);
+  if (!f_ids) {
+    std::cout << "File not available\n";
+    throw 1;
+  }
+  f_ids.write(reinterpret_cast<const char*>(ids.data()), ids.size()*sizeof(int));
+  f_ids.close();
+}
+
 void PartitionedGraph::write_to_file(std::string outfile) {
-  for (int i = 0; i < num_subgraphs; ++i) {
-    std::cout << "Writing subgraph[" << i << "]\n";
-    subgraphs[i]->write_to_file(outfile+"-part"+std::to_string(i));
+  for (int i = 0; i < num_subgraphs; ++i)
+    write_subgraph(outfile, i);
+  // vertex ranges owned by the subgraphs, one "begin end" line per subgraph
+  if (begin_vids.size() == size_t(num_subgraphs)) {
+    std::ofstream f_parts((outfile+"-parts.txt").c_str());
+    if (!f_parts) {
+      std::cout << "File not available\n";
+      throw 1;
+    }
+    f_parts << num_subgraphs << "\n";
+    for (int i = 0; i < num_subgraphs; ++i)
+      f_parts << begin_vids[i] << " " << end_vids[i] << "\n";
+    f_parts.close();
   }
 }
 
-void PartitionedGraph::read_from_file(std::string infile) {
-  for (int i = 0; i < num_subgraphs; ++i) {
-    std::cout << "Reading subgraph[" << i << "]\n";
-    subgraphs[i] = new Graph(infile+"-part"+std::to_string(i));
+// read the vertex ranges written by write_to_file()
+void PartitionedGraph::read_vertex_ranges(std::string infile) {
+  std::ifstream f_parts((infile+"-parts.txt").c_str());
+  if (!f_parts) {
+    std::cout << "Cannot open " << infile << "-parts.txt: not a partitioned graph\n";
+    exit(1);
   }
+  int n = 0;
+  f_parts >> n;
+  if (n != num_subgraphs) {
+    std::cout << infile << " is partitioned into " << n << " subgraphs, but "
+              << num_subgraphs << " are expected\n";
+    exit(1);
+  }
+  begin_vids.resize(n);
+  end_vids.resize(n);
+  for (int i = 0; i < n; ++i)
+    f_parts >> begin_vids[i] >> end_vids[i];
+  if (!f_parts) {
+    std::cout << "Cannot read the vertex ranges of " << infile << "-parts.txt\n";
+    exit(1);
+  }
+  f_parts.close();
 }
 
-void PartitionedGraph::read_from_file(std::string infile, int sg_id) {
+// a part keeps the global ids of the neighbors, so it is loaded with global_ids
+static Graph* read_part(std::string infile, int sg_id) {
   std::cout << "Reading subgraph[" << sg_id << "]\n";
-  subgraphs[sg_id] = new Graph(infile+"-part"+std::to_string(sg_id));
+  auto prefix = infile+"-part"+std::to_string(sg_id);
+  auto subg = new Graph(prefix, false, false, false, false, false, false, true); // meta only
+  subg->load_graph_data(prefix, false, false, false, false, true);
+  return subg;
+}
+
+void PartitionedGraph::read_from_file(std::string infile) {
+  read_vertex_ranges(infile);
+  for (int i = 0; i < num_subgraphs; ++i)
+    subgraphs[i] = read_part(infile, i);
+}
+
+void PartitionedGraph::read_from_file(std::string infile, int sg_id) {
+  read_vertex_ranges(infile);
+  subgraphs[sg_id] = read_part(infile, sg_id);
 }
 
 // naive 1D partitioning, i.e., edge-cut
@@ -66,6 +135,54 @@ void PartitionedGraph::edgecut_partition1D() {
   }
 }
 
+// edge-cut 1D partitioning balanced by triangle counting work;
+// the work of vertex u is estimated as in the Scheduler: sum of min(deg(u), deg(v)) over its edges (u,v)
+void PartitionedGraph::edgecut_balanced_partition1D() {
+  num_subgraphs = num_vertex_chunks;
+  std::cout << "Balanced 1D partitioning (edge-cut) into " << num_subgraphs << " subgraphs\n";
+  auto nv = g->V();
+  std::vector<uint64_t> work(nv, 0);
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (vidType u = 0; u < nv; u++) {
+    uint64_t w = 1;
+    auto du = g->get_degree(u);
+    for (auto v : g->N(u))
+      w += std::min(du, g->get_degree(v));
+    work[u] = w;
+  }
+  std::vector<uint64_t> work_offsets(nv+1);
+  parallel_prefix_sum<uint64_t,uint64_t>(work, work_offsets.data());
+  auto total_work = work_offsets[nv];
+
+  subgraphs.resize(num_subgraphs);
+  begin_vids.resize(num_subgraphs);
+  end_vids.resize(num_subgraphs);
+  for (int sg_id = 0; sg_id < num_subgraphs; sg_id++) {
+    // split at equal quantiles of the accumulated work
+    auto target = total_work / num_subgraphs * (sg_id+1);
+    begin_vids[sg_id] = sg_id == 0 ? 0 : end_vids[sg_id-1];
+    end_vids[sg_id] = sg_id == num_subgraphs-1 ? nv : 
+      vidType(std::lower_bound(work_offsets.begin(), work_offsets.end(), target) - work_offsets.begin());
+    if (end_vids[sg_id] < begin_vids[sg_id]) end_vids[sg_id] = begin_vids[sg_id];
+    auto begin_vid = begin_vids[sg_id];
+    auto end_vid = end_vids[sg_id];
+    auto nv_subg = end_vid - begin_vid;
+    auto e_begin = g->edge_begin(begin_vid);
+    auto e_end = g->edge_begin(end_vid);
+    std::cout << "Generating subgraph[" << sg_id << "]: vertices [" << begin_vid << ", " << end_vid
+              << "), estimated work " << work_offsets[end_vid] - work_offsets[begin_vid] << "\n";
+    subgraphs[sg_id] = new Graph();
+    subgraphs[sg_id]->allocateFrom(nv_subg, e_end - e_begin);
+    auto rowptr = subgraphs[sg_id]->rowptr();
+    #pragma omp parallel for
+    for (vidType v = 0; v <= nv_subg; v++)
+      rowptr[v] = g->edge_begin(begin_vid+v) - e_begin;
+    std::copy(g->colidx()+e_begin, g->colidx()+e_end, subgraphs[sg_id]->colidx());
+    subgraphs[sg_id]->compute_max_degree();
+    subgraphs[sg_id]->print_meta_data();
+  }
+}
+
 // Given a subset of vertices and a graph g, generate a subgraph sg from the graph g
 void PartitionedGraph::generate_induced_subgraph(std::vector<int8_t> v_masks, Graph *g, Graph *subg, int subg_id) {
   //std::cout << "generating induced subgraph\n";
@@ -75,8 +192,6 @@ void PartitionedGraph::generate_induced_subgraph(std::vector<int8_t> v_masks, Gr
   for (size_t i = 0; i < nv; ++i) {
     auto v = idx_map[subg_id][i];
     new_ids[v] = i; // reindex
-    if (v == begin_vids[subg_id]) local_begin[subg_id] = i;
-    if (v == end_vids[subg_id]-1) local_end[subg_id] = i+1;
   }
   //std::cout << "Computing degrees\n";
   std::vector<vidType> degrees(nv, 0); // degrees of vertices in the subgraph
@@ -167,6 +282,8 @@ void PartitionedGraph::edgecut_induced_partition1D() {
         idx_map[i][offsets[v]] = v;
       }
     }
+    local_begin[i] = offsets[begin_vids[i]];
+    local_end[i] = offsets[end_vids[i]];
     subgraphs[i] = new Graph();
     //g->print_graph();
     generate_induced_subgraph(vertex_masks, g, subgraphs[i], i);
@@ -177,6 +294,43 @@ void PartitionedGraph::edgecut_induced_partition1D() {
   }
 }
 
+// edge-cut 1D partitioning by cluster ids, e.g., computed by multilevel_partition()
+void PartitionedGraph::edgecut_induced_partition1D(std::vector<int> cluster_ids) {
+  auto nv = g->V();
+  assert(cluster_ids.size() == size_t(nv));
+  num_subgraphs = num_vertex_chunks;
+  std::cout << "Induced 1D partitioning (edge-cut) into " << num_subgraphs << " subgraphs by cluster ids\n";
+  subgraphs.resize(num_subgraphs);
+  idx_map.resize(num_subgraphs);
+  begin_vids.clear(); // the master vertices are not ranges of ids
+  end_vids.clear();
+  local_begin.resize(num_subgraphs);
+  local_end.resize(num_subgraphs);
+  std::vector<int8_t> vertex_masks(nv, 0);
+  for (int i = 0; i < num_subgraphs; ++i) {
+    std::fill(vertex_masks.begin(), vertex_masks.end(), 0);
+    #pragma omp parallel for
+    for (vidType v = 0; v < nv; ++ v) {
+      if (cluster_ids[v] != i) continue;
+      vertex_masks[v] = 1;
+      for (auto u : g->N(v)) vertex_masks[u] = 1;
+    }
+    // masters first, then the other (halo) vertices
+    idx_map[i].clear();
+    for (vidType v = 0; v < nv; v++)
+      if (cluster_ids[v] == i) idx_map[i].push_back(v);
+    local_begin[i] = 0;
+    local_end[i] = idx_map[i].size();
+    for (vidType v = 0; v < nv; v++)
+      if (vertex_masks[v] && cluster_ids[v] != i) idx_map[i].push_back(v);
+    std::cout << "generating subgraph[" << i << "]: " << local_end[i] << " masters, "
+              << idx_map[i].size() - local_end[i] << " halo vertices\n";
+    subgraphs[i] = new Graph();
+    generate_induced_subgraph(vertex_masks, g, subgraphs[i], i);
+    subgraphs[i]->sort_neighbors(); // local ids are not in the order of the global ids
+  }
+}
+
 // CSR segmenting
 // Yunming Zhang et. al., Making caches work for graph analytics,
 // 2017 IEEE International Conference on Big Data (Big Data),
@@ -243,8 +397,8 @@ void PartitionedGraph::csr_segmenting() {
   }
 }
 
-PartitionedGraph::PartitionedGraph(Graph *g, int nc, std::vector<int> cluster_ids) :
-    num_vertex_chunks(nc), num_2D_partitions(nc*nc) {
+PartitionedGraph::PartitionedGraph(Graph *graph, int nc, std::vector<int> cluster_ids) :
+    g(graph), og(NULL), num_vertex_chunks(nc), num_2D_partitions(nc*nc) {
   auto nv = g->V();
   assert(cluster_ids.size() == size_t(nv)); // each vertex in g has a cluster id
   partitioned_file_path = "";
@@ -273,201 +427,149 @@ PartitionedGraph::PartitionedGraph(Graph *g, int nc, std::vector<int> cluster_id
 
 // naive 2D partitioning
 // partition the graph g according to the cluster id of each vertex
-void PartitionedGraph::partition2D(std::vector<int> cluster_ids) {
-  // degrees of vertices in each partition; degrees[i][j] is the degree of the j-th vertex in the i-th partiton
-  std::vector<std::vector<int>> degrees(num_2D_partitions); 
-  std::vector<std::vector<int>> rowptr_partitioned(num_2D_partitions); // row pointers of each partition
-  std::vector<std::vector<int>> colidx_partitioned(num_2D_partitions); // column indices of each partition 
+void PartitionedGraph::partition2D(std::string outfile, std::vector<int> cluster_ids) {
+  auto nv = g->V();
+  int nc = num_vertex_chunks;
+  int np = num_2D_partitions;
+  Timer t;
+  t.Start();
+  // partition (i,j) holds the edges from cluster i to cluster j in CSR format, with one row per
+  // vertex of cluster i; the row pointers of all partitions are stored back to back, and so are
+  // the column indices (global vertex ids)
+  std::vector<eidType> voffsets(np+1, 0);
+  for (int pid = 0; pid < np; pid++)
+    voffsets[pid+1] = voffsets[pid] + verts_of_clusters[pid / nc].size() + 1;
 
-  // allocate memory for CSR format
-  for (int i = 0; i < num_vertex_chunks; i++) {
-    auto num = verts_of_clusters[i].size();
-    for (int j = 0; j < num_vertex_chunks; j++) {
-      auto pid = i * num_vertex_chunks + j; // partition id
-      rowptr_partitioned[pid].resize(num+1);
-      degrees[pid].resize(num);
-      std::fill(rowptr_partitioned[pid].begin(), rowptr_partitioned[pid].end(), 0);
-      std::fill(degrees[pid].begin(), degrees[pid].end(), 0);
-    }
-  }
+  partitioned_file_path = outfile + "-pgraph";
+  std::cout << "writing to: " << partitioned_file_path << ".*\n";
+  eidType *rowptr;
+  create_mapped_file(partitioned_file_path+".vertex.bin", rowptr, voffsets[np]);
 
-  std::vector<int> nes_of_partitions(num_2D_partitions, 0); // number of edges |E| of each partition
-  auto nv = g->V();
-  // count the degrees and the number of edges in each partition
-  for (vidType v = 0; v < nv; v++) { // for each vertex v in g
-    auto src_cid = cluster_ids[v]; // src cluster id
-    for (auto u : g->N(v)) { // for each neighbor u of vertex v
-      auto dst_cid = cluster_ids[u]; // dst cluster id
-      int pid = src_cid * num_vertex_chunks + dst_cid; // partition id
-      nes_of_partitions[pid] ++; // increase the number of edges in this partition
+  // count the degree of each vertex in each partition: a vertex owns its rows, so the degrees
+  // are counted without synchronization, and the sizes of the partitions in per-thread histograms
+  std::vector<eidType> nes_of_partitions(np, 0);
+  #pragma omp parallel
+  {
+    std::vector<eidType> local_nes(np, 0);
+    #pragma omp for schedule(dynamic, 1024)
+    for (vidType v = 0; v < nv; v++) {
+      auto first_pid = cluster_ids[v] * nc;
       auto r = vertex_rank_in_cluster[v]; // v is the r-th vertex in its cluster
-      degrees[pid][r]++;
+      for (auto u : g->N(v)) {
+        auto pid = first_pid + cluster_ids[u];
+        rowptr[voffsets[pid]+r]++;
+        local_nes[pid]++;
+      }
     }
+    #pragma omp critical
+    for (int pid = 0; pid < np; pid++)
+      nes_of_partitions[pid] += local_nes[pid];
   }
+  for (int pid = 0; pid < np; pid++)
+    parallel_prefix_sum_inplace(rowptr + voffsets[pid], verts_of_clusters[pid / nc].size());
+  std::vector<eidType> eoffsets(np+1, 0);
+  for (int pid = 0; pid < np; pid++)
+    eoffsets[pid+1] = eoffsets[pid] + nes_of_partitions[pid];
 
-  // computer row pointers using the degrees
-  for (int i = 0; i < num_2D_partitions; i++) {
-    colidx_partitioned[i].resize(nes_of_partitions[i]); // allocate memory for the edges in each partition
-    for (size_t w = 0; w < degrees[i].size(); w++)
-      rowptr_partitioned[i][w+1] = rowptr_partitioned[i][w] + degrees[i][w];
-  }
-
-  // insert edges to each partition
-  std::vector<int> index(num_2D_partitions, 0);
-  for (vidType v = 0; v < nv; v++) {
-    auto src_cid = cluster_ids[v]; // src cluster id
-    for (auto u : g->N(v)) {
-      auto dst_cid = cluster_ids[u]; // dst cluster id
-      int pid = src_cid * num_vertex_chunks + dst_cid; // partition id
-      colidx_partitioned[pid][index[pid]++] = u;
+  // insert the edges: each row is written at its final position in the file
+  vidType *colidx;
+  create_mapped_file(partitioned_file_path+".edge.bin", colidx, eoffsets[np]);
+  #pragma omp parallel
+  {
+    std::vector<eidType> pos(nc);
+    #pragma omp for schedule(dynamic, 1024)
+    for (vidType v = 0; v < nv; v++) {
+      auto first_pid = cluster_ids[v] * nc;
+      auto r = vertex_rank_in_cluster[v];
+      for (int j = 0; j < nc; j++)
+        pos[j] = eoffsets[first_pid+j] + rowptr[voffsets[first_pid+j]+r];
+      for (auto u : g->N(v))
+        colidx[pos[cluster_ids[u]]++] = u;
     }
   }
+  unmap_file(rowptr, voffsets[np]);
+  unmap_file(colidx, eoffsets[np]);
 
-  // compute the offsets for each partition
-  std::vector<vidType> vlengths(num_2D_partitions, 0);
-  std::vector<vidType> elengths(num_2D_partitions, 0);
-  std::vector<vidType> voffsets(num_2D_partitions+1, 0);
-  std::vector<vidType> eoffsets(num_2D_partitions+1, 0);
-  for (int i = 0; i < num_2D_partitions; i ++) {
-    vlengths[i] = rowptr_partitioned[i].size();
-    elengths[i] = colidx_partitioned[i].size();
-    //std::cout << "partition " << i << " has " << vlengths[i]-1 << " source vertices and " << elengths[i] << " edges\n";
-  }
-  parallel_prefix_sum<vidType,vidType>(vlengths, voffsets.data());
-  parallel_prefix_sum<vidType,vidType>(elengths, eoffsets.data());
-
-  // write rowptr_partitioned and colidx_partitioned into file, together with their offsets
-  partitioned_file_path = g->get_inputfile_path() + '/';
-  std::cout << "writing to path: " << partitioned_file_path << "\n";
-  ofstream p_meta(partitioned_file_path+"pgraph.meta.txt");
+  ofstream p_meta(partitioned_file_path+".meta.txt");
   assert(p_meta);
-  p_meta << voffsets[num_2D_partitions] << "\n" << eoffsets[num_2D_partitions] << "\n";
+  p_meta << voffsets[np] << "\n" << eoffsets[np] << "\n";
   p_meta.close();
-  ofstream p_voffsets(partitioned_file_path+"pgraph.voffsets.bin", ios::out | ios::binary);
-  ofstream p_eoffsets(partitioned_file_path+"pgraph.eoffsets.bin", ios::out | ios::binary);
-  ofstream p_vertices(partitioned_file_path+"pgraph.vertex.bin", ios::out | ios::binary);
-  ofstream p_edges(partitioned_file_path+"pgraph.edge.bin", ios::out | ios::binary);
-  for (int i = 0; i < num_2D_partitions; i++) {
-    size_t num = rowptr_partitioned[i].size();
-    p_vertices.write((char *) &rowptr_partitioned[i][0], sizeof(int)*num);
-    num = colidx_partitioned[i].size();
-    p_edges.write((char *) &colidx_partitioned[i][0], sizeof(int)*num);
-  }
-  p_voffsets.write((char *) &voffsets[0], sizeof(int)*(num_2D_partitions+1));
-  p_eoffsets.write((char *) &eoffsets[0], sizeof(int)*(num_2D_partitions+1));
+  ofstream p_voffsets(partitioned_file_path+".voffsets.bin", ios::out | ios::binary);
+  ofstream p_eoffsets(partitioned_file_path+".eoffsets.bin", ios::out | ios::binary);
+  p_voffsets.write((char *) &voffsets[0], sizeof(eidType)*(np+1));
+  p_eoffsets.write((char *) &eoffsets[0], sizeof(eidType)*(np+1));
+  t.Stop();
+  std::cout << "2D partitioning into " << np << " partitions: " << eoffsets[np] << " edges, "
+            << "runtime [partition2D] = " << t.Seconds() << " sec\n";
 }
 
 // given the ids of clusters, fetch the edges between vertices in these clusters, and form a subgraph in CSR format
-void PartitionedGraph::fetch_partitions(std::string path, std::vector<int> clusters, Graph *& subg) {
-  int rowptr_size, colidx_size; // partitioned CSR size
-  ifstream p_meta(path+"/pgraph.meta.txt");
+// the partitions are read in place from the mapped files: the local id of a vertex is the
+// position of its cluster in 'clusters' plus its rank in the cluster
+void PartitionedGraph::fetch_partitions(std::string infile, std::vector<int> clusters, Graph *& subg) {
+  size_t rowptr_size, colidx_size; // partitioned CSR size
+  auto prefix = infile + "-pgraph";
+  ifstream p_meta(prefix+".meta.txt");
   if (p_meta.fail())
-    std::cerr << "Cannot find partitioned graph in " << path << ". Has this graph been partitioned yet?\n";
+    std::cerr << "Cannot find partitioned graph " << prefix << ".*. Has this graph been partitioned yet?\n";
   assert(p_meta);
   p_meta >> rowptr_size >> colidx_size;
-  ifstream p_vertices(path+"/pgraph.vertex.bin", ios::out | ios::binary);
-  assert(p_vertices);
-  ifstream p_edges(path+"/pgraph.edge.bin", ios::out | ios::binary);
-  assert(p_edges);
+  eidType *rowptr, *voffsets, *eoffsets;
+  vidType *colidx;
+  map_file(prefix+".vertex.bin", rowptr, rowptr_size);
+  map_file(prefix+".edge.bin", colidx, colidx_size);
+  map_file(prefix+".voffsets.bin", voffsets, num_2D_partitions+1);
+  map_file(prefix+".eoffsets.bin", eoffsets, num_2D_partitions+1);
 
-  int *rowptr, *colidx, *voffsets, *eoffsets;
-  map_file(path+"/pgraph.vertex.bin", rowptr, rowptr_size);
-  map_file(path+"/pgraph.edge.bin", colidx, colidx_size);
-  map_file(path+"/pgraph.voffsets.bin", voffsets, num_2D_partitions+1);
-  map_file(path+"/pgraph.eoffsets.bin", eoffsets, num_2D_partitions+1);
-  /*
-     for (int i = 0; i < num_2D_partitions+1; i ++) {
-     std::cout << "voffsets " << i << " is " << voffsets[i] << " eoffsets " << i << " is " << eoffsets[i] << "\n";
-     }
-     for (int i = 0; i < rowptr_size; i ++) {
-     std::cout << "rowptr[" << i << "] = " << rowptr[i] << " ";
-     }
-     std::cout << "\n";
-     for (int i = 0; i < colidx_size; i ++) {
-     std::cout << "colidx[" << i << "] = " << colidx[i] << " ";
-     }
-     std::cout << "\n";
-     */
-  // count the number of vertices |V| in the subgraph
-  vidType nv_subg = 0;
-  eidType ne_subg = 0;
-  for (auto cid : clusters) nv_subg += verts_of_clusters[cid].size();
+  // local id of the first vertex of each of the given clusters
+  int nc = clusters.size();
+  std::vector<vidType> first_local_id(nc+1, 0);
+  for (int i = 0; i < nc; i++)
+    first_local_id[i+1] = first_local_id[i] + verts_of_clusters[clusters[i]].size();
+  auto nv_subg = first_local_id[nc];
   std::cout << "number of vertices in the subgraph: " << nv_subg << "\n";
 
-  vidType nc = clusters.size();
-  vidType np = nc * nc;
-  std::vector<std::vector<eidType>> rowptr_partitioned(np); // row pointers of each partition
-  VertexLists colidx_partitioned(np); // column indices of each partition 
+  // degree of each vertex: the sum of its row lengths in the partitions (i,j), j in clusters
   std::vector<vidType> degrees_subg(nv_subg);
-  vidType local_pid = 0;
-  int64_t vid_offset = 0;
-  // compute |E| and the degrees for each vertex in the subgraph
-  for (auto src_cid : clusters) {
-    auto num_v = verts_of_clusters[src_cid].size();
-    for (auto dst_cid : clusters) {
-      vidType pid = src_cid * num_vertex_chunks + dst_cid; // partition id
-      auto start = voffsets[pid];
-      auto end = voffsets[pid+1];
-      rowptr_partitioned[local_pid].insert(rowptr_partitioned[local_pid].end(), rowptr+start, rowptr+end);
-      ne_subg += rowptr[end-1]; // the number of edges in this partition
-      for (size_t i = 0; i < num_v; i++)
-        degrees_subg[vid_offset+i] += rowptr_partitioned[local_pid][i+1] - rowptr_partitioned[local_pid][i];
-
-      start = eoffsets[pid];
-      end = eoffsets[pid+1];
-      colidx_partitioned[local_pid].insert(colidx_partitioned[local_pid].end(), colidx+start, colidx+end);
-      local_pid ++;
+  for (int i = 0; i < nc; i++) {
+    auto num_v = verts_of_clusters[clusters[i]].size();
+    #pragma omp parallel for
+    for (size_t r = 0; r < num_v; r++) {
+      vidType deg = 0;
+      for (auto dst_cid : clusters) {
+        auto row = rowptr + voffsets[clusters[i] * num_vertex_chunks + dst_cid];
+        deg += row[r+1] - row[r];
+      }
+      degrees_subg[first_local_id[i]+r] = deg;
     }
-    vid_offset += num_v;
-  }
-  std::cout << "number of edges in the subgraph: " << ne_subg << "\n";
-
-  // gather global vertex ids in the given clusters
-  VertexList vertices_subg;
-  for (auto cid : clusters)
-    vertices_subg.insert(vertices_subg.end(), verts_of_clusters[cid].begin(), verts_of_clusters[cid].end());
-  assert(vertices_subg.size() == size_t(nv_subg));
-  std::map<vidType, vidType> global_to_local_idmap;
-  vidType local_id = 0;
-  for (auto v : vertices_subg) {
-    global_to_local_idmap.insert(std::make_pair(v, local_id++));
   }
-  assert(local_id == nv_subg);
-  //std::cout << "global to local vertex id map constructed\n";
-
-  subg = new Graph(nv_subg, ne_subg); // allocate memory for the subgraph
   eidType *offsets = custom_alloc_global<eidType>(nv_subg+1);
   parallel_prefix_sum<vidType,eidType>(degrees_subg, offsets);
+  auto ne_subg = offsets[nv_subg];
+  std::cout << "number of edges in the subgraph: " << ne_subg << "\n";
 
-  // insert the edges into the subgraph
-  vidType pid = 0;
-  vidType src = 0; // src is local id of the source vertex
-  for (auto src_cid : clusters) {
-    for (auto v : verts_of_clusters[src_cid]) { // v is the global vertex id
-      subg->fixEndEdge(src, offsets[src+1]); // fix row pointers
-      auto idx = offsets[src];
-      auto rank = vertex_rank_in_cluster[v];
-      // for each dst cluster, copy the corresponding edges
-      for (size_t pid_index = 0; pid_index < clusters.size(); pid_index++) {
-        auto start = rowptr_partitioned[pid+pid_index][rank]; // the location of the first edge
-        auto end = rowptr_partitioned[pid+pid_index][rank+1]; // number of edges to copy
-        for (int i = start; i < end; i++) {
-          auto global_dst = colidx_partitioned[pid+pid_index][i]; // This 'dst' is a global vertex ID. 
-          auto dst = global_to_local_idmap[global_dst]; // translate into its local vertex ID
-          if (dst >= nv_subg) std::cout << "global_dst = " << global_dst << ", dst = " << dst << ", nv_subg = " << nv_subg << "\n";
-          assert(dst < nv_subg);
-          subg->constructEdge(idx++, dst); // fix column indices
-        }
+  // copy the edges, translating global ids into local ids
+  subg = new Graph(nv_subg, ne_subg); // allocate memory for the subgraph
+  std::copy(offsets, offsets+nv_subg+1, subg->rowptr());
+  for (int i = 0; i < nc; i++) {
+    auto num_v = verts_of_clusters[clusters[i]].size();
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (size_t r = 0; r < num_v; r++) {
+      auto idx = offsets[first_local_id[i]+r];
+      for (int j = 0; j < nc; j++) {
+        auto pid = clusters[i] * num_vertex_chunks + clusters[j];
+        auto row = rowptr + voffsets[pid];
+        auto edges = colidx + eoffsets[pid];
+        for (auto e = row[r]; e < row[r+1]; e++)
+          subg->constructEdge(idx++, first_local_id[j] + vertex_rank_in_cluster[edges[e]]);
       }
-      src++;
     }
-    pid += clusters.size();
   }
+  custom_free(offsets, nv_subg+1);
+  unmap_file(rowptr, rowptr_size);
+  unmap_file(colidx, colidx_size);
+  unmap_file(voffsets, num_2D_partitions+1);
+  unmap_file(eoffsets, num_2D_partitions+1);
+  subg->compute_max_degree();
   std::cout << "Subgraph constructed\n";
-  subg->print_graph();
-  std::cout << "global to local vertex id mapping: ";
-  for (auto pair : global_to_local_idmap)
-    std::cout << "<" << pair.first << ", " << pair.second << "> ";
-  std::cout << "\n";
 }
-
@@ -0,0 +1,353 @@
+// Multilevel k-way graph partitioning, in the spirit of METIS:
+// George Karypis and Vipin Kumar, A Fast and High Quality Multilevel Scheme
+// for Partitioning Irregular Graphs, SIAM J. Sci. Comput., 1998
+#include "graph_partition.h"
+#include "scan.h"
+#include "platform_atomics.h"
+#include <queue>
+
+// weighted graph of one level of the hierarchy
+struct WeightedGraph {
+  vidType nv;
+  std::vector<eidType> rowptr;
+  std::vector<vidType> colidx;
+  std::vector<int> adjwgt;   // edge weights
+  std::vector<int> vwgt;     // vertex weights
+  std::vector<vidType> cmap; // id of each vertex in the next coarser graph
+};
+
+// splitmix64 finalizer, used for reproducible tie-breaking
+static inline uint64_t mix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// Heavy-edge matching: in each round every unmatched vertex proposes to its unmatched
+// neighbor with the heaviest edge (ties broken by a hash), and mutual proposals are matched.
+// Returns the partner of each vertex (itself if unmatched).
+static std::vector<vidType> heavy_edge_matching(const WeightedGraph &g, int max_vwgt, uint64_t seed) {
+  const int num_rounds = 16;
+  std::vector<vidType> match(g.nv, vidType(-1));
+  std::vector<vidType> proposal(g.nv);
+  for (int r = 0; r < num_rounds; r++) {
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (vidType v = 0; v < g.nv; v++) {
+      proposal[v] = vidType(-1);
+      if (match[v] != vidType(-1)) continue;
+      int best_wgt = 0;
+      uint64_t best_key = 0;
+      for (auto e = g.rowptr[v]; e < g.rowptr[v+1]; e++) {
+        auto u = g.colidx[e];
+        if (u == v || match[u] != vidType(-1) || g.vwgt[v] + g.vwgt[u] > max_vwgt) continue;
+        auto key = mix64(seed ^ (uint64_t(std::min(u, v)) << 32 | std::max(u, v)) ^ r);
+        if (g.adjwgt[e] > best_wgt || (g.adjwgt[e] == best_wgt && key > best_key)) {
+          best_wgt = g.adjwgt[e];
+          best_key = key;
+          proposal[v] = u;
+        }
+      }
+    }
+    #pragma omp parallel for
+    for (vidType v = 0; v < g.nv; v++) {
+      auto u = proposal[v];
+      if (u != vidType(-1) && proposal[u] == v) match[v] = u;
+    }
+  }
+  #pragma omp parallel for
+  for (vidType v = 0; v < g.nv; v++)
+    if (match[v] == vidType(-1)) match[v] = v;
+  return match;
+}
+
+// collapse each matched pair into one vertex; parallel edges are merged by adding their weights
+static void contract(WeightedGraph &g, const std::vector<vidType> &match, WeightedGraph &cg) {
+  std::vector<vidType> is_leader(g.nv);
+  #pragma omp parallel for
+  for (vidType v = 0; v < g.nv; v++)
+    is_leader[v] = v <= match[v];
+  std::vector<eidType> offsets(g.nv+1);
+  parallel_prefix_sum<vidType,eidType>(is_leader, offsets.data());
+  cg.nv = offsets[g.nv];
+  g.cmap.resize(g.nv);
+  std::vector<vidType> leaders(cg.nv);
+  #pragma omp parallel for
+  for (vidType v = 0; v < g.nv; v++) {
+    if (is_leader[v]) {
+      g.cmap[v] = offsets[v];
+      leaders[offsets[v]] = v;
+    }
+  }
+  #pragma omp parallel for
+  for (vidType v = 0; v < g.nv; v++)
+    if (!is_leader[v]) g.cmap[v] = g.cmap[match[v]];
+
+  std::vector<std::vector<std::pair<vidType,int>>> adj(cg.nv);
+  cg.vwgt.resize(cg.nv);
+  std::vector<vidType> degrees(cg.nv);
+  #pragma omp parallel
+  {
+    std::vector<vidType> pos(cg.nv, vidType(-1)); // position of each coarse neighbor in the list
+    #pragma omp for schedule(dynamic, 256)
+    for (vidType c = 0; c < cg.nv; c++) {
+      auto v = leaders[c];
+      auto &list = adj[c];
+      for (auto w : {v, match[v]}) {
+        for (auto e = g.rowptr[w]; e < g.rowptr[w+1]; e++) {
+          auto cu = g.cmap[g.colidx[e]];
+          if (cu == c) continue;
+          if (pos[cu] == vidType(-1)) {
+            pos[cu] = list.size();
+            list.push_back(std::make_pair(cu, g.adjwgt[e]));
+          } else {
+            list[pos[cu]].second += g.adjwgt[e];
+          }
+        }
+        if (match[v] == v) break;
+      }
+      for (auto &p : list) pos[p.first] = vidType(-1);
+      degrees[c] = list.size();
+      cg.vwgt[c] = g.vwgt[v] + (match[v] == v ? 0 : g.vwgt[match[v]]);
+    }
+  }
+  cg.rowptr.resize(cg.nv+1);
+  parallel_prefix_sum<vidType,eidType>(degrees, cg.rowptr.data());
+  cg.colidx.resize(cg.rowptr[cg.nv]);
+  cg.adjwgt.resize(cg.rowptr[cg.nv]);
+  #pragma omp parallel for schedule(dynamic, 256)
+  for (vidType c = 0; c < cg.nv; c++) {
+    auto e = cg.rowptr[c];
+    for (auto &p : adj[c]) {
+      cg.colidx[e] = p.first;
+      cg.adjwgt[e++] = p.second;
+    }
+    std::vector<std::pair<vidType,int>>().swap(adj[c]);
+  }
+}
+
+static int64_t compute_cut(const WeightedGraph &g, const std::vector<int> &part) {
+  int64_t cut = 0;
+  #pragma omp parallel for reduction(+ : cut)
+  for (vidType v = 0; v < g.nv; v++)
+    for (auto e = g.rowptr[v]; e < g.rowptr[v+1]; e++)
+      if (part[g.colidx[e]] != part[v]) cut += g.adjwgt[e];
+  return cut / 2;
+}
+
+// Greedy graph growing: grow the parts one after the other from a random seed vertex,
+// always adding the unassigned vertex most connected to the part; the last part takes
+// the rest. The best of several trials is kept.
+static std::vector<int> initial_partition(const WeightedGraph &g, int k, uint64_t seed) {
+  const int num_trials = 8;
+  int64_t total_wgt = 0;
+  for (auto w : g.vwgt) total_wgt += w;
+  std::vector<int> best, part(g.nv);
+  int64_t best_cut = -1;
+  for (int t = 0; t < num_trials; t++) {
+    std::fill(part.begin(), part.end(), -1);
+    int64_t remaining = total_wgt;
+    std::vector<int> gain(g.nv, 0);
+    uint64_t r = mix64(seed + t);
+    for (int p = 0; p < k-1; p++) {
+      int64_t target = remaining / (k - p), pwgt = 0;
+      std::priority_queue<std::pair<int,vidType>> pq;
+      while (pwgt < target) {
+        if (pq.empty()) { // start (or restart, for disconnected graphs) from a random unassigned vertex
+          vidType start = (r = mix64(r)) % g.nv;
+          while (part[start] != -1) start = (start + 1) % g.nv;
+          pq.push(std::make_pair(0, start));
+        }
+        auto top = pq.top();
+        pq.pop();
+        auto v = top.second;
+        if (part[v] != -1 || top.first != gain[v]) continue; // stale entry
+        part[v] = p;
+        pwgt += g.vwgt[v];
+        for (auto e = g.rowptr[v]; e < g.rowptr[v+1]; e++) {
+          auto u = g.colidx[e];
+          if (part[u] != -1) continue;
+          gain[u] += g.adjwgt[e];
+          pq.push(std::make_pair(gain[u], u));
+        }
+      }
+      remaining -= pwgt;
+      std::fill(gain.begin(), gain.end(), 0);
+    }
+    for (auto &p : part) if (p == -1) p = k-1;
+    auto cut = compute_cut(g, part);
+    if (best_cut < 0 || cut < best_cut) {
+      best_cut = cut;
+      best = part;
+    }
+  }
+  return best;
+}
+
+// Move vertices out of the parts heavier than max_pwgt, choosing the moves that lose the
+// fewest cut edges, into the most connected part that has room.
+static void balance(const WeightedGraph &g, std::vector<int> &part, int k, int64_t max_pwgt) {
+  std::vector<int64_t> pwgt(k, 0);
+  for (vidType v = 0; v < g.nv; v++) pwgt[part[v]] += g.vwgt[v];
+  if (*std::max_element(pwgt.begin(), pwgt.end()) <= max_pwgt) return;
+  std::vector<std::pair<int64_t,vidType>> candidates; // (loss, vertex)
+  std::vector<int64_t> conn(k);
+  for (vidType v = 0; v < g.nv; v++) {
+    if (pwgt[part[v]] <= max_pwgt) continue;
+    std::fill(conn.begin(), conn.end(), 0);
+    for (auto e = g.rowptr[v]; e < g.rowptr[v+1]; e++)
+      conn[part[g.colidx[e]]] += g.adjwgt[e];
+    int64_t best = 0;
+    for (int q = 0; q < k; q++) if (q != part[v]) best = std::max(best, conn[q]);
+    candidates.push_back(std::make_pair(conn[part[v]] - best, v));
+  }
+  std::sort(candidates.begin(), candidates.end());
+  for (auto &c : candidates) {
+    auto v = c.second;
+    auto p = part[v];
+    if (pwgt[p] <= max_pwgt) continue;
+    std::fill(conn.begin(), conn.end(), 0);
+    for (auto e = g.rowptr[v]; e < g.rowptr[v+1]; e++)
+      conn[part[g.colidx[e]]] += g.adjwgt[e];
+    int q_best = -1;
+    for (int q = 0; q < k; q++) {
+      if (q == p || pwgt[q] + g.vwgt[v] > max_pwgt) continue;
+      if (q_best < 0 || conn[q] > conn[q_best] || (conn[q] == conn[q_best] && pwgt[q] < pwgt[q_best])) q_best = q;
+    }
+    if (q_best < 0) continue;
+    part[v] = q_best;
+    pwgt[p] -= g.vwgt[v];
+    pwgt[q_best] += g.vwgt[v];
+  }
+}
+
+// Parallel label-propagation refinement: each vertex moves to the neighboring part that
+// reduces the cut the most, if that part stays within max_pwgt. Moves alternate between
+// towards higher and towards lower part ids to keep adjacent vertices from swapping back and forth.
+static void refine(const WeightedGraph &g, std::vector<int> &part, int k, int64_t max_pwgt) {
+  const int max_iter = 4;
+  std::vector<int64_t> pwgt(k, 0);
+  for (vidType v = 0; v < g.nv; v++) pwgt[part[v]] += g.vwgt[v];
+  vidType prev_moves = 0;
+  for (int iter = 0; iter < 2*max_iter; iter++) {
+    bool upward = iter % 2 == 0;
+    vidType num_moves = 0;
+    #pragma omp parallel reduction(+ : num_moves)
+    {
+      std::vector<int64_t> conn(k, 0);
+      std::vector<int> touched;
+      #pragma omp for schedule(dynamic, 1024)
+      for (vidType v = 0; v < g.nv; v++) {
+        auto p = part[v];
+        for (auto e = g.rowptr[v]; e < g.rowptr[v+1]; e++) {
+          auto q = part[g.colidx[e]];
+          if (conn[q] == 0) touched.push_back(q);
+          conn[q] += g.adjwgt[e];
+        }
+        int q_best = -1;
+        int64_t best_gain = 0;
+        for (auto q : touched) {
+          if (q == p || (upward ? q < p : q > p)) continue;
+          auto gain = conn[q] - conn[p];
+          if (gain > best_gain || (gain == best_gain && gain == 0 && q_best < 0 && pwgt[q] + g.vwgt[v] < pwgt[p])) {
+            best_gain = gain;
+            q_best = q;
+          }
+        }
+        for (auto q : touched) conn[q] = 0;
+        touched.clear();
+        if (q_best < 0) continue;
+        auto w = g.vwgt[v];
+        if (fetch_and_add(pwgt[q_best], int64_t(w)) + w <= max_pwgt) {
+          fetch_and_add(pwgt[p], -int64_t(w));
+          part[v] = q_best;
+          num_moves++;
+        } else {
+          fetch_and_add(pwgt[q_best], -int64_t(w));
+        }
+      }
+    }
+    if (!upward && prev_moves + num_moves <= g.nv / 1000) break; // converged
+    prev_moves = num_moves;
+  }
+}
+
+std::vector<int> PartitionedGraph::multilevel_partition(double imbalance, int seed) {
+  int k = num_vertex_chunks;
+  std::cout << "Multilevel " << k << "-way partitioning, imbalance tolerance " << imbalance << "\n";
+  Timer t;
+  t.Start();
+  auto nv = g->V();
+  std::vector<WeightedGraph> levels(1);
+  levels[0].nv = nv;
+  levels[0].rowptr.assign(g->rowptr(), g->rowptr() + nv + 1);
+  levels[0].colidx.assign(g->colidx(), g->colidx() + g->E());
+  levels[0].adjwgt.assign(g->E(), 1);
+  levels[0].vwgt.assign(nv, 1);
+  const vidType coarsest_size = std::max(vidType(64), vidType(20 * k));
+  const int max_vwgt = std::max(int64_t(1), int64_t(1.5 * nv / coarsest_size));
+
+  // coarsening
+  while (levels.back().nv > coarsest_size) {
+    auto match = heavy_edge_matching(levels.back(), max_vwgt, seed + levels.size());
+    WeightedGraph cg;
+    contract(levels.back(), match, cg);
+    if (cg.nv > 0.95 * levels.back().nv) break; // too few matches to be worth another level
+    levels.push_back(std::move(cg));
+  }
+  std::cout << "coarsening: " << levels.size() << " levels, |V| of the coarsest graph = " << levels.back().nv << "\n";
+
+  // initial partitioning of the coarsest graph
+  int64_t avg_pwgt = (nv + k - 1) / k;
+  auto part = initial_partition(levels.back(), k, seed);
+
+  // uncoarsening: coarse levels get a slack of the heaviest vertex weight
+  for (int l = levels.size() - 1; l >= 0; l--) {
+    auto &lg = levels[l];
+    if (l < int(levels.size()) - 1) {
+      std::vector<int> fine_part(lg.nv);
+      #pragma omp parallel for
+      for (vidType v = 0; v < lg.nv; v++)
+        fine_part[v] = part[lg.cmap[v]];
+      part.swap(fine_part);
+    }
+    int64_t max_pwgt = int64_t(imbalance * avg_pwgt);
+    if (l > 0) max_pwgt += *std::max_element(lg.vwgt.begin(), lg.vwgt.end());
+    balance(lg, part, k, max_pwgt);
+    refine(lg, part, k, max_pwgt);
+  }
+  t.Stop();
+  std::cout << "runtime [multilevel_partition] = " << t.Seconds() << " sec\n";
+  print_partition_quality(part);
+  return part;
+}
+
+template <typename GraphType>
+static void print_quality(const GraphType &g, int k, const std::vector<int> &cluster_ids) {
+  auto nv = g.V();
+  std::vector<vidType> sizes(k, 0);
+  for (vidType v = 0; v < nv; v++) sizes[cluster_ids[v]]++;
+  eidType cut = 0;
+  int64_t volume = 0; // number of (vertex, remote part) pairs, i.e., the data sent in a halo exchange
+  #pragma omp parallel reduction(+ : cut, volume)
+  {
+    std::vector<vidType> seen(k, vidType(-1));
+    #pragma omp for schedule(dynamic, 1024)
+    for (vidType v = 0; v < nv; v++) {
+      for (auto u : g.N(v)) {
+        auto q = cluster_ids[u];
+        if (q == cluster_ids[v]) continue;
+        cut++;
+        if (seen[q] != v) { seen[q] = v; volume++; }
+      }
+    }
+  }
+  auto max_size = *std::max_element(sizes.begin(), sizes.end());
+  std::cout << "edge cut = " << cut / 2 << " (" << 100.0 * cut / g.E() << "% of the edges), communication volume = "
+            << volume << ", balance (max/avg part size) = " << double(max_size) * k / nv << "\n";
+}
+
+void PartitionedGraph::print_partition_quality(const std::vector<int> &cluster_ids) {
+  if (g) print_quality(*g, num_vertex_chunks, cluster_ids);
+  else print_quality(*og, num_vertex_chunks, cluster_ids);
+}
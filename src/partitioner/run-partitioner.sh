@@ -1,2 +1,7 @@
 
-../../bin/test_partitioner ~/datasets/automine/livej/dag 2 ~/datasets/automine/livej/dag
+# balanced 1D partitioning of the DAG into 2 parts for tc_dist_cpu
+../../bin/test_partitioner ~/datasets/automine/livej/dag 2 ~/datasets/automine/livej/dag 1
+# multilevel partitioning into 4 parts; each subgraph is induced by one cluster and its neighbors
+../../bin/test_partitioner ~/datasets/automine/livej/graph 4 ~/datasets/automine/livej/graph 2
+# streaming HDRF vertex-cut partitioning into 8 parts, reading the graph through mmap
+../../bin/test_partitioner ~/datasets/automine/livej/graph 8 ~/datasets/automine/livej/graph 5
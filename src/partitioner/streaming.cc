@@ -0,0 +1,285 @@
+// One-pass streaming partitioners for graphs read through mmap (OutOfCoreGraph):
+// the vertices (edge-cut) or the edges (vertex-cut) are visited once in CSR order and
+// each of them is placed for good, so besides the mapped graph only O(|V|) state is kept.
+//
+// LDG: Isabelle Stanton and Gabriel Kliot, Streaming Graph Partitioning for Large
+// Distributed Graphs, KDD 2012
+// Fennel: Charalampos Tsourakakis et al., FENNEL: Streaming Graph Partitioning for
+// Massive Scale Graphs, WSDM 2014
+// HDRF: Fabio Petroni et al., HDRF: Stream-Based Partitioning for Power-Law Graphs, CIKM 2015
+// Greedy: Joseph Gonzalez et al., PowerGraph: Distributed Graph-Parallel Computation
+// on Natural Graphs, OSDI 2012
+#include "graph_partition.h"
+#include "scan.h"
+#include "platform_atomics.h"
+
+// number of vertices whose neighbors are counted in parallel before they are placed one by one
+static const vidType STREAM_WINDOW = 1 << 14;
+
+// offsets of the upper edges (u,v), v > u, of each vertex u: the edges of the stream of a
+// vertex-cut partitioner, each undirected edge once
+static std::vector<eidType> upper_edge_offsets(const OutOfCoreGraph &g) {
+  auto nv = g.V();
+  std::vector<vidType> num_upper(nv);
+  #pragma omp parallel for schedule(dynamic, 1024)
+  for (vidType v = 0; v < nv; v++) {
+    auto adj = g.N(v);
+    num_upper[v] = adj.end() - std::upper_bound(adj.begin(), adj.end(), v);
+  }
+  std::vector<eidType> offsets(nv+1);
+  parallel_prefix_sum<vidType,eidType>(num_upper, offsets.data());
+  return offsets;
+}
+
+// the least loaded part among the parts in 'mask'
+static int least_loaded(const std::vector<eidType> &load, uint64_t mask) {
+  int best = -1;
+  for (int p = 0; p < int(load.size()); p++)
+    if ((mask >> p & 1) && (best < 0 || load[p] < load[best])) best = p;
+  return best;
+}
+
+std::vector<int> PartitionedGraph::streaming_edgecut_partition(std::string method, double imbalance) {
+  assert(og && (method == "ldg" || method == "fennel"));
+  bool ldg = method == "ldg";
+  int k = num_vertex_chunks;
+  auto nv = og->V();
+  std::cout << "Streaming " << (ldg ? "LDG" : "Fennel") << " partitioning (edge-cut) into " << k << " parts\n";
+  double capacity = std::ceil(imbalance * nv / k); // at most 'capacity' vertices per part
+  // Fennel: the cost of a part of size s is alpha * s^gamma, with gamma = 3/2
+  double alpha = std::sqrt(double(k)) * (og->E() / 2.0) / std::pow(double(nv), 1.5);
+
+  std::vector<int> part(nv, -1);
+  std::vector<vidType> load(k, 0);
+  std::vector<vidType> counts(size_t(STREAM_WINDOW) * k);
+  std::vector<VertexList> window_neighbors(STREAM_WINDOW);
+  for (vidType begin = 0; begin < nv; begin += STREAM_WINDOW) {
+    auto end = std::min(nv, begin + STREAM_WINDOW);
+    // count the neighbors of each vertex of the window placed before the window ...
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (vidType v = begin; v < end; v++) {
+      auto c = &counts[size_t(v - begin) * k];
+      std::fill(c, c + k, 0);
+      auto &earlier = window_neighbors[v - begin];
+      earlier.clear();
+      for (auto u : og->N(v)) {
+        if (u < begin) c[part[u]]++;
+        else if (u < v) earlier.push_back(u);
+      }
+    }
+    // ... and place the vertices in stream order, as the sequential algorithm does
+    for (vidType v = begin; v < end; v++) {
+      auto c = &counts[size_t(v - begin) * k];
+      for (auto u : window_neighbors[v - begin]) c[part[u]]++;
+      int best = -1;
+      double best_score = 0;
+      for (int p = 0; p < k; p++) {
+        if (load[p] >= capacity) continue;
+        double score = ldg ? c[p] * (1.0 - load[p] / capacity)
+                           : c[p] - alpha * 1.5 * std::sqrt(double(load[p]));
+        if (best < 0 || score > best_score || (score == best_score && load[p] < load[best])) {
+          best = p;
+          best_score = score;
+        }
+      }
+      part[v] = best;
+      load[best]++;
+    }
+  }
+  print_partition_quality(part);
+  return part;
+}
+
+std::vector<uint8_t> PartitionedGraph::streaming_vertexcut_partition(std::string method, double lambda, double imbalance) {
+  assert(og && (method == "hdrf" || method == "greedy"));
+  bool hdrf = method == "hdrf";
+  int k = num_vertex_chunks;
+  assert(k <= 64); // replicas are tracked in a 64-bit mask per vertex
+  auto nv = og->V();
+  std::cout << "Streaming " << (hdrf ? "HDRF" : "greedy") << " partitioning (vertex-cut) into " << k << " parts\n";
+  auto offsets = upper_edge_offsets(*og);
+  std::vector<uint8_t> edge_parts(offsets[nv]);
+  // at most 'capacity' edges per part: in CSR order the edges of a connected region keep
+  // sharing replicas, and neither heuristic would leave the first part without a hard limit
+  eidType capacity = std::ceil(imbalance * offsets[nv] / k);
+  std::vector<uint64_t> replicas(nv, 0);  // bit p is set if the vertex has a replica in part p
+  std::vector<vidType> num_placed(nv, 0); // number of placed edges of each vertex
+  std::vector<eidType> load(k, 0);
+  uint64_t open_parts = k == 64 ? ~uint64_t(0) : (uint64_t(1) << k) - 1; // the parts below capacity
+  eidType max_load = 0;
+  for (vidType u = 0; u < nv; u++) {
+    auto adj = og->N(u);
+    auto e = offsets[u];
+    for (auto it = std::upper_bound(adj.begin(), adj.end(), u); it != adj.end(); ++it, ++e) {
+      auto v = *it;
+      auto ru = replicas[u], rv = replicas[v];
+      int best = -1;
+      if (hdrf) {
+        // replication score, favoring the replicas of the higher degree vertex less,
+        // plus the balance score weighted by lambda
+        double du = og->get_degree(u), dv = og->get_degree(v);
+        double theta_u = du / (du + dv), theta_v = 1.0 - theta_u;
+        eidType min_load = *std::min_element(load.begin(), load.end());
+        double best_score = 0;
+        for (int p = 0; p < k; p++) {
+          if (!(open_parts >> p & 1)) continue;
+          double score = lambda * (max_load - load[p]) / (1.0 + max_load - min_load);
+          if (ru >> p & 1) score += 2.0 - theta_u;
+          if (rv >> p & 1) score += 2.0 - theta_v;
+          if (best < 0 || score > best_score || (score == best_score && load[p] < load[best])) {
+            best = p;
+            best_score = score;
+          }
+        }
+      } else {
+        // PowerGraph greedy rules: a part holding both endpoints, else a part of the endpoint
+        // with more edges left to place, else a part of either endpoint, else any part
+        ru &= open_parts;
+        rv &= open_parts;
+        if (ru & rv) best = least_loaded(load, ru & rv);
+        else if (ru && rv) {
+          auto left_u = og->get_degree(u) - num_placed[u], left_v = og->get_degree(v) - num_placed[v];
+          best = least_loaded(load, left_u >= left_v ? ru : rv);
+        } else if (ru | rv) best = least_loaded(load, ru | rv);
+        else best = least_loaded(load, open_parts);
+      }
+      edge_parts[e] = best;
+      replicas[u] |= uint64_t(1) << best;
+      replicas[v] |= uint64_t(1) << best;
+      num_placed[u]++;
+      num_placed[v]++;
+      max_load = std::max(max_load, ++load[best]);
+      if (load[best] >= capacity) open_parts &= ~(uint64_t(1) << best);
+    }
+  }
+
+  uint64_t num_replicas = 0;
+  vidType num_covered = 0; // vertices with at least one edge
+  #pragma omp parallel for reduction(+ : num_replicas, num_covered)
+  for (vidType v = 0; v < nv; v++) {
+    num_replicas += __builtin_popcountll(replicas[v]);
+    if (replicas[v]) num_covered++;
+  }
+  std::cout << "replication factor = " << double(num_replicas) / std::max(vidType(1), num_covered)
+            << ", balance (max/avg part size in edges) = " << double(max_load) * k / std::max(eidType(1), offsets[nv]) << "\n";
+  return edge_parts;
+}
+
+// Each subgraph keeps the rows of the vertices of its part (local row pointers, global column
+// indices); the subgraphs are generated and written one at a time to bound the memory usage.
+void PartitionedGraph::write_edgecut_partitions(std::string outfile, const std::vector<int> &vertex_parts) {
+  assert(og);
+  auto nv = og->V();
+  num_subgraphs = num_vertex_chunks;
+  subgraphs.assign(num_subgraphs, NULL);
+  idx_map.assign(num_subgraphs, VertexList());
+  begin_vids.clear();
+  end_vids.clear();
+  for (int i = 0; i < num_subgraphs; ++i) {
+    for (vidType v = 0; v < nv; v++)
+      if (vertex_parts[v] == i) idx_map[i].push_back(v);
+    auto nv_subg = idx_map[i].size();
+    std::vector<vidType> degrees(nv_subg);
+    #pragma omp parallel for
+    for (size_t j = 0; j < nv_subg; j++)
+      degrees[j] = og->get_degree(idx_map[i][j]);
+    std::vector<eidType> offsets(nv_subg+1);
+    parallel_prefix_sum<vidType,eidType>(degrees, offsets.data());
+    std::cout << "generating subgraph[" << i << "]: " << nv_subg << " vertices, " << offsets[nv_subg] << " edges\n";
+    subgraphs[i] = new Graph();
+    subgraphs[i]->allocateFrom(nv_subg, offsets[nv_subg]);
+    std::copy(offsets.begin(), offsets.end(), subgraphs[i]->rowptr());
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (size_t j = 0; j < nv_subg; j++) {
+      auto adj = og->N(idx_map[i][j]);
+      std::copy(adj.begin(), adj.end(), subgraphs[i]->colidx() + offsets[j]);
+    }
+    subgraphs[i]->compute_max_degree();
+    write_subgraph(outfile, i);
+    delete subgraphs[i];
+    subgraphs[i] = NULL;
+    VertexList().swap(idx_map[i]);
+  }
+  write_partition_ids(outfile, vertex_parts);
+}
+
+// Each subgraph holds the edges of its part in both directions, over its replicas renumbered
+// in the order of the global ids. The master of a vertex is one of its replicas, picked by id.
+void PartitionedGraph::write_vertexcut_partitions(std::string outfile, const std::vector<uint8_t> &edge_parts) {
+  assert(og);
+  auto nv = og->V();
+  auto offsets = upper_edge_offsets(*og);
+  assert(edge_parts.size() == size_t(offsets[nv]));
+  num_subgraphs = num_vertex_chunks;
+  subgraphs.assign(num_subgraphs, NULL);
+  idx_map.assign(num_subgraphs, VertexList());
+  begin_vids.clear();
+  end_vids.clear();
+  std::vector<int8_t> vertex_masks(nv);
+  std::vector<eidType> local_ids(nv+1);
+  std::vector<uint64_t> replicas(nv, 0);
+  for (int i = 0; i < num_subgraphs; ++i) {
+    std::fill(vertex_masks.begin(), vertex_masks.end(), 0);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (vidType u = 0; u < nv; u++) {
+      auto adj = og->N(u);
+      auto e = offsets[u];
+      for (auto it = std::upper_bound(adj.begin(), adj.end(), u); it != adj.end(); ++it, ++e) {
+        if (edge_parts[e] != i) continue;
+        vertex_masks[u] = 1;
+        vertex_masks[*it] = 1;
+      }
+    }
+    parallel_prefix_sum<int8_t,eidType>(vertex_masks, local_ids.data());
+    auto nv_subg = local_ids[nv];
+    idx_map[i].resize(nv_subg);
+    std::vector<vidType> degrees(nv_subg, 0);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (vidType u = 0; u < nv; u++) {
+      if (!vertex_masks[u]) continue;
+      idx_map[i][local_ids[u]] = u;
+      replicas[u] |= uint64_t(1) << i;
+      auto adj = og->N(u);
+      auto e = offsets[u];
+      for (auto it = std::upper_bound(adj.begin(), adj.end(), u); it != adj.end(); ++it, ++e) {
+        if (edge_parts[e] != i) continue;
+        fetch_and_add(degrees[local_ids[u]], vidType(1));
+        fetch_and_add(degrees[local_ids[*it]], vidType(1));
+      }
+    }
+    std::vector<eidType> rowptr(nv_subg+1);
+    parallel_prefix_sum<vidType,eidType>(degrees, rowptr.data());
+    std::cout << "generating subgraph[" << i << "]: " << nv_subg << " replicas, " << rowptr[nv_subg] << " edges\n";
+    subgraphs[i] = new Graph();
+    subgraphs[i]->allocateFrom(nv_subg, rowptr[nv_subg]);
+    std::copy(rowptr.begin(), rowptr.end(), subgraphs[i]->rowptr());
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for (vidType u = 0; u < nv; u++) {
+      if (!vertex_masks[u]) continue;
+      auto adj = og->N(u);
+      auto e = offsets[u];
+      for (auto it = std::upper_bound(adj.begin(), adj.end(), u); it != adj.end(); ++it, ++e) {
+        if (edge_parts[e] != i) continue;
+        auto lu = local_ids[u], lv = local_ids[*it];
+        subgraphs[i]->constructEdge(fetch_and_add(rowptr[lu], eidType(1)), lv);
+        subgraphs[i]->constructEdge(fetch_and_add(rowptr[lv], eidType(1)), lu);
+      }
+    }
+    subgraphs[i]->sort_neighbors();
+    subgraphs[i]->compute_max_degree();
+    write_subgraph(outfile, i);
+    delete subgraphs[i];
+    subgraphs[i] = NULL;
+    VertexList().swap(idx_map[i]);
+  }
+  std::vector<int> masters(nv);
+  #pragma omp parallel for
+  for (vidType v = 0; v < nv; v++) {
+    auto r = replicas[v];
+    if (!r) { masters[v] = v % num_subgraphs; continue; }
+    // the (v mod #replicas)-th replica
+    for (int n = v % __builtin_popcountll(r); n > 0; n--) r &= r - 1;
+    masters[v] = __builtin_ctzll(r);
+  }
+  write_partition_ids(outfile, masters);
+}
@@ -4,23 +4,94 @@
 
 int main(int argc, char *argv[]) {
   if (argc < 2) {
-    std::cout << "Usage: " << argv[0] << " <graph> [num_gpu(1)]\n";
+    std::cout << "Usage: " << argv[0] << " <graph> [num_gpu(1)] [output_prefix] [method(0)] [clusters(all)]\n";
+    std::cout << "method: 0 vertex ranges, 1 vertex ranges balanced by work, 2 multilevel,\n"
+              << "        streaming (graph read through mmap): 3 LDG, 4 Fennel, 5 HDRF, 6 greedy vertex-cut,\n"
+              << "        7 2D partitioning of the multilevel clusters, then fetching the subgraph of the\n"
+              << "          comma-separated clusters (e.g. 0,2; all of them by default)\n";
     std::cout << "Example: " << argv[0] << " ../inputs/mico/graph\n";
     exit(1);
   }
   std::cout << "Test graph partitioning.\n";
   int n_devices = 2;
   if (argc > 2) n_devices = atoi(argv[2]);
+  int method = 0;
+  if (argc > 4) method = atoi(argv[4]);
+
+  if (method >= 3 && method <= 6) {
+    // one pass over the mapped graph; the subgraphs are written as they are generated
+    OutOfCoreGraph og(argv[1]);
+    og.print_meta_data();
+    PartitionedGraph pg(&og, n_devices);
+    Timer t;
+    t.Start();
+    if (method <= 4) {
+      auto parts = pg.streaming_edgecut_partition(method == 3 ? "ldg" : "fennel");
+      t.Stop();
+      if (argc > 3) pg.write_edgecut_partitions(argv[3], parts);
+    } else {
+      auto edge_parts = pg.streaming_vertexcut_partition(method == 5 ? "hdrf" : "greedy");
+      t.Stop();
+      if (argc > 3) pg.write_vertexcut_partitions(argv[3], edge_parts);
+    }
+    std::cout << "runtime [streaming partitioning] = " << t.Seconds() << " sec\n";
+    return 0;
+  }
 
   Graph g(argv[1]);
   g.print_meta_data();
 
+  if (method == 7) {
+    // 2D partitioning (written to the output prefix), then fetch the subgraph of the clusters
+    if (argc <= 3 || std::string(argv[3]).empty()) {
+      std::cout << "2D partitioning needs an output prefix\n";
+      exit(1);
+    }
+    std::vector<int> clusters;
+    if (argc > 5) {
+      std::stringstream ss(argv[5]);
+      std::string item;
+      while (std::getline(ss, item, ',')) clusters.push_back(std::stoi(item));
+    } else {
+      for (int i = 0; i < n_devices; i++) clusters.push_back(i);
+    }
+    for (auto c : clusters) {
+      if (c < 0 || c >= n_devices) {
+        std::cout << "cluster " << c << " is out of range [0, " << n_devices << ")\n";
+        exit(1);
+      }
+    }
+    auto cluster_ids = PartitionedGraph(&g, n_devices).multilevel_partition();
+    PartitionedGraph pg(&g, n_devices, cluster_ids);
+    pg.partition2D(argv[3], cluster_ids);
+    Graph *subg = NULL;
+    Timer t;
+    t.Start();
+    pg.fetch_partitions(argv[3], clusters, subg);
+    t.Stop();
+    std::cout << "runtime [fetch_partitions] = " << t.Seconds() << " sec\n";
+    // all the clusters together are the whole graph
+    if (argc <= 5) std::cout << (subg->V() == g.V() && subg->E() == g.E() ? "Correct\n" : "Wrong\n");
+    delete subg;
+    return 0;
+  }
+
   // partition the graph
   PartitionedGraph pg(&g, n_devices);
 #ifdef USE_INDUCED
   pg.edgecut_induced_partition1D();
 #else
-  pg.edgecut_partition1D();
+  if (method == 2) {
+    // compare with the vertex-range partition
+    std::vector<int> range_ids(g.V());
+    vidType subgraph_size = (g.V()-1) / n_devices + 1;
+    for (vidType v = 0; v < g.V(); v++) range_ids[v] = v / subgraph_size;
+    std::cout << "vertex ranges: ";
+    pg.print_partition_quality(range_ids);
+    auto cluster_ids = pg.multilevel_partition();
+    pg.edgecut_induced_partition1D(cluster_ids);
+  } else if (method == 1) pg.edgecut_balanced_partition1D();
+  else pg.edgecut_partition1D();
 #endif
   //pg.print_subgraphs();
 /*
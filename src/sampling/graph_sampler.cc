@@ -0,0 +1,157 @@
+// Copyright 2020 MIT
+// Authors: Xuhao Chen <cxh@mit.edu>
+#include "graph_sampler.h"
+#include "scan.h"
+
+// a uniform double in [0, 1) from two random words
+static inline double to_unit(uint32_t hi, uint32_t lo) {
+  return ((uint64_t(hi) << 32 | lo) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void induced_subgraph(Graph &g, const std::vector<uint8_t> &masks, VertexList &local_ids,
+                      Graph &subg, VertexList &vertices) {
+  auto nv = g.V();
+  // scan the masks into the local ids, and scatter the sampled vertices
+  local_ids.resize(size_t(nv) + 1);
+  parallel_prefix_sum<uint8_t,vidType>(masks, local_ids.data());
+  vidType n = local_ids[nv];
+  vertices.resize(n);
+  #pragma omp parallel for
+  for (vidType v = 0; v < nv; v++)
+    if (masks[v]) vertices[local_ids[v]] = v;
+  // count the edges kept in each row and scan them into the row pointers
+  std::vector<vidType> degrees(n);
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (vidType i = 0; i < n; i++) {
+    auto v = vertices[i];
+    vidType count = 0;
+    for (auto e = g.edge_begin(v); e < g.edge_end(v); e++)
+      count += masks[g.getEdgeDst(e)];
+    degrees[i] = count;
+  }
+  std::vector<eidType> offsets(size_t(n) + 1);
+  parallel_prefix_sum<vidType,eidType>(degrees, offsets.data());
+  // scatter the edges
+  subg.deallocate();
+  subg.allocateFrom(n, offsets[n]);
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (vidType i = 0; i < n; i++) {
+    auto v = vertices[i];
+    auto pos = offsets[i];
+    for (auto e = g.edge_begin(v); e < g.edge_end(v); e++) {
+      auto u = g.getEdgeDst(e);
+      if (masks[u]) subg.constructEdge(pos++, local_ids[u]);
+    }
+    subg.fixEndEdge(i, offsets[i+1]);
+  }
+}
+
+void SubgraphSampler::sample(int64_t id, Graph &subg, VertexList &vertices) {
+  select(id);
+  induced_subgraph(*g, masks, local_ids, subg, vertices);
+  #pragma omp parallel for
+  for (size_t i = 0; i < vertices.size(); i++)
+    masks[vertices[i]] = 0;
+}
+
+// draw i holds the words of block i of the stream
+void NodeSampler::select(int64_t id) {
+  auto ne = g->E();
+  if (ne == 0) return;
+  #pragma omp parallel for
+  for (vidType i = 0; i < budget; i++) {
+    uint32_t r[4];
+    rng.block(id, i, r);
+    // the destination of a uniform edge: probability deg(v)/|E| in a symmetric graph
+    auto e = eidType(to_unit(r[0], r[1]) * ne);
+    masks[g->getEdgeDst(e)] = 1;
+  }
+}
+
+EdgeSampler::EdgeSampler(Graph *graph, eidType budget, uint64_t seed) :
+    SubgraphSampler(graph, seed), budget(budget) {
+  auto nv = g->V();
+  vertex_cdf.resize(size_t(nv) + 1);
+  edge_cdf.resize(g->E());
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (vidType v = 0; v < nv; v++) {
+    double sum = 0.;
+    double inv_deg = 1. / std::max(g->get_degree(v), vidType(1));
+    for (auto e = g->edge_begin(v); e < g->edge_end(v); e++) {
+      // a sink of a directed graph has no out-edge: only the term of the source is counted
+      auto dst_deg = g->get_degree(g->getEdgeDst(e));
+      sum += inv_deg + (dst_deg > 0 ? 1. / dst_deg : 0.);
+      edge_cdf[e] = sum;
+    }
+    vertex_cdf[v] = sum;
+  }
+  parallel_prefix_sum_inplace<double>(vertex_cdf.data(), nv);
+}
+
+// draw i holds the words of block i of the stream: two for the row, two for the edge in the row
+void EdgeSampler::select(int64_t id) {
+  auto nv = g->V();
+  double total = vertex_cdf[nv];
+  if (total == 0.) return;
+  #pragma omp parallel for
+  for (eidType i = 0; i < budget; i++) {
+    uint32_t r[4];
+    rng.block(id, i, r);
+    double x = to_unit(r[0], r[1]) * total;
+    auto v = vidType(std::upper_bound(vertex_cdf.begin(), vertex_cdf.end(), x) - vertex_cdf.begin() - 1);
+    if (v >= nv) v = nv - 1;
+    auto begin = g->edge_begin(v), end = g->edge_end(v);
+    float y = to_unit(r[2], r[3]) * (vertex_cdf[v+1] - vertex_cdf[v]);
+    auto e = std::upper_bound(&edge_cdf[begin], &edge_cdf[0] + end, y) - &edge_cdf[0];
+    if (e >= end) e = end - 1;
+    masks[v] = 1;
+    masks[g->getEdgeDst(e)] = 1;
+  }
+}
+
+// the walk from root i draws the values (walk_length+1)*i + step of the stream
+void RandomWalkSampler::select(int64_t id) {
+  auto nv = g->V();
+  #pragma omp parallel for
+  for (vidType i = 0; i < num_roots; i++) {
+    uint64_t base = uint64_t(walk_length + 1) * i;
+    auto v = rng.below(nv, id, base);
+    masks[v] = 1;
+    for (int step = 1; step <= walk_length; step++) {
+      auto degree = g->get_degree(v);
+      if (degree == 0) break;
+      v = g->N(v, rng.below(degree, id, base + step));
+      masks[v] = 1;
+    }
+  }
+}
+
+ClusterSampler::ClusterSampler(Graph *graph, const std::vector<int> &cluster_ids, int cps, uint64_t seed) :
+    SubgraphSampler(graph, seed), clusters_per_subgraph(cps) {
+  auto nv = g->V();
+  assert(cluster_ids.size() == size_t(nv));
+  num_clusters = nv == 0 ? 0 : *std::max_element(cluster_ids.begin(), cluster_ids.end()) + 1;
+  if (clusters_per_subgraph > num_clusters) clusters_per_subgraph = num_clusters;
+  // group the vertices by cluster (counting sort)
+  cluster_offsets.assign(num_clusters + 1, 0);
+  for (vidType v = 0; v < nv; v++) cluster_offsets[cluster_ids[v]+1] ++;
+  for (int c = 0; c < num_clusters; c++) cluster_offsets[c+1] += cluster_offsets[c];
+  cluster_vertices.resize(nv);
+  std::vector<eidType> pos(cluster_offsets.begin(), cluster_offsets.end() - 1);
+  for (vidType v = 0; v < nv; v++) cluster_vertices[pos[cluster_ids[v]]++] = v;
+}
+
+void ClusterSampler::select(int64_t id) {
+  // Floyd's algorithm: clusters_per_subgraph distinct clusters
+  std::vector<int> chosen;
+  for (int j = num_clusters - clusters_per_subgraph; j < num_clusters; j++) {
+    int t = rng.below(j + 1, id, j);
+    if (std::find(chosen.begin(), chosen.end(), t) != chosen.end()) t = j;
+    chosen.push_back(t);
+  }
+  for (auto c : chosen) {
+    #pragma omp parallel for
+    for (auto i = cluster_offsets[c]; i < cluster_offsets[c+1]; i++)
+      masks[cluster_vertices[i]] = 1;
+  }
+}
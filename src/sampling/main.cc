@@ -1,15 +1,57 @@
-#include "graph.h"
+#include "graph_sampler.h"
+#include "graph_partition.h"
+
+void sample(SubgraphSampler &sampler, int num_subgraphs);
 
 int main(int argc, char* argv[]) {
   if (argc < 2) {
-    std::cout << "Usage: " << argv[0] << " <graph>"
-              << "[num_gpu(1)] [chunk_size(1024)]\n";
-    std::cout << "Example: " << argv[0] << " ../inputs/cora/graph\n";
+    std::cout << "Usage: " << argv[0] << " <graph> [sampler(node)] [num_subgraphs(100)] [args]\n";
+    std::cout << "samplers and their args:\n"
+              << "  khop    [num_roots(1024)] [fanouts(15,10,10)]\n"
+              << "  node    [num_vertices(|V|/10)]\n"
+              << "  edge    [num_edges(|V|/20)]\n"
+              << "  rw      [num_roots(|V|/50)] [walk_length(2)]\n"
+              << "  cluster [num_clusters(64)] [clusters_per_subgraph(4)]\n";
+    std::cout << "Example: " << argv[0] << " ../inputs/cora/graph rw 100 500 4\n";
     exit(1);
   }
-  Graph g(argv[1], 0 , 1, 0, 0, 1);
+  Graph g(argv[1]);
   g.print_meta_data();
+  std::string method = "node";
+  int num_subgraphs = 100;
+  if (argc > 2) method = argv[2];
+  if (argc > 3) num_subgraphs = atoi(argv[3]);
+  auto nv = g.V();
 
+  SubgraphSampler *sampler = NULL;
+  if (method == "khop") {
+    vidType num_roots = argc > 4 ? atoi(argv[4]) : 1024;
+    std::vector<int> fanouts = {15, 10, 10};
+    if (argc > 5) {
+      fanouts.clear();
+      std::stringstream ss(argv[5]);
+      std::string item;
+      while (std::getline(ss, item, ',')) fanouts.push_back(std::stoi(item));
+    }
+    sampler = new KHopSampler(&g, num_roots, fanouts);
+  } else if (method == "node") {
+    sampler = new NodeSampler(&g, argc > 4 ? atoi(argv[4]) : nv / 10);
+  } else if (method == "edge") {
+    sampler = new EdgeSampler(&g, argc > 4 ? atol(argv[4]) : nv / 20);
+  } else if (method == "rw") {
+    vidType num_roots = argc > 4 ? atoi(argv[4]) : nv / 50;
+    int walk_length = argc > 5 ? atoi(argv[5]) : 2;
+    sampler = new RandomWalkSampler(&g, num_roots, walk_length);
+  } else if (method == "cluster") {
+    int num_clusters = argc > 4 ? atoi(argv[4]) : 64;
+    int clusters_per_subgraph = argc > 5 ? atoi(argv[5]) : 4;
+    auto cluster_ids = PartitionedGraph(&g, num_clusters).multilevel_partition();
+    sampler = new ClusterSampler(&g, cluster_ids, clusters_per_subgraph);
+  } else {
+    std::cout << "unknown sampler " << method << "\n";
+    exit(1);
+  }
+  sample(*sampler, num_subgraphs);
+  delete sampler;
   return 0;
 }
-
@@ -1,46 +1,72 @@
 // Copyright 2020 MIT
 // Authors: Xuhao Chen <cxh@mit.edu>
-#include "graph.h"
+#include "graph_sampler.h"
 
-// roots: root vertices, from which the sampling starts
-void sample(Graph &g, VertexList roots, Graph &subg) {
+// The draws of hop h (the roots are hop 0) form the stream id*(num_hops+1)+h: slot k of the
+// hop draws its value k. A vertex is expanded at the first hop that reaches it; the frontier
+// of a hop is sorted, so the subgraph does not depend on the order the threads reach it.
+void KHopSampler::select(int64_t id) {
+  auto nv = g->V();
+  int num_hops = fanouts.size();
+  uint64_t stream = uint64_t(id) * (num_hops + 1);
+  VertexList frontier(num_roots);
+  #pragma omp parallel for
+  for (vidType i = 0; i < num_roots; i++)
+    frontier[i] = rng.below(nv, stream, i);
+  std::sort(frontier.begin(), frontier.end());
+  frontier.erase(std::unique(frontier.begin(), frontier.end()), frontier.end());
+  for (auto v : frontier) masks[v] = 1;
+  VertexList next;
+  for (int hop = 0; hop < num_hops && !frontier.empty(); hop++) {
+    size_t fanout = fanouts[hop];
+    next.resize(frontier.size() * fanout);
+    // draw the neighbors, and mark (2) the vertices not reached by the previous hops
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t i = 0; i < frontier.size(); i++) {
+      auto v = frontier[i];
+      auto degree = g->get_degree(v);
+      for (size_t j = 0; j < fanout; j++) {
+        auto k = i * fanout + j;
+        if (degree == 0) { next[k] = v; continue; }
+        auto u = g->N(v, rng.below(degree, stream + hop + 1, k)); // randomly select a neighbor
+        next[k] = u;
+        if (masks[u] == 0) masks[u] = 2;
+      }
+    }
+    // the new frontier: the vertices marked at this hop, once each
+    next.erase(std::remove_if(next.begin(), next.end(), [&](vidType u) { return masks[u] != 2; }), next.end());
+    std::sort(next.begin(), next.end());
+    next.erase(std::unique(next.begin(), next.end()), next.end());
+    #pragma omp parallel for
+    for (size_t i = 0; i < next.size(); i++) masks[next[i]] = 1;
+    frontier.swap(next);
+  }
+}
+
+// sample num_subgraphs subgraphs one after another, and report the sampling throughput
+void sample(SubgraphSampler &sampler, int num_subgraphs) {
   int num_threads = 1;
   #pragma omp parallel
   {
     num_threads = omp_get_num_threads();
   }
-  std::cout << "OpenMP Graph Sampling (" << num_threads << " threads)\n";
-  //auto nv = g.V();
+  std::cout << "OpenMP Graph Sampling (" << num_threads << " threads): "
+            << num_subgraphs << " subgraphs by the " << sampler.name() << " sampler\n";
+  Graph subg;
+  VertexList vertices;
+  uint64_t total_nv = 0, total_ne = 0, checksum = 0;
   Timer t;
   t.Start();
-  VertexLists frontiers;
-  int num_hops = 3;
-  int sample_size[3] = {15, 10, 10};
-  frontiers.resize(num_hops+1);
-  frontiers[0] = roots;
-  std::vector<size_t> frontier_size(num_hops);
-  frontier_size[0] = roots.size();
-  for (int i = 0; i < num_hops; i ++) {
-    frontier_size[i] *= sample_size[i];
-    frontiers[i+1].resize(frontier_size[i]);
-  }
-  int iter = 0;
-  for (; iter < num_hops; iter ++) {
-    #pragma omp parallel for schedule(dynamic, 1)
-    for (size_t i = 0; i < frontiers[iter].size(); i++) {
-      auto v = frontiers[iter][i];
-      auto degree = g.get_degree(v);
-      for (int j = 0; j < sample_size[iter]; j++) {
-        int e = rand() % degree; // randomly select a neighbor
-        auto u = g.N(v, e);
-        frontiers[iter+1][i*sample_size[iter]+j] = u;
-      }
-    }
-    std::cout << "Iterations " << iter+1 << ": output frontier size = " << frontiers[iter+1].size() << "\n";
+  for (int i = 0; i < num_subgraphs; i++) {
+    sampler.sample(i, subg, vertices);
+    total_nv += subg.V();
+    total_ne += subg.E();
+    for (auto v : vertices) checksum += v;
   }
   t.Stop();
-  std::cout << "iterations = " << iter+1 << ".\n";
+  std::cout << "average subgraph: |V| = " << total_nv / num_subgraphs
+            << " |E| = " << total_ne / num_subgraphs << ", checksum = " << checksum << "\n";
+  std::cout << "throughput = " << num_subgraphs / t.Seconds() << " subgraphs/sec\n";
   std::cout << "runtime [sample_omp_base] = " << t.Seconds() << " sec\n";
-  return;
 }
 
@@ -1,31 +1,7 @@
 // Copyright 2020 MIT
 // Authors: Xuhao Chen <cxh@mit.edu>
-#include "graph.h"
+#include "graph_kernels.h"
 #include "bitmap.h"
-#include "sliding_queue.h"
-#include "platform_atomics.h"
-
-void bfs_step(Graph &g, vidType *depth, SlidingQueue<vidType> &queue) {
-  #pragma omp parallel
-  {
-    QueueBuffer<vidType> lqueue(queue);
-    #pragma omp for
-    for (auto q_iter = queue.begin(); q_iter < queue.end(); q_iter++) {
-      auto src = *q_iter;
-      for (auto dst : g.N(src)) {
-        //int curr_val = parent[dst];
-        auto curr_val = depth[dst];
-        if (curr_val == MYINFINITY) { // not visited
-          //if (compare_and_swap(parent[dst], curr_val, src)) {
-          if (compare_and_swap(depth[dst], curr_val, depth[src] + 1)) {
-            lqueue.push_back(dst);
-          }
-        }
-      }
-    }
-    lqueue.flush();
-  }
-}
 
 void BFSSolver(Graph &g, vidType source, vidType* dist) {
   int num_threads = 1;
@@ -1,17 +1,150 @@
 // Copyright 2020 MIT
 // Authors: Xuhao Chen <cxh@mit.edu>
 #include "graph.h"
+#include "graph_partition.h"
 #include <mpi.h>
 
-void TCSolver(Graph &g, uint64_t &total, int, int) {
+// Adjacency lists of the remote vertices needed by one batch of local vertices
+class RemoteAdjacency {
+public:
+  VertexList vertices;           // sorted global ids of the remote vertices
+  std::vector<eidType> offsets;  // offsets[i] is the start of the i-th list in colidx
+  VertexList colidx;             // concatenated neighbor lists
+  uint64_t num_gets;             // number of MPI_Get requests issued
+
+  RemoteAdjacency() : num_gets(0) {}
+  VertexSet N(vidType v) {
+    auto i = std::lower_bound(vertices.begin(), vertices.end(), v) - vertices.begin();
+    assert(size_t(i) < vertices.size() && vertices[i] == v);
+    return VertexSet(colidx.data() + offsets[i], offsets[i+1] - offsets[i], v);
+  }
+
+  // Fetch the lists of 'vertices' with one-sided gets; 'bounds' holds the first vertex of each rank.
+  // Runs of consecutive ids owned by the same rank are fetched with a single get for
+  // their row pointers and a single get for their column indices.
+  void fetch(const VertexList &bounds, MPI_Win rowptr_win, MPI_Win colidx_win) {
+    size_t n = vertices.size();
+    std::vector<eidType> rowptrs(2*n); // row pointers of each run, with one extra entry per run
+    std::vector<size_t> run_begin;     // index of the first vertex of each run
+    std::vector<int> run_owner;
+    for (size_t i = 0; i < n; ) {
+      auto v = vertices[i];
+      int owner = std::upper_bound(bounds.begin(), bounds.end(), v) - bounds.begin() - 1;
+      size_t j = i + 1;
+      while (j < n && vertices[j] == vertices[j-1] + 1 && vertices[j] < bounds[owner+1]) j++;
+      MPI_Get(&rowptrs[i+run_begin.size()], j-i+1, MPI_INT64_T, owner,
+              v - bounds[owner], j-i+1, MPI_INT64_T, rowptr_win);
+      num_gets++;
+      run_begin.push_back(i);
+      run_owner.push_back(owner);
+      i = j;
+    }
+    run_begin.push_back(n);
+    MPI_Win_flush_all(rowptr_win);
+
+    offsets.resize(n+1);
+    offsets[0] = 0;
+    for (size_t r = 0; r < run_owner.size(); r++) {
+      auto rp = &rowptrs[run_begin[r]+r];
+      for (auto i = run_begin[r]; i < run_begin[r+1]; i++)
+        offsets[i+1] = offsets[i] + rp[i-run_begin[r]+1] - rp[i-run_begin[r]];
+    }
+    colidx.resize(offsets[n]);
+    for (size_t r = 0; r < run_owner.size(); r++) {
+      auto rp = &rowptrs[run_begin[r]+r];
+      auto len = rp[run_begin[r+1]-run_begin[r]] - rp[0];
+      if (len == 0) continue;
+      MPI_Get(&colidx[offsets[run_begin[r]]], len, MPI_UINT32_T, run_owner[r],
+              rp[0], len, MPI_UINT32_T, colidx_win);
+      num_gets++;
+    }
+    MPI_Win_flush_all(colidx_win);
+  }
+};
+
+// Each rank holds only its own 1D partition (written by test_partitioner with the balanced
+// 1D partitioning, i.e., <prefix>-part<rank> and <prefix>-parts.txt). Local vertices are
+// processed in batches of 'chunk_size'; the adjacency lists of the remote neighbors of a
+// batch are fetched from their owners with one-sided MPI before counting.
+uint64_t PartitionedTC(Graph &g, int world_rank, int world_size, int chunk_size) {
+  PartitionedGraph pg(world_size);
+  pg.read_from_file(g.get_inputfile_prefix(), world_rank);
+  auto sg = pg.get_subgraph(world_rank);
+  VertexList bounds(world_size+1, g.V());
+  for (int i = 0; i < world_size; i++) bounds[i] = pg.get_begin_vid(i);
+  auto begin = bounds[world_rank];
+  auto end = bounds[world_rank+1];
+  assert(sg->V() == end - begin);
+
+  // expose the local CSR to the other ranks
+  MPI_Win rowptr_win, colidx_win;
+  MPI_Win_create(sg->rowptr(), (sg->V()+1) * sizeof(eidType), sizeof(eidType),
+                 MPI_INFO_NULL, MPI_COMM_WORLD, &rowptr_win);
+  MPI_Win_create(sg->colidx(), sg->E() * sizeof(vidType), sizeof(vidType),
+                 MPI_INFO_NULL, MPI_COMM_WORLD, &colidx_win);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, rowptr_win);
+  MPI_Win_lock_all(MPI_MODE_NOCHECK, colidx_win);
+
+  Timer t, t_comm;
+  t.Start();
+  uint64_t counter = 0, num_remote = 0, work = 0;
+  RemoteAdjacency remote;
+  for (auto batch_begin = begin; batch_begin < end; batch_begin += chunk_size) {
+    auto batch_end = std::min(end, batch_begin + vidType(chunk_size));
+    remote.vertices.clear();
+    for (auto u = batch_begin; u < batch_end; u++) {
+      for (auto v : sg->N(u - begin))
+        if (v < begin || v >= end) remote.vertices.push_back(v);
+    }
+    std::sort(remote.vertices.begin(), remote.vertices.end());
+    remote.vertices.erase(std::unique(remote.vertices.begin(), remote.vertices.end()), remote.vertices.end());
+    num_remote += remote.vertices.size();
+    t_comm.Start();
+    remote.fetch(bounds, rowptr_win, colidx_win);
+    t_comm.Stop();
+    work += remote.colidx.size();
+
+    #pragma omp parallel for reduction(+ : counter) schedule(dynamic, 1)
+    for (auto u = batch_begin; u < batch_end; u ++) {
+      auto yu = sg->N(u - begin);
+      for (auto v : yu) {
+        if (v >= begin && v < end)
+          counter += (uint64_t)intersection_num(yu, sg->N(v - begin));
+        else
+          counter += (uint64_t)intersection_num(yu, remote.N(v));
+      }
+    }
+  }
+  t.Stop();
+  // all ranks must finish reading before the windows go away
+  MPI_Win_unlock_all(colidx_win);
+  MPI_Win_unlock_all(rowptr_win);
+  MPI_Win_free(&colidx_win);
+  MPI_Win_free(&rowptr_win);
+
+  std::cout << "Machine " << world_rank << ": |V| = " << sg->V() << " |E| = " << sg->E()
+            << ", fetched " << num_remote << " remote lists (" << work << " edges) in "
+            << remote.num_gets << " gets, communication time = " << t_comm.Seconds() << " sec\n";
+  std::cout << "runtime [dist_cpu] = " << t.Seconds() << " sec\n";
+  double max_time = 0, sum_time = 0, local_time = t.Seconds();
+  MPI_Reduce(&local_time, &max_time, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+  MPI_Reduce(&local_time, &sum_time, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+  if (world_rank == 0 && sum_time > 0)
+    std::cout << "load imbalance (max/avg runtime) = " << max_time / (sum_time / world_size) << "\n";
+  delete sg;
+  return counter;
+}
+
+void TCSolver(Graph &g, uint64_t &total, int, int chunk_size) {
   int num_threads = 1;
   #pragma omp parallel
   {
     num_threads = omp_get_num_threads();
   }
 
-  // Initialize the MPI environment
-  MPI_Init(NULL, NULL);
+  // Initialize the MPI environment; only the master thread makes MPI calls
+  int provided;
+  MPI_Init_thread(NULL, NULL, MPI_THREAD_FUNNELED, &provided);
 
   // Get the number of processes
   int world_size;
@@ -29,26 +162,32 @@ void TCSolver(Graph &g, uint64_t &total, int, int) {
   if (world_rank == 0) {
     std::cout << "MPI OpenMP TC: " << world_size << " machines, " << num_threads << " threads per machine\n";
   }
-  auto num_tasks = g.V();
-  vidType ntasks_per_rank = num_tasks / world_size;
-  vidType begin = ntasks_per_rank * world_rank;
-  vidType end = ntasks_per_rank * (world_rank+1);
-  if (end > num_tasks) end = num_tasks;
-  std::cout << "Machine " << world_rank << " " << processor_name 
-            << ": [" << begin << ", " << end << ")\n";
-
-  Timer t;
-  t.Start();
   uint64_t counter = 0;
-  #pragma omp parallel for reduction(+ : counter) schedule(dynamic, 1)
-  for (auto u = begin; u < end; u ++) {
-    auto yu = g.N(u);
-    for (auto v : yu) {
-      counter += (uint64_t)intersection_num(yu, g.N(v));
-    } 
+  if (g.rowptr() == NULL) { // partitioned: each machine loads its own subgraph
+    std::cout << "Machine " << world_rank << " " << processor_name << ": loading subgraph " << world_rank << "\n";
+    counter = PartitionedTC(g, world_rank, world_size, chunk_size);
+  } else { // replicated: each machine holds the whole graph
+    auto num_tasks = g.V();
+    vidType ntasks_per_rank = (num_tasks - 1) / world_size + 1;
+    vidType begin = ntasks_per_rank * world_rank;
+    vidType end = ntasks_per_rank * (world_rank+1);
+    if (begin > num_tasks) begin = num_tasks;
+    if (end > num_tasks) end = num_tasks;
+    std::cout << "Machine " << world_rank << " " << processor_name
+              << ": [" << begin << ", " << end << ")\n";
+
+    Timer t;
+    t.Start();
+    #pragma omp parallel for reduction(+ : counter) schedule(dynamic, 1)
+    for (auto u = begin; u < end; u ++) {
+      auto yu = g.N(u);
+      for (auto v : yu) {
+        counter += (uint64_t)intersection_num(yu, g.N(v));
+      }
+    }
+    t.Stop();
+    std::cout << "runtime [dist_cpu] = " << t.Seconds() << " sec\n";
   }
-  t.Stop();
-  std::cout << "runtime [dist_cpu] = " << t.Seconds() << " sec\n";
   std::cout << "Local sum = " << counter << " on machine " << world_rank << "\n";
 
   uint64_t global_sum;
@@ -0,0 +1,40 @@
+// Copyright 2020 MIT
+#include "local_tc.h"
+
+#pragma omp declare reduction(vec_u64_plus : std::vector<uint64_t> : \
+    std::transform(omp_out.begin(), omp_out.end(), omp_in.begin(), omp_out.begin(), std::plus<uint64_t>())) \
+    initializer(omp_priv = decltype(omp_orig)(omp_orig.size()))
+
+// each triangle u->v->w is found once, from the edge (u,v)
+void VertexTriangleCounts(Graph &g, std::vector<uint64_t> &counts) {
+  counts.assign(g.V(), 0);
+  #pragma omp parallel for reduction(vec_u64_plus:counts) schedule(dynamic, 1)
+  for (vidType u = 0; u < g.V(); u ++) {
+    auto adj_u = g.N(u);
+    for (auto v : adj_u) {
+      auto common = intersection_set(adj_u, g.N(v));
+      counts[u] += common.size();
+      counts[v] += common.size();
+      for (auto w : common) counts[w] += 1;
+    }
+  }
+}
+
+// For an edge u->v of the DAG, the third vertex w of a triangle is in exactly one of
+// N+(u)&N+(v), N+(u)&N-(v) or N-(u)&N-(v); N-(u)&N+(v) would form a cycle.
+void EdgeTriangleCounts(Graph &g, std::vector<vidType> &support) {
+  support.assign(g.E(), 0);
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (vidType u = 0; u < g.V(); u ++) {
+    auto out_u = g.N(u);
+    auto in_u = g.in_neigh(u);
+    for (vidType i = 0; i < out_u.size(); i++) {
+      auto v = out_u[i];
+      auto out_v = g.N(v);
+      auto in_v = g.in_neigh(v);
+      support[g.get_eid(u, i)] = intersection_num(out_u, out_v) +
+                                 intersection_num(out_u, in_v) +
+                                 intersection_num(in_u, in_v);
+    }
+  }
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include "graph.h"
+
+// Local triangle counts on a DAG (oriented undirected graph).
+// Per-vertex counts are accumulated in thread-local arrays and then reduced;
+// per-edge counts (truss support) are indexed by g.get_eid() of the DAG and
+// each edge is written only by the thread that owns its source vertex.
+
+// number of triangles containing each vertex
+void VertexTriangleCounts(Graph &g, std::vector<uint64_t> &counts);
+
+// number of triangles containing each edge of the DAG;
+// requires the incoming edges of the DAG (g.build_reverse_graph())
+void EdgeTriangleCounts(Graph &g, std::vector<vidType> &support);
+
+// write an array of counts to a binary file
+template <typename T>
+void write_counts(std::string filename, const std::vector<T> &counts) {
+  std::ofstream outfile(filename.c_str(), std::ios::binary);
+  if (!outfile) {
+    std::cout << "File not available\n";
+    throw 1;
+  }
+  outfile.write(reinterpret_cast<const char*>(counts.data()), counts.size()*sizeof(T));
+  outfile.close();
+}
@@ -0,0 +1,279 @@
+// Copyright 2020 MIT
+// Approximate triangle counting with error/confidence targets:
+//   edge    : uniform edge sampling, |N(u) & N(v)| per sampled edge
+//   wedge   : uniform wedge sampling, closure test per sampled wedge
+//   doulion : DOULION sparsification, keep each edge with probability p
+//   color   : color coding, keep monochromatic edges with 1/p colors
+// Sampling stops once the confidence interval is within epsilon of the estimate.
+#include <numeric>
+#include "graph.h"
+#include "scan.h"
+
+typedef std::vector<eidType> RowPtr;
+typedef std::vector<vidType> ColIdx;
+
+// splitmix64 finalizer; all random choices are pure functions of
+// (seed, index), so results do not depend on the number of threads
+static inline uint64_t mix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+static inline uint64_t hash_pair(uint64_t seed, uint64_t a, uint64_t b) {
+  return mix64(seed ^ mix64(a ^ mix64(b)));
+}
+
+static inline double to_unit(uint64_t x) {
+  return (x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// z such that P(|Z| > z) = delta for a standard normal Z
+static double normal_quantile(double delta) {
+  double lo = 0.0, hi = 10.0;
+  for (int i = 0; i < 100; i++) {
+    double mid = (lo + hi) / 2;
+    if (std::erfc(mid / std::sqrt(2.0)) > delta) lo = mid;
+    else hi = mid;
+  }
+  return (lo + hi) / 2;
+}
+
+// inv_hit_prob: the inverse of a lower bound on the probability that a sample is nonzero if
+// the graph has a triangle (e.g., one of the 6 directed edges of a triangle among E edges)
+class Estimate {
+public:
+  Estimate(double scale, double inv_hit_prob) : scale_(scale), inv_hit_prob_(inv_hit_prob),
+    n_(0), hits_(0), sum_(0), sum2_(0) {}
+  void add(uint64_t n, uint64_t hits, double sum, double sum2) { n_ += n; hits_ += hits; sum_ += sum; sum2_ += sum2; }
+  uint64_t count() const { return n_; }
+  double value() const { return n_ == 0 ? 0 : scale_ * sum_ / n_; }
+  double half_width(double z) const { // confidence interval half width
+    if (n_ < 2) return std::numeric_limits<double>::infinity();
+    double mean = sum_ / n_;
+    double var = std::max(0.0, (sum2_ - n_ * mean * mean) / (n_ - 1));
+    return z * scale_ * std::sqrt(var / n_);
+  }
+  // Without a nonzero sample, the graph is taken as triangle-free once the rule-of-three
+  // bound (95% confidence) on the hit probability, 3/n, is below that of a single triangle.
+  // Otherwise the CI, only used after min_hits nonzero samples, is within eps of the estimate.
+  bool converged(double z, double eps) const {
+    if (hits_ == 0) return n_ > 0 && 3.0 / n_ * inv_hit_prob_ < 1.0;
+    return hits_ >= min_hits && half_width(z) <= eps * value();
+  }
+  void print(std::string unit, double z) const {
+    auto hw = half_width(z);
+    std::cout << "  " << unit << " = " << n_ << ", estimate = " << value()
+              << ", CI = [" << std::max(0.0, value() - hw) << ", " << value() + hw << "]\n";
+  }
+  static const uint64_t min_hits = 5;
+private:
+  double scale_, inv_hit_prob_;
+  uint64_t n_, hits_;
+  double sum_, sum2_;
+};
+
+static const uint64_t batch_size = 1 << 16;
+static const uint64_t max_samples = uint64_t(1) << 32;
+static const int min_trials = 3;
+static const int max_trials = 100;
+
+// the progress of the sampling is printed at 1, 2, 4, ... batches
+static inline bool is_power_of_two(uint64_t x) { return x > 0 && (x & (x - 1)) == 0; }
+
+// source vertex of the e-th edge
+static inline vidType edge_src(Graph &g, eidType e) {
+  auto rowptr = g.rowptr();
+  return vidType(std::upper_bound(rowptr, rowptr + g.V() + 1, e) - rowptr - 1);
+}
+
+// Each triangle is counted 6 times over all directed edges
+double EdgeSampling(Graph &g, double eps, double z, uint64_t seed) {
+  if (g.E() == 0) return 0;
+  Estimate est(double(g.E()) / 6.0, double(g.E()) / 6.0);
+  while (!est.converged(z, eps) && est.count() < max_samples) {
+    auto offset = est.count();
+    double sum = 0, sum2 = 0;
+    uint64_t hits = 0;
+    #pragma omp parallel for reduction(+:sum,sum2,hits) schedule(dynamic, 64)
+    for (uint64_t i = 0; i < batch_size; i++) {
+      eidType e = mix64(seed ^ mix64(offset + i)) % g.E();
+      auto u = edge_src(g, e);
+      auto v = g.getEdgeDst(e);
+      double x = intersection_num(g.N(u), g.N(v));
+      sum += x;
+      sum2 += x * x;
+      hits += x > 0;
+    }
+    est.add(batch_size, hits, sum, sum2);
+    if (is_power_of_two(est.count() / batch_size)) est.print("samples", z);
+  }
+  if (!is_power_of_two(est.count() / batch_size)) est.print("samples", z);
+  return est.value();
+}
+
+// Each triangle closes 3 wedges
+double WedgeSampling(Graph &g, double eps, double z, uint64_t seed) {
+  std::vector<uint64_t> wedges(g.V()+1, 0);
+  #pragma omp parallel for
+  for (vidType v = 0; v < g.V(); v++) {
+    uint64_t d = g.get_degree(v);
+    wedges[v+1] = d * (d - 1) / 2;
+  }
+  std::partial_sum(wedges.begin(), wedges.end(), wedges.begin());
+  auto num_wedges = wedges[g.V()];
+  std::cout << "Number of wedges: " << num_wedges << "\n";
+  if (num_wedges == 0) return 0;
+  Estimate est(double(num_wedges) / 3.0, double(num_wedges) / 3.0);
+  while (!est.converged(z, eps) && est.count() < max_samples) {
+    auto offset = est.count();
+    double sum = 0;
+    #pragma omp parallel for reduction(+:sum) schedule(dynamic, 64)
+    for (uint64_t i = 0; i < batch_size; i++) {
+      auto r = mix64(seed ^ mix64(offset + i));
+      auto w = r % num_wedges;
+      auto v = vidType(std::upper_bound(wedges.begin(), wedges.end(), w) - wedges.begin() - 1);
+      auto r2 = mix64(r);
+      vidType d = g.get_degree(v);
+      vidType a = r2 % d;
+      vidType b = (mix64(r2) % (d - 1) + a + 1) % d; // b != a
+      if (g.is_connected(g.N(v, a), g.N(v, b))) sum += 1;
+    }
+    est.add(batch_size, uint64_t(sum), sum, sum); // indicator: x*x == x
+    if (is_power_of_two(est.count() / batch_size)) est.print("samples", z);
+  }
+  if (!is_power_of_two(est.count() / batch_size)) est.print("samples", z);
+  return est.value();
+}
+
+// Build the sparsified DAG (u < v) of edges passing the keep filter
+template <typename F>
+static void sparsify(Graph &g, F keep, RowPtr &rowptr, ColIdx &colidx) {
+  std::vector<vidType> degrees(g.V(), 0);
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (vidType u = 0; u < g.V(); u++) {
+    vidType n = 0;
+    for (auto v : g.N(u))
+      if (v > u && keep(u, v)) n++;
+    degrees[u] = n;
+  }
+  rowptr.resize(g.V()+1);
+  parallel_prefix_sum<vidType,eidType>(degrees, rowptr.data());
+  colidx.resize(rowptr[g.V()]);
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (vidType u = 0; u < g.V(); u++) {
+    auto pos = rowptr[u];
+    for (auto v : g.N(u))
+      if (v > u && keep(u, v)) colidx[pos++] = v;
+  }
+}
+
+static uint64_t count_dag(vidType nv, RowPtr &rowptr, ColIdx &colidx) {
+  uint64_t counter = 0;
+  #pragma omp parallel for reduction(+ : counter) schedule(dynamic, 1)
+  for (vidType u = 0; u < nv; u++) {
+    VertexSet adj_u(&colidx[rowptr[u]], rowptr[u+1] - rowptr[u], u);
+    for (auto v : adj_u) {
+      VertexSet adj_v(&colidx[rowptr[v]], rowptr[v+1] - rowptr[v], v);
+      counter += intersection_num(adj_u, adj_v);
+    }
+  }
+  return counter;
+}
+
+// Repeat independent sparsification trials until the CI over trials meets the target.
+// DOULION keeps each edge with probability p and scales by 1/p^3;
+// color coding keeps edges with equally colored endpoints and scales by c^2.
+double SparsifiedCounting(Graph &g, bool color_coding, double p, double eps, double z, uint64_t seed) {
+  RowPtr rowptr;
+  ColIdx colidx;
+  uint64_t num_colors = std::max(uint64_t(1), uint64_t(std::llround(1.0 / p)));
+  double scale = color_coding ? double(num_colors) * num_colors : 1.0 / (p * p * p);
+  Estimate est(1.0, scale); // a triangle is kept with probability 1/scale
+  for (int trial = 0; trial < max_trials; trial++) {
+    if (trial >= min_trials && est.converged(z, eps)) break;
+    uint64_t trial_seed = mix64(seed + trial);
+    if (color_coding) {
+      sparsify(g, [&](vidType u, vidType v) {
+        return mix64(trial_seed ^ u) % num_colors == mix64(trial_seed ^ v) % num_colors;
+      }, rowptr, colidx);
+    } else {
+      sparsify(g, [&](vidType u, vidType v) {
+        return to_unit(hash_pair(trial_seed, u, v)) < p;
+      }, rowptr, colidx);
+    }
+    double x = scale * count_dag(g.V(), rowptr, colidx);
+    est.add(1, x > 0, x, x * x);
+    std::cout << "  trial " << trial << ": kept " << colidx.size() << " edges, sample = " << x << "\n";
+    est.print("trials", z);
+  }
+  return est.value();
+}
+
+uint64_t ExactCounting(Graph &g) {
+  uint64_t counter = 0;
+  #pragma omp parallel for reduction(+ : counter) schedule(dynamic, 1)
+  for (vidType u = 0; u < g.V(); u++) {
+    auto adj_u = g.N(u);
+    for (auto v : adj_u) {
+      if (v >= u) break;
+      counter += intersection_num(adj_u, g.N(v), v);
+    }
+  }
+  return counter;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cout << "Usage: " << argv[0] << " <graph> [method(edge|wedge|doulion|color)] [epsilon(0.05)] [delta(0.05)] [p(0.1)] [seed(0)] [verify(0)]\n";
+    std::cout << "Example: " << argv[0] << " /graph_inputs/mico/graph wedge 0.01 0.05\n";
+    exit(1);
+  }
+  std::cout << "Approximate Triangle Counting: assuming the graph is undirected and the neighbor lists are sorted.\n";
+  std::string method = "edge";
+  double eps = 0.05, delta = 0.05, p = 0.1;
+  uint64_t seed = 0;
+  int verify = 0;
+  if (argc > 2) method = argv[2];
+  if (argc > 3) eps = atof(argv[3]);
+  if (argc > 4) delta = atof(argv[4]);
+  if (argc > 5) p = atof(argv[5]);
+  if (argc > 6) seed = atoll(argv[6]);
+  if (argc > 7) verify = atoi(argv[7]);
+  assert(eps > 0 && delta > 0 && delta < 1 && p > 0 && p <= 1);
+  Graph g(argv[1]);
+  g.print_meta_data();
+
+  int num_threads = 1;
+  #pragma omp parallel
+  {
+    num_threads = omp_get_num_threads();
+  }
+  double z = normal_quantile(delta);
+  std::cout << "OpenMP Approximate Triangle Counting (" << num_threads << " threads), method: " << method
+            << ", epsilon = " << eps << ", confidence = " << 1.0 - delta << "\n";
+  Timer t;
+  t.Start();
+  double estimate = 0;
+  if (method == "edge") estimate = EdgeSampling(g, eps, z, seed);
+  else if (method == "wedge") estimate = WedgeSampling(g, eps, z, seed);
+  else if (method == "doulion") estimate = SparsifiedCounting(g, false, p, eps, z, seed);
+  else if (method == "color") estimate = SparsifiedCounting(g, true, p, eps, z, seed);
+  else {
+    std::cout << "Unknown method: " << method << "\n";
+    exit(1);
+  }
+  t.Stop();
+  std::cout << "runtime [omp_approx_" << method << "] = " << t.Seconds() << " sec\n";
+  std::cout << "estimated_num_triangles = " << uint64_t(std::llround(estimate)) << "\n";
+  if (verify) {
+    t.Start();
+    auto total = ExactCounting(g);
+    t.Stop();
+    std::cout << "runtime [exact] = " << t.Seconds() << " sec\n";
+    std::cout << "total_num_triangles = " << total << ", relative error = "
+              << (total == 0 ? 0 : std::abs(estimate - double(total)) / total) << "\n";
+  }
+  return 0;
+}
@@ -1,6 +1,6 @@
 // Copyright 2020 MIT
 // Authors: Xuhao Chen <cxh@mit.edu>
-#include "graph.h"
+#include "graph_kernels.h"
 
 void TCSolver(Graph &g, uint64_t &total, int, int) {
   int num_threads = 1;
@@ -11,15 +11,7 @@ void TCSolver(Graph &g, uint64_t &total, int, int) {
   std::cout << "OpenMP Triangle Counting (" << num_threads << " threads)\n";
   Timer t;
   t.Start();
-  uint64_t counter = 0;
-  #pragma omp parallel for reduction(+ : counter) schedule(dynamic, 1)
-  for (vidType u = 0; u < g.V(); u ++) {
-    auto adj_u = g.N(u);
-    for (auto v : adj_u) {
-      counter += (uint64_t)intersection_num(adj_u, g.N(v));
-    }
-  }
-  total = counter;
+  total = tc_count(g);
   t.Stop();
   std::cout << "runtime [omp_base] = " << t.Seconds() << " sec\n";
   return;
@@ -0,0 +1,47 @@
+// Copyright 2020 MIT
+#include "local_tc.h"
+
+// Triangle counting with per-vertex and per-edge (truss support) counts.
+// The counts are written to <graph>.vtri.bin (uint64_t per vertex) and
+// <graph>.etri.bin (vidType per edge of the DAG, in CSR order).
+void TCSolver(Graph &g, uint64_t &total, int, int) {
+  int num_threads = 1;
+  #pragma omp parallel
+  {
+    num_threads = omp_get_num_threads();
+  }
+  std::cout << "OpenMP Local Triangle Counting (" << num_threads << " threads)\n";
+  g.build_reverse_graph();
+  std::vector<uint64_t> vertex_counts;
+  std::vector<vidType> edge_counts;
+  Timer t;
+  t.Start();
+  VertexTriangleCounts(g, vertex_counts);
+  t.Stop();
+  std::cout << "runtime [omp_local_vertex] = " << t.Seconds() << " sec\n";
+  t.Start();
+  EdgeTriangleCounts(g, edge_counts);
+  t.Stop();
+  std::cout << "runtime [omp_local_edge] = " << t.Seconds() << " sec\n";
+
+  uint64_t vertex_sum = 0, edge_sum = 0;
+  double cc_sum = 0.0;
+  #pragma omp parallel for reduction(+:vertex_sum,edge_sum,cc_sum)
+  for (vidType v = 0; v < g.V(); v ++) {
+    vertex_sum += vertex_counts[v];
+    for (auto e = g.edge_begin(v); e < g.edge_end(v); e++)
+      edge_sum += edge_counts[e];
+    uint64_t d = g.get_degree(v) + g.in_neigh(v).size(); // undirected degree
+    if (d > 1) cc_sum += 2.0 * vertex_counts[v] / (d * (d - 1));
+  }
+  assert(vertex_sum % 3 == 0 && edge_sum % 3 == 0);
+  assert(vertex_sum == edge_sum);
+  total = vertex_sum / 3;
+  std::cout << "average local clustering coefficient = " << cc_sum / g.V() << "\n";
+
+  auto prefix = g.get_inputfile_prefix();
+  std::cout << "Writing local counts to " << prefix << ".vtri.bin and " << prefix << ".etri.bin\n";
+  write_counts(prefix + ".vtri.bin", vertex_counts);
+  write_counts(prefix + ".etri.bin", edge_counts);
+  return;
+}
@@ -1 +1,4 @@
+# replicated graph
 mpirun -N 2 ../../bin/tc_dist_cpu ~/datasets/automine/livej/dag 1
+# partitioned graph (generated by ../partitioner/run-partitioner.sh)
+mpirun -N 2 ../../bin/tc_dist_cpu ~/datasets/automine/livej/dag 1 1
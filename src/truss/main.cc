@@ -0,0 +1,37 @@
+// Copyright 2020, MIT
+#include "graph.h"
+
+void KTrussSolver(Graph &g, std::vector<vidType> &trussness, vidType &max_truss, int n_gpu, int chunk_size);
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    std::cout << "Usage: " << argv[0] << " <graph> [num_gpu(1)] [chunk_size(1024)] [write_output(0)]\n";
+    std::cout << "Example: " << argv[0] << " ../inputs/citeseer/graph\n";
+    exit(1);
+  }
+  std::cout << "K-Truss decomposition: assumes symmetric graph with sorted neighbor lists\n";
+  Graph g(argv[1], true, false); // use DAG
+  int n_devices = 1;
+  int chunk_size = 1024;
+  int write_output = 0;
+  if (argc > 2) n_devices = atoi(argv[2]);
+  if (argc > 3) chunk_size = atoi(argv[3]);
+  if (argc > 4) write_output = atoi(argv[4]);
+  g.print_meta_data();
+  std::vector<vidType> trussness(g.E(), 0);
+  vidType max_truss = 0;
+  KTrussSolver(g, trussness, max_truss, n_devices, chunk_size);
+  std::map<vidType, eidType> histogram;
+  for (auto k : trussness) histogram[k] ++;
+  for (auto it = histogram.rbegin(); it != histogram.rend() && std::distance(histogram.rbegin(), it) < 10; it++)
+    std::cout << "Number of edges with trussness " << it->first << ": " << it->second << "\n";
+  std::cout << "maxTruss = " << max_truss << "\n";
+  if (write_output) {
+    auto filename = g.get_inputfile_prefix() + ".truss.bin";
+    std::cout << "Writing edge trussness to " << filename << "\n";
+    std::ofstream outfile(filename.c_str(), std::ios::binary);
+    outfile.write(reinterpret_cast<const char*>(trussness.data()), trussness.size()*sizeof(vidType));
+    outfile.close();
+  }
+  return 0;
+}
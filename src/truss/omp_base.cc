@@ -0,0 +1,144 @@
+// Copyright 2020 MIT
+#include "local_tc.h"
+#include "bitmap.h"
+#include "sliding_queue.h"
+#include "platform_atomics.h"
+
+// edge id of the undirected edge {u,w} in the DAG
+static inline eidType find_edge(Graph &g, vidType u, vidType w) {
+  auto begin = g.adj_ptr(u);
+  auto end = begin + g.get_degree(u);
+  auto it = std::lower_bound(begin, end, w);
+  if (it != end && *it == w) return g.edge_begin(u) + (it - begin);
+  begin = g.adj_ptr(w);
+  end = begin + g.get_degree(w);
+  it = std::lower_bound(begin, end, u);
+  assert(it != end && *it == u);
+  return g.edge_begin(w) + (it - begin);
+}
+
+// source vertex of the edge e
+static inline vidType edge_src(Graph &g, eidType e) {
+  auto rowptr = g.rowptr();
+  return vidType(std::upper_bound(rowptr, rowptr + g.V() + 1, e) - rowptr - 1);
+}
+
+// Level-synchronous edge peeling (PKT):
+// 1) compute the support (triangle count) of each edge of the DAG
+// 2) at level k, repeatedly peel all remaining edges with support k in parallel;
+//    a peeled edge has trussness k+2
+// 3) peeling an edge decrements the support of the other two edges of each of its
+//    remaining triangles; edges whose support drops to k join the next sub-round.
+//    Peeled edges are marked in a bitmap instead of being removed from the CSR.
+void KTrussSolver(Graph &g, std::vector<vidType> &trussness, vidType &max_truss, int, int) {
+  int num_threads = 1;
+  #pragma omp parallel
+  {
+    num_threads = omp_get_num_threads();
+  }
+  std::cout << "OpenMP k-truss decomposition (" << num_threads << " threads)\n";
+  g.build_reverse_graph();
+  // intersections with incoming neighbor lists may exceed the DAG's max out-degree
+  vidType max_in_degree = 0;
+  #pragma omp parallel for reduction(max:max_in_degree)
+  for (vidType v = 0; v < g.V(); v++)
+    max_in_degree = std::max(max_in_degree, vidType(g.in_neigh(v).size()));
+  VertexSet::MAX_DEGREE = std::max(VertexSet::MAX_DEGREE, max_in_degree);
+  auto ne = g.E();
+  std::vector<vidType> support;
+  Bitmap deleted(ne);  // edges peeled in previous sub-rounds
+  Bitmap in_curr(ne);  // edges in the current sub-round
+  deleted.reset();
+  in_curr.reset();
+  SlidingQueue<eidType> queue(ne);
+
+  Timer t;
+  t.Start();
+  EdgeTriangleCounts(g, support);
+  t.Stop();
+  std::cout << "runtime [edge_support] = " << t.Seconds() << " sec\n";
+
+  t.Start();
+  eidType num_deleted = 0;
+  vidType level = 0;
+  max_truss = 0;
+  while (num_deleted < ne) {
+    // skip empty levels
+    vidType min_support = std::numeric_limits<vidType>::max();
+    #pragma omp parallel for reduction(min:min_support)
+    for (eidType e = 0; e < ne; e++)
+      if (!deleted.get_bit(e) && support[e] < min_support) min_support = support[e];
+    level = min_support;
+    queue.reset();
+    #pragma omp parallel
+    {
+      QueueBuffer<eidType> lqueue(queue);
+      #pragma omp for
+      for (eidType e = 0; e < ne; e++)
+        if (!deleted.get_bit(e) && support[e] == level) lqueue.push_back(e);
+      lqueue.flush();
+    }
+    queue.slide_window();
+    while (!queue.empty()) {
+      #pragma omp parallel for
+      for (auto it = queue.begin(); it < queue.end(); it++)
+        in_curr.set_bit_atomic(*it);
+      #pragma omp parallel
+      {
+        QueueBuffer<eidType> lqueue(queue);
+        auto decrement = [&](eidType x) {
+          if (support[x] > level) {
+            auto old = fetch_and_add(support[x], -1);
+            if (old == level + 1) lqueue.push_back(x);
+            else if (old <= level) fetch_and_add(support[x], 1);
+          }
+        };
+        // for triangles with two edges in the current sub-round,
+        // only the one with the smaller id updates the third edge
+        auto update = [&](eidType e, eidType e1, eidType e2) {
+          if (deleted.get_bit(e1) || deleted.get_bit(e2)) return;
+          bool c1 = in_curr.get_bit(e1);
+          bool c2 = in_curr.get_bit(e2);
+          if (c1 && c2) return;
+          if (!c1 && !c2) {
+            decrement(e1);
+            decrement(e2);
+          } else if (c1) {
+            if (e < e1) decrement(e2);
+          } else {
+            if (e < e2) decrement(e1);
+          }
+        };
+        #pragma omp for schedule(dynamic, 64)
+        for (auto it = queue.begin(); it < queue.end(); it++) {
+          auto e = *it;
+          trussness[e] = level + 2;
+          auto u = edge_src(g, e);
+          auto v = g.getEdgeDst(e);
+          auto out_u = g.N(u);
+          auto in_u = g.in_neigh(u);
+          auto out_v = g.N(v);
+          auto in_v = g.in_neigh(v);
+          for (auto w : intersection_set(out_u, out_v))
+            update(e, find_edge(g, u, w), find_edge(g, v, w));
+          for (auto w : intersection_set(out_u, in_v))
+            update(e, find_edge(g, u, w), find_edge(g, w, v));
+          for (auto w : intersection_set(in_u, in_v))
+            update(e, find_edge(g, w, u), find_edge(g, w, v));
+        }
+        lqueue.flush();
+      }
+      #pragma omp parallel for
+      for (auto it = queue.begin(); it < queue.end(); it++) {
+        deleted.set_bit_atomic(*it);
+        in_curr.clear_bit_atomic(*it);
+      }
+      num_deleted += queue.size();
+      queue.slide_window();
+    }
+    max_truss = level + 2;
+  }
+  t.Stop();
+  std::cout << "runtime [ktruss_omp_base] = " << t.Seconds() << " sec\n";
+  return;
+}
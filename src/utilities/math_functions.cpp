@@ -1,6 +1,10 @@
 #include "random.h"
+#include "philox.h"
 #include "simd_functions.h"
 #include "math_functions.hh"
+#include "fused_spmm.h"
+#include "blas1.h"
+#include <atomic>
 
 #define NOT_IMPLEMENTED                                                        \
   do {                                                                         \
@@ -98,32 +102,7 @@ float masked_accuracy_multi(int begin, int end, int count, int num_classes,
  
 // dot product
 float dot(int n, const float* x, const float* y) {
-  float sum = 0;
-  for (int i = 0; i < n; ++i) sum += x[i]*y[i];
-  return sum;
-/*
-#ifdef __AVX512F__
-  const int alignedN = n - n % 16;
-  __m512 r16 = mul16<0>(x, y);
-  for (int i = 0; i < alignedN; i += 16)
-    r16 = fma16<0>(r16, &x[i], &y[i]);
-  float sum = reduce16(r16);
-  for (int i = alignedN; i < n; ++i) sum += x[i]*y[i];
-  return sum;
-#else
-#ifdef __AVX2__
-  const int alignedN = n - n % 8;
-  __m256 r8 = mul8<0>(x, y);
-  for (int i = 0; i < alignedN; i += 8)
-    r8 = fma8<0>(r8, &x[i], &y[i]);
-  float sum = reduce8(r8);
-  for (int i = alignedN; i < n; ++i) sum += x[i]*y[i];
-  return sum;
-#else
-  return cblas_sdot(n, x, 1, y, 1);
-#endif
-#endif
-*/
+  return blas1::dot(n, x, y);
 }
 
 int argmax(int num, const float* arr) {
@@ -202,19 +181,9 @@ void spmm(size_t x, size_t y, size_t z, size_t nnz,
   }
   mkl_sparse_destroy(csrA);
 #else
-  #pragma omp parallel
-  {
-  vec_t neighbor(y);
-  #pragma omp for schedule(dynamic, 64)
-  for (size_t i = 0; i < x; i++) {
-    clear_cpu(y, &C[i*y]);
-    for (auto e = A_idx_ptr[i]; e != A_idx_ptr[i+1]; e++) {
-      const auto j = A_nnz_idx[e];
-      scale(y, A_nonzeros[e], &B[j*y], &neighbor[0]);
-      vadd_cpu(y, &C[i*y], &neighbor[0], &C[i*y]);
-    }
-  }
-  }
+  fused_spmm_cpu(x, int(y), A_idx_ptr, A_nnz_idx,
+                 [A_nonzeros](size_t e, int) { return A_nonzeros[e]; },
+                 [](size_t) { return 1.0f; }, B, C);
 #endif
   //double t2 = omp_get_wtime();
   //time_ops[OP_SPARSEMM] += t2 - t1;
@@ -356,7 +325,7 @@ void scale(int n, const float a, const float* x, float* y) {
 }
 
 void axpy(size_t n, const float_t a, float_t* x, float_t* y) {
-  cblas_saxpy(n, a, x, 1, y, 1);
+  blas1::axpy(n, a, x, y);
 }
 
 void copy_cpu(size_t n, const float_t* in, float_t* out) {
@@ -387,25 +356,16 @@ void clear_cpu(int n, float* in) {
   // memset(in, 0, n*sizeof(float_t));
 }
 
-static PerThreadRNG* per_thread_rng = nullptr;
-inline uint8_t bernoulli(float_t p) {
-  if (!per_thread_rng) {
-    per_thread_rng = new PerThreadRNG();
-  }
-  return per_thread_rng->get_number() > p ? 1 : 0;
-}
-
-inline void rng_bernoulli(const int n, float p, mask_t *r) {
-  boost::bernoulli_distribution<float> random_distribution(p);
-  boost::variate_generator<rng_t*, boost::bernoulli_distribution<float> >
-      variate_generator(rng(), random_distribution);
-  for (int i = 0; i < n; ++i) r[i] = static_cast<mask_t>(variate_generator());
-}
+// Dropout masks are drawn from a counter-based generator: the call number selects the stream
+// and the position of the element the index in it, so the masks are the same for any number
+// of threads and the threads share no generator state.
+#define DROPOUT_CHUNK 4096 // elements per parallel task
+static const Philox dropout_rng(1);
+static std::atomic<uint64_t> dropout_calls(0);
 
 void dropout(size_t m, float scale, float dropout_rate, const float* in,
              mask_t* masks, float* out) {
-  //for (size_t i = 0; i < m; ++i) masks[i] = bernoulli(dropout_rate);
-  rng_bernoulli(m, 1-dropout_rate, masks);
+  dropout_rng.bernoulli(dropout_calls++, 0, m, 1-dropout_rate, masks);
   for (size_t i = 0; i < m; ++i)
     out[i] = in[i] * (float_t)masks[i] * scale;
 }
@@ -413,13 +373,15 @@ void dropout(size_t m, float scale, float dropout_rate, const float* in,
 void dropout_cpu(size_t n, size_t m, float scale, float dropout_rate,
                  const float* in, mask_t* masks, float* out) {
   double t1 = omp_get_wtime();
+  auto stream = dropout_calls++;
+  size_t len = n * m;
   #pragma omp parallel for
-  for (size_t i = 0; i < n; i++) {
-    rng_bernoulli(m, 1-dropout_rate, &masks[i*m]);
+  for (size_t begin = 0; begin < len; begin += DROPOUT_CHUNK) {
+    size_t end = std::min(len, begin + DROPOUT_CHUNK);
+    dropout_rng.bernoulli(stream, begin, end - begin, 1-dropout_rate, &masks[begin]);
+    for (size_t i = begin; i < end; i++)
+      out[i] = in[i] * (float_t)masks[i] * scale;
   }
-  #pragma omp parallel for
-  for (size_t i = 0; i < n*m; i++)
-    out[i] = in[i] * (float_t)masks[i] * scale;
   double t2 = omp_get_wtime();
   time_ops[OP_DROPOUT] += t2 - t1;
 }